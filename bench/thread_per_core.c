@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+/* Measures how task throughput scales with the number of loops, once with
+ * loops that share the context's task counter and once in shared-nothing
+ * mode. Every loop reposts one task to itself `tasks` times.
+ *
+ * usage: bench_thread_per_core [max_loops] [tasks_per_loop]
+ *
+ * Loop i is pinned to CPU i if that CPU exists and pinning is supported.
+ * With linear scaling, the per-loop rate stays flat as the loop count grows.
+ */
+
+#define _GNU_SOURCE
+
+#include <io.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct BenchTask {
+    io_Task base;
+    io_Loop* loop;
+    size_t remaining;
+} BenchTask;
+
+static void
+BenchTask_fn(void* self)
+{
+    BenchTask* task = self;
+    if (--task->remaining > 0) {
+        io_Loop_push_task(task->loop, &task->base);
+    }
+}
+
+static size_t num_cpus;
+
+static double
+run(size_t num_loops, size_t tasks, bool shared_nothing)
+{
+    io_Context context;
+    if (io_Context_init(&context, NULL) != IO_ERR_OK) {
+        fprintf(stderr, "Failed to init context\n");
+        exit(1);
+    }
+    io_ThreadOptions* options = calloc(num_loops, sizeof(io_ThreadOptions));
+    for (size_t i = 1; i < num_loops; ++i) {
+        options[i - 1].pin = i < num_cpus;
+        options[i - 1].cpu = (unsigned)i;
+    }
+    io_Err err = IO_ERR_OK;
+    if (shared_nothing) {
+        err = io_Context_set_shared_nothing(&context, num_loops - 1, options, NULL);
+    } else {
+        err = io_Context_set_num_threads_with_options(&context, num_loops - 1, options);
+    }
+    if (err) {
+        fprintf(stderr, "Failed to start loops: %s\n", io_Err_msg(err));
+        exit(1);
+    }
+    BenchTask* bench_tasks = calloc(num_loops, sizeof(BenchTask));
+    for (size_t i = 0; i < num_loops; ++i) {
+        bench_tasks[i].base.fn = BenchTask_fn;
+        bench_tasks[i].loop = io_Context_loop_at(&context, i);
+        bench_tasks[i].remaining = tasks;
+        io_Loop_push_task(bench_tasks[i].loop, &bench_tasks[i].base);
+    }
+    uint64_t start = io_monotonic_ns();
+    io_Context_run(&context);
+    // Wait for the other loops as well
+    io_ThreadVec_clear(&context.threads);
+    uint64_t elapsed = io_monotonic_ns() - start;
+    io_Context_deinit(&context);
+    free(bench_tasks);
+    free(options);
+    return (double)(num_loops * tasks) * 1e3 / (double)elapsed; // Million tasks per second
+}
+
+/* Prints one row and returns the shared-nothing rate per loop */
+static double
+report(size_t num_loops, size_t tasks, double base)
+{
+    double shared = run(num_loops, tasks, false);
+    double local = run(num_loops, tasks, true) / (double)num_loops;
+    if (base == 0) {
+        base = local;
+    }
+    printf("%6zu %14.2f %14.2f %14.2f %10.0f%%\n", num_loops, shared, local * (double)num_loops, local,
+           local / base * 100);
+    return local;
+}
+
+int main(int argc, char** argv)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_cpus = (size_t)(cpus > 0 ? cpus : 1);
+    size_t max_loops = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : num_cpus;
+    size_t tasks = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 1000000;
+    if (max_loops == 0 || tasks == 0) {
+        fprintf(stderr, "usage: %s [max_loops] [tasks_per_loop]\n", argv[0]);
+        return 1;
+    }
+    // The thread that runs the context hosts loop 0
+    io_ThreadOptions main_options = {.pin = true, .cpu = 0};
+    (void)io_Thread_setup_self(&main_options);
+    printf("%6s %14s %14s %14s %11s\n", "loops", "shared Mt/s", "local Mt/s", "local/loop", "efficiency");
+    (void)run(1, tasks, true); // Warm up
+    double base = 0;
+    for (size_t num_loops = 1; num_loops <= max_loops; num_loops *= 2) {
+        double rate = report(num_loops, tasks, base);
+        if (base == 0) {
+            base = rate;
+        }
+        if (num_loops < max_loops && num_loops * 2 > max_loops) {
+            report(max_loops, tasks, base);
+        }
+    }
+    return 0;
+}
@@ -12,11 +12,13 @@
 #include <io/assert.h>
 #include <io/context.h>
 #include <io/descriptor.h>
+#include <io/multishot.h>
 #include <io/system_call.h>
 #include <io/system_err.h>
 #include <io/task.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include <sys/socket.h>
 
@@ -24,43 +26,70 @@ typedef void (*io_AcceptCallback)(void* user_data, io_Err err);
 
 typedef struct io_AcceptOp {
     io_Op base;
+    io_Allocator* allocator;
     io_Descriptor* acceptor;
     io_Descriptor* socket;
+    io_Loop* loop;
+    const io_SocketOptions* options;
     io_AcceptCallback callback;
     void* user_data;
     io_Err err;
 } io_AcceptOp;
 
+/** io_perform_accept_fd
+ * @brief Accepts a single pending connection on `acceptor`.
+ * The new fd is close-on-exec and inherits the acceptor's cached
+ * non-blocking mode, all in a single accept4 call. `options`, if
+ * not NULL, are applied to the new fd.
+ */
 IO_INLINE(io_Err)
-io_perform_accept(const io_Descriptor* acceptor, io_Descriptor* socket)
+io_perform_accept_fd(const io_Descriptor* acceptor, const io_SocketOptions* options, int* fd)
 {
-    int accept_fd = io_Descriptor_get_fd(acceptor);
-    int ret = io_accept(accept_fd, NULL, NULL);
+    int flags = IO_SOCK_CLOEXEC;
+    if (acceptor->non_blocking) {
+        flags |= IO_SOCK_NONBLOCK;
+    }
+    int ret = io_accept4(io_Descriptor_get_fd(acceptor), NULL, NULL, flags);
     if (ret == -1) {
         return io_SystemErr(errno);
     }
-    io_Descriptor_set_fd(socket, ret);
-    // if the accept socket was non block, we gonna set
-    // the new socket to non block as well
-    bool non_blocking = false;
-    io_Err err = io_Descriptor_get_non_blocking(acceptor, &non_blocking);
-    if (err)
-        goto on_error;
-    if (non_blocking) {
-        err = io_Descriptor_set_non_blocking(socket, true);
-        if (err)
-            goto on_error;
+    if (options && !io_SocketOptions_empty(options)) {
+        io_Err err = io_SocketOptions_apply(options, ret);
+        if (err) {
+            io_close(ret);
+            return err;
+        }
+    }
+    *fd = ret;
+    return IO_ERR_OK;
+}
+
+/** io_perform_accept
+ * @brief Accepts a connection into `socket`, registered on `loop`
+ * or, if `loop` is NULL, on the next loop of the context.
+ * `options` may be NULL.
+ */
+IO_INLINE(io_Err)
+io_perform_accept(const io_Descriptor* acceptor, io_Descriptor* socket, io_Loop* loop, const io_SocketOptions* options)
+{
+    int fd = -1;
+    io_Err err = io_perform_accept_fd(acceptor, options, &fd);
+    if (err) {
+        return err;
+    }
+    if (loop) {
+        io_Descriptor_set_fd_on_loop(socket, loop, fd);
+    } else {
+        io_Descriptor_set_fd(socket, fd);
     }
+    socket->non_blocking = acceptor->non_blocking;
     return IO_ERR_OK;
-on_error:
-    io_Descriptor_close(socket);
-    return err;
 }
 
 IO_INLINE(void)
 io_AcceptOp_finalize(io_AcceptOp* op)
 {
-    io_Allocator* allocator = io_Descriptor_get_context(op->acceptor)->allocator;
+    io_Allocator* allocator = op->allocator;
     op->callback(op->user_data, op->err);
     io_Allocator_free(allocator, op);
 }
@@ -70,13 +99,13 @@ io_AcceptOp_complete(io_AcceptOp* op, io_Err err)
 {
     op->err = err;
     io_Op_set_flags(&op->base, IO_OP_COMPLETED);
-    io_Context_post(io_Descriptor_get_context(op->acceptor), &op->base.base);
+    io_Context_post_completion(io_Descriptor_get_context(op->acceptor), &op->base.base);
 }
 
 IO_INLINE(void)
 io_AcceptOp_perform(io_AcceptOp* op)
 {
-    io_Err err = io_perform_accept(op->acceptor, op->socket);
+    io_Err err = io_perform_accept(op->acceptor, op->socket, op->loop, op->options);
     if (err
         && (io_Op_flags(&op->base) & IO_OP_TRYIO)
         && (err == io_SystemErr(IO_EAGAIN)
@@ -105,17 +134,299 @@ io_AcceptOp_abort(void* self, io_Err err)
 }
 
 IO_INLINE(io_AcceptOp*)
-io_AcceptOp_create(io_Descriptor* acceptor, io_Descriptor* socket, io_AcceptCallback callback, void* user_data)
+io_AcceptOp_create(io_Descriptor* acceptor, io_Descriptor* socket, io_Loop* loop, const io_SocketOptions* options, io_AcceptCallback callback, void* user_data)
 {
-    io_AcceptOp* op = io_Allocator_alloc(io_Descriptor_get_context(acceptor)->allocator, sizeof(io_AcceptOp));
+    io_Allocator* allocator = io_Descriptor_allocator(acceptor);
+    io_AcceptOp* op = io_Allocator_alloc(allocator, sizeof(io_AcceptOp));
     if (!op) {
         return NULL;
     }
     io_Op_init(&op->base, IO_OP_READ, io_AcceptOp_fn, io_AcceptOp_abort);
+    op->allocator = allocator;
+    io_Op_set_flags(&op->base, IO_OP_ACCEPT);
     op->acceptor = acceptor;
     op->socket = socket;
+    op->loop = loop;
+    op->options = options;
+    op->callback = callback;
+    op->user_data = user_data;
+    return op;
+}
+
+typedef void (*io_AcceptBatchCallback)(void* user_data, const int* fds, size_t count, io_Err err);
+typedef void (*io_AcceptEachCallback)(void* user_data, int fd);
+
+/** io_AcceptBatchOp
+ * @brief Drains up to `max` pending connections per readiness event.
+ * The accepted fds are handed to the user either all at once through
+ * a batch callback or one by one through an each callback, followed
+ * by the batch callback with a NULL fd array. Ownership of the fds
+ * passes to the callee. `err` reports why draining stopped early;
+ * fds accepted before the error are still delivered.
+ */
+typedef struct io_AcceptBatchOp {
+    io_Op base;
+    io_Allocator* allocator;
+    io_Descriptor* acceptor;
+    const io_SocketOptions* options;
+    io_AcceptBatchCallback callback;
+    io_AcceptEachCallback each;
+    void* user_data;
+    io_Err err;
+    size_t max;
+    size_t count;
+    int fds[];
+} io_AcceptBatchOp;
+
+/** io_AcceptBatchOp_destroy
+ * @brief Frees an op that was never submitted, or whose submit failed.
+ */
+IO_INLINE(void)
+io_AcceptBatchOp_destroy(io_AcceptBatchOp* op)
+{
+    io_Allocator_free(op->allocator, op);
+}
+
+IO_INLINE(void)
+io_AcceptBatchOp_finalize(io_AcceptBatchOp* op)
+{
+    io_Allocator* allocator = op->allocator;
+    if (op->each) {
+        for (size_t i = 0; i < op->count; ++i) {
+            op->each(op->user_data, op->fds[i]);
+        }
+        if (op->callback) {
+            op->callback(op->user_data, NULL, op->count, op->err);
+        }
+    } else {
+        op->callback(op->user_data, op->fds, op->count, op->err);
+    }
+    io_Allocator_free(allocator, op);
+}
+
+IO_INLINE(void)
+io_AcceptBatchOp_complete(io_AcceptBatchOp* op, io_Err err)
+{
+    op->err = err;
+    io_Op_set_flags(&op->base, IO_OP_COMPLETED);
+    io_Context_post_completion(io_Descriptor_get_context(op->acceptor), &op->base.base);
+}
+
+IO_INLINE(void)
+io_AcceptBatchOp_perform(io_AcceptBatchOp* op)
+{
+    io_Err err = IO_ERR_OK;
+    while (op->count < op->max) {
+        err = io_perform_accept_fd(op->acceptor, op->options, &op->fds[op->count]);
+        if (err) {
+            break;
+        }
+        op->count++;
+    }
+    bool would_block = err == io_SystemErr(IO_EAGAIN) || err == io_SystemErr(IO_EWOULDBLOCK);
+    if (would_block && op->count > 0) {
+        // The backlog is drained, that's the expected way to stop
+        err = IO_ERR_OK;
+    } else if (would_block && (io_Op_flags(&op->base) & IO_OP_TRYIO)) {
+        return;
+    }
+    io_AcceptBatchOp_complete(op, err);
+}
+
+IO_INLINE(void)
+io_AcceptBatchOp_fn(void* self)
+{
+    io_AcceptBatchOp* op = self;
+    if (io_Op_flags(&op->base) & IO_OP_COMPLETED) {
+        io_AcceptBatchOp_finalize(op);
+    } else {
+        io_AcceptBatchOp_perform(op);
+    }
+}
+
+IO_INLINE(void)
+io_AcceptBatchOp_abort(void* self, io_Err err)
+{
+    io_AcceptBatchOp* op = self;
+    io_AcceptBatchOp_complete(op, err);
+}
+
+IO_INLINE(io_AcceptBatchOp*)
+io_AcceptBatchOp_create(io_Descriptor* acceptor, const io_SocketOptions* options, size_t max, io_AcceptBatchCallback callback, io_AcceptEachCallback each, void* user_data)
+{
+    IO_ASSERT(max > 0, "max must be at least 1");
+    io_Allocator* allocator = io_Descriptor_allocator(acceptor);
+    io_AcceptBatchOp* op = io_Allocator_alloc(allocator, sizeof(io_AcceptBatchOp) + max * sizeof(int));
+    if (!op) {
+        return NULL;
+    }
+    io_Op_init(&op->base, IO_OP_READ, io_AcceptBatchOp_fn, io_AcceptBatchOp_abort);
+    op->allocator = allocator;
+    io_Op_set_flags(&op->base, IO_OP_ACCEPT);
+    op->acceptor = acceptor;
+    op->options = options;
+    op->callback = callback;
+    op->each = each;
+    op->user_data = user_data;
+    op->err = IO_ERR_OK;
+    op->max = max;
+    op->count = 0;
+    return op;
+}
+
+/** io_MultiAcceptOp
+ * @brief Multishot accept, stays armed and drains up to `max` connections
+ * on every readiness event until it's cancelled. Each batch is delivered
+ * to the callback, the final call has no fds and carries the error that
+ * ended the op (IO_ECANCELED after a cancel). With a worker pool the loop
+ * accepts and a worker delivers, like io_MultiReadOp.
+ */
+typedef struct io_MultiAcceptOp {
+    io_Op base;
+    io_Allocator* allocator;
+    io_Descriptor* acceptor;
+    const io_SocketOptions* options;
+    io_AcceptBatchCallback callback;
+    void* user_data;
+    io_Err err;
+    size_t max;
+    size_t count;   // Accepted fds handed to a worker with the op
+    bool on_worker; // The next run delivers on a worker
+    bool done;      // Disarmed or aborted, only the final call is left
+    int fds[];
+} io_MultiAcceptOp;
+
+IO_INLINE(void)
+io_MultiAcceptOp_finalize(io_MultiAcceptOp* op)
+{
+    io_Allocator* allocator = op->allocator;
+    op->callback(op->user_data, NULL, 0, op->err);
+    io_Allocator_free(allocator, op);
+}
+
+/** io_MultiAcceptOp_hand_over
+ * @brief Lets a worker run the callbacks, the op stays IO_OP_QUEUED meanwhile.
+ */
+IO_INLINE(void)
+io_MultiAcceptOp_hand_over(io_MultiAcceptOp* op)
+{
+    op->on_worker = true;
+    io_Context_post_completion(io_Descriptor_get_context(op->acceptor), &op->base.base);
+}
+
+IO_INLINE(void)
+io_MultiAcceptOp_complete(io_MultiAcceptOp* op)
+{
+    op->done = true;
+    if (io_Context_completes_inline(io_Descriptor_get_context(op->acceptor))) {
+        io_MultiAcceptOp_finalize(op);
+    } else {
+        io_MultiAcceptOp_hand_over(op);
+    }
+}
+
+/** io_MultiAcceptOp_deliver
+ * @brief The worker's part of a run.
+ */
+IO_INLINE(void)
+io_MultiAcceptOp_deliver(io_MultiAcceptOp* op)
+{
+    op->on_worker = false;
+    size_t count = op->count;
+    op->count = 0;
+    if (count > 0) {
+        op->callback(op->user_data, op->fds, count, IO_ERR_OK);
+    }
+    if (op->done || io_Multishot_end(&op->base)) {
+        io_MultiAcceptOp_finalize(op);
+    }
+}
+
+/** io_MultiAcceptOp_perform
+ * @brief Accepts a batch on a readiness event.
+ * @return true if the run is over: the op is freed or handed to a worker.
+ */
+IO_INLINE(bool)
+io_MultiAcceptOp_perform(io_MultiAcceptOp* op)
+{
+    size_t count = 0;
+    io_Err err = IO_ERR_OK;
+    while (count < op->max) {
+        err = io_perform_accept_fd(op->acceptor, op->options, &op->fds[count]);
+        if (err == io_SystemErr(ECONNABORTED) || err == io_SystemErr(EINTR)) {
+            continue;
+        }
+        if (err) {
+            break;
+        }
+        count++;
+    }
+    if (err && err != io_SystemErr(IO_EAGAIN) && err != io_SystemErr(IO_EWOULDBLOCK)
+        && io_Multishot_disarm(&op->base, op->acceptor->handle)) {
+        op->err = err;
+        op->done = true;
+    }
+    if (count > 0 && !io_Context_completes_inline(io_Descriptor_get_context(op->acceptor))) {
+        op->count = count;
+        io_MultiAcceptOp_hand_over(op);
+        return true;
+    }
+    if (count > 0) {
+        op->callback(op->user_data, op->fds, count, IO_ERR_OK);
+    }
+    if (op->done) {
+        io_MultiAcceptOp_complete(op);
+        return true;
+    }
+    return false;
+}
+
+IO_INLINE(void)
+io_MultiAcceptOp_fn(void* self)
+{
+    io_MultiAcceptOp* op = self;
+    if (io_Op_flags(&op->base) & IO_OP_TRYIO) {
+        // Readiness arrives through the reactor
+        return;
+    }
+    if (op->on_worker) {
+        io_MultiAcceptOp_deliver(op);
+    } else if (io_Multishot_begin(&op->base)) {
+        io_MultiAcceptOp_complete(op);
+    } else if (!io_MultiAcceptOp_perform(op) && io_Multishot_end(&op->base)) {
+        io_MultiAcceptOp_complete(op);
+    }
+}
+
+IO_INLINE(void)
+io_MultiAcceptOp_abort(void* self, io_Err err)
+{
+    io_MultiAcceptOp* op = self;
+    op->err = err;
+    io_Multishot_abort(&op->base, io_Descriptor_get_loop(op->acceptor));
+}
+
+IO_INLINE(io_MultiAcceptOp*)
+io_MultiAcceptOp_create(io_Descriptor* acceptor, const io_SocketOptions* options, size_t max, io_AcceptBatchCallback callback, void* user_data)
+{
+    IO_ASSERT(max > 0, "max must be at least 1");
+    io_Allocator* allocator = io_Descriptor_allocator(acceptor);
+    io_MultiAcceptOp* op = io_Allocator_alloc(allocator, sizeof(io_MultiAcceptOp) + max * sizeof(int));
+    if (!op) {
+        return NULL;
+    }
+    io_Op_init(&op->base, IO_OP_READ, io_MultiAcceptOp_fn, io_MultiAcceptOp_abort);
+    op->allocator = allocator;
+    io_Op_set_flags(&op->base, IO_OP_MULTISHOT | IO_OP_ACCEPT);
+    op->acceptor = acceptor;
+    op->options = options;
     op->callback = callback;
     op->user_data = user_data;
+    op->err = IO_ERR_OK;
+    op->max = max;
+    op->count = 0;
+    op->on_worker = false;
+    op->done = false;
     return op;
 }
 
@@ -17,6 +17,8 @@
 
 typedef struct io_Acceptor {
     io_Descriptor base;
+    io_SocketOptions accept_options; // Applied to every accepted socket
+    bool keep_on_loop;               // Accepted sockets stay on the acceptor's loop
 } io_Acceptor;
 
 DEFINE_DESCRIPTOR_WRAPPERS(io_Acceptor, io_Descriptor)
@@ -25,23 +27,146 @@ IO_INLINE(void)
 io_Acceptor_init(io_Acceptor* acceptor, io_Context* ctx)
 {
     io_Descriptor_init(&acceptor->base, ctx);
+    io_SocketOptions_init(&acceptor->accept_options);
+    acceptor->keep_on_loop = false;
+}
+
+/** io_Acceptor_set_options
+ * @brief Applies the options to the listening socket itself.
+ */
+IO_INLINE(io_Err)
+io_Acceptor_set_options(io_Acceptor* acceptor, const io_SocketOptions* options)
+{
+    return io_Descriptor_set_options(&acceptor->base, options);
+}
+
+/** io_Acceptor_set_accept_options
+ * @brief Sets the defaults every accepted socket is configured with.
+ */
+IO_INLINE(void)
+io_Acceptor_set_accept_options(io_Acceptor* acceptor, const io_SocketOptions* options)
+{
+    acceptor->accept_options = *options;
+}
+
+/** io_Acceptor_accept_loop
+ * @brief The loop accepted sockets are placed on, NULL
+ * if they are spread over the context's loops.
+ */
+IO_INLINE(io_Loop*)
+io_Acceptor_accept_loop(const io_Acceptor* acceptor)
+{
+    return acceptor->keep_on_loop ? acceptor->base.loop : NULL;
+}
+
+IO_INLINE(io_Err)
+io_Acceptor_async_accept_with_token(io_Acceptor* acceptor, io_Socket* socket, io_AcceptCallback callback, void* user_data, io_OpToken* token)
+{
+    if (io_Context_draining(io_Descriptor_get_context(&acceptor->base))) {
+        return io_SystemErr(IO_ECANCELED);
+    }
+    io_AcceptOp* op = io_AcceptOp_create(&acceptor->base, &socket->base, io_Acceptor_accept_loop(acceptor), &acceptor->accept_options, callback, user_data);
+    if (!op) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    io_Descriptor_submit(&acceptor->base, &op->base, token);
+    return IO_ERR_OK;
 }
 
 IO_INLINE(io_Err)
 io_Acceptor_async_accept(io_Acceptor* acceptor, io_Socket* socket, io_AcceptCallback callback, void* user_data)
 {
-    io_AcceptOp* op = io_AcceptOp_create(&acceptor->base, &socket->base, callback, user_data);
+    return io_Acceptor_async_accept_with_token(acceptor, socket, callback, user_data, NULL);
+}
+
+/** io_Acceptor_submit_batch
+ * @brief Submits a batch op, the op is freed if the submit fails.
+ */
+IO_INLINE(io_Err)
+io_Acceptor_submit_batch(io_Acceptor* acceptor, io_AcceptBatchOp* op, io_OpToken* token)
+{
+    io_Err err = acceptor->base.handle ? io_Descriptor_submit(&acceptor->base, &op->base, token) : io_SystemErr(IO_EBADF);
+    if (err) {
+        io_AcceptBatchOp_destroy(op);
+    }
+    return err;
+}
+
+/** io_Acceptor_async_accept_batch
+ * @brief Accepts up to `max` connections on the next readiness event
+ * and delivers the fds to `callback` in one call.
+ */
+IO_INLINE(io_Err)
+io_Acceptor_async_accept_batch_with_token(io_Acceptor* acceptor, size_t max, io_AcceptBatchCallback callback, void* user_data, io_OpToken* token)
+{
+    if (io_Context_draining(io_Descriptor_get_context(&acceptor->base))) {
+        return io_SystemErr(IO_ECANCELED);
+    }
+    io_AcceptBatchOp* op = io_AcceptBatchOp_create(&acceptor->base, &acceptor->accept_options, max, callback, NULL, user_data);
     if (!op) {
         return io_SystemErr(IO_ENOMEM);
     }
-    io_Handle_submit(acceptor->base.handle, &op->base);
+    return io_Acceptor_submit_batch(acceptor, op, token);
+}
+
+IO_INLINE(io_Err)
+io_Acceptor_async_accept_batch(io_Acceptor* acceptor, size_t max, io_AcceptBatchCallback callback, void* user_data)
+{
+    return io_Acceptor_async_accept_batch_with_token(acceptor, max, callback, user_data, NULL);
+}
+
+/** io_Acceptor_async_accept_each
+ * @brief Like io_Acceptor_async_accept_batch, but calls `each` for every
+ * accepted fd. `done` is optional and receives the count and the error.
+ */
+IO_INLINE(io_Err)
+io_Acceptor_async_accept_each_with_token(io_Acceptor* acceptor, size_t max, io_AcceptEachCallback each, io_AcceptBatchCallback done, void* user_data, io_OpToken* token)
+{
+    if (io_Context_draining(io_Descriptor_get_context(&acceptor->base))) {
+        return io_SystemErr(IO_ECANCELED);
+    }
+    io_AcceptBatchOp* op = io_AcceptBatchOp_create(&acceptor->base, &acceptor->accept_options, max, done, each, user_data);
+    if (!op) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    return io_Acceptor_submit_batch(acceptor, op, token);
+}
+
+IO_INLINE(io_Err)
+io_Acceptor_async_accept_each(io_Acceptor* acceptor, size_t max, io_AcceptEachCallback each, io_AcceptBatchCallback done, void* user_data)
+{
+    return io_Acceptor_async_accept_each_with_token(acceptor, max, each, done, user_data, NULL);
+}
+
+/** io_Acceptor_async_accept_multishot
+ * @brief Keeps accepting, up to `max` connections per readiness event,
+ * until the acceptor is cancelled, see io_MultiAcceptOp.
+ * Cancel the acceptor before closing it.
+ */
+IO_INLINE(io_Err)
+io_Acceptor_async_accept_multishot_with_token(io_Acceptor* acceptor, size_t max, io_AcceptBatchCallback callback, void* user_data, io_OpToken* token)
+{
+    if (io_Context_draining(io_Descriptor_get_context(&acceptor->base))) {
+        return io_SystemErr(IO_ECANCELED);
+    }
+    io_MultiAcceptOp* op = io_MultiAcceptOp_create(&acceptor->base, &acceptor->accept_options, max, callback, user_data);
+    if (!op) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    io_Descriptor_submit(&acceptor->base, &op->base, token);
     return IO_ERR_OK;
 }
 
+IO_INLINE(io_Err)
+io_Acceptor_async_accept_multishot(io_Acceptor* acceptor, size_t max, io_AcceptBatchCallback callback, void* user_data)
+{
+    return io_Acceptor_async_accept_multishot_with_token(acceptor, max, callback, user_data, NULL);
+}
+
 IO_INLINE(io_Err)
 io_Acceptor_accept(io_Acceptor* acceptor, io_Socket* socket)
 {
-    return io_perform_accept(&acceptor->base, &socket->base);
+    return io_perform_accept(&acceptor->base, &socket->base, io_Acceptor_accept_loop(acceptor), &acceptor->accept_options);
 }
 
 IO_INLINE(void)
@@ -58,9 +183,65 @@ io_Acceptor_deinit(io_Acceptor* acceptor)
     }                                                                                         \
                                                                                               \
     IO_INLINE(io_Err)                                                                         \
+    A##_async_accept_with_token(A* acceptor, S* socket, io_AcceptCallback callback,           \
+                                void* user_data, io_OpToken* token)                           \
+    {                                                                                         \
+        return io_Acceptor_async_accept_with_token(&acceptor->base, &socket->base, callback,  \
+                                                   user_data, token);                         \
+    }                                                                                         \
+                                                                                              \
+    IO_INLINE(io_Err)                                                                         \
     A##_accept(A* acceptor, S* socket)                                                        \
     {                                                                                         \
         return io_Acceptor_accept(&acceptor->base, &socket->base);                            \
+    }                                                                                         \
+                                                                                              \
+    IO_INLINE(io_Err)                                                                         \
+    A##_async_accept_batch(A* acceptor, size_t max, io_AcceptBatchCallback callback,          \
+                           void* user_data)                                                   \
+    {                                                                                         \
+        return io_Acceptor_async_accept_batch(&acceptor->base, max, callback, user_data);     \
+    }                                                                                         \
+                                                                                              \
+    IO_INLINE(io_Err)                                                                         \
+    A##_async_accept_batch_with_token(A* acceptor, size_t max,                                \
+                                      io_AcceptBatchCallback callback,                        \
+                                      void* user_data, io_OpToken* token)                     \
+    {                                                                                         \
+        return io_Acceptor_async_accept_batch_with_token(&acceptor->base, max, callback,      \
+                                                         user_data, token);                   \
+    }                                                                                         \
+                                                                                              \
+    IO_INLINE(io_Err)                                                                         \
+    A##_async_accept_multishot(A* acceptor, size_t max, io_AcceptBatchCallback callback,      \
+                               void* user_data)                                               \
+    {                                                                                         \
+        return io_Acceptor_async_accept_multishot(&acceptor->base, max, callback, user_data); \
+    }                                                                                         \
+                                                                                              \
+    IO_INLINE(io_Err)                                                                         \
+    A##_async_accept_multishot_with_token(A* acceptor, size_t max,                            \
+                                          io_AcceptBatchCallback callback,                    \
+                                          void* user_data, io_OpToken* token)                 \
+    {                                                                                         \
+        return io_Acceptor_async_accept_multishot_with_token(&acceptor->base, max, callback,  \
+                                                             user_data, token);               \
+    }                                                                                         \
+                                                                                              \
+    IO_INLINE(io_Err)                                                                         \
+    A##_async_accept_each(A* acceptor, size_t max, io_AcceptEachCallback each,                \
+                          io_AcceptBatchCallback done, void* user_data)                       \
+    {                                                                                         \
+        return io_Acceptor_async_accept_each(&acceptor->base, max, each, done, user_data);    \
+    }                                                                                         \
+                                                                                              \
+    IO_INLINE(io_Err)                                                                         \
+    A##_async_accept_each_with_token(A* acceptor, size_t max, io_AcceptEachCallback each,     \
+                                     io_AcceptBatchCallback done, void* user_data,            \
+                                     io_OpToken* token)                                       \
+    {                                                                                         \
+        return io_Acceptor_async_accept_each_with_token(&acceptor->base, max, each, done,     \
+                                                        user_data, token);                    \
     }
 
 #endif
@@ -14,6 +14,10 @@
 #define IO_ALIGNUP(n, align) (((n) + (align) - 1) & ~((align) - 1))
 #define IO_ALIGNDOWN(n, align) ((n) & ~((align) - 1))
 
+#ifndef IO_CACHE_LINE_SIZE
+#define IO_CACHE_LINE_SIZE ((size_t)64)
+#endif
+
 typedef long double io_max_align;
 
 #endif
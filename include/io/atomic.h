@@ -7,9 +7,53 @@
 #ifndef IO_ATOMIC_H
 #define IO_ATOMIC_H
 
-#define io_atomic_inc(ptr) __sync_add_and_fetch(ptr, 1)
-#define io_atomic_dec(ptr) __sync_sub_and_fetch(ptr, 1)
-#define io_atomic_load(ptr) __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
-#define io_atomic_store(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST)
-#define io_atomic_fetch_add(ptr, value) __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST)
+/* Memory orders of the C11 memory model. The operations work on plain
+ * objects, so they map to the __atomic builtins, which implement that model
+ * for GCC and Clang. C11 <stdatomic.h> would need _Atomic types throughout.
+ */
+#if defined(__ATOMIC_RELAXED)
+#define IO_RELAXED __ATOMIC_RELAXED
+#define IO_ACQUIRE __ATOMIC_ACQUIRE
+#define IO_RELEASE __ATOMIC_RELEASE
+#define IO_ACQ_REL __ATOMIC_ACQ_REL
+#define IO_SEQ_CST __ATOMIC_SEQ_CST
+#else
+#error "c-io needs the __atomic builtins of GCC or Clang"
+#endif
+
+/* Read-modify-write operations with an acquire order only make sense as
+ * acq_rel or seq_cst, loads take relaxed, acquire or seq_cst and stores
+ * relaxed, release or seq_cst. Use IO_SEQ_CST where a store must be seen
+ * before a later load of another object (store-load ordering).
+ */
+#define io_atomic_load_explicit(ptr, order) __atomic_load_n(ptr, order)
+#define io_atomic_store_explicit(ptr, value, order) __atomic_store_n(ptr, value, order)
+#define io_atomic_inc_explicit(ptr, order) __atomic_add_fetch(ptr, 1, order)
+#define io_atomic_dec_explicit(ptr, order) __atomic_sub_fetch(ptr, 1, order)
+#define io_atomic_fetch_add_explicit(ptr, value, order) __atomic_fetch_add(ptr, value, order)
+#define io_atomic_fetch_or_explicit(ptr, value, order) __atomic_fetch_or(ptr, value, order)
+#define io_atomic_fetch_and_explicit(ptr, value, order) __atomic_fetch_and(ptr, value, order)
+#define io_atomic_exchange_explicit(ptr, value, order) __atomic_exchange_n(ptr, value, order)
+#define io_atomic_compare_exchange_explicit(ptr, expected, desired, success, failure) \
+    __atomic_compare_exchange_n(ptr, expected, desired, false, success, failure)
+#define io_atomic_thread_fence(order) __atomic_thread_fence(order)
+
+/* Sequentially consistent shorthands */
+#define io_atomic_inc(ptr) io_atomic_inc_explicit(ptr, IO_SEQ_CST)
+#define io_atomic_dec(ptr) io_atomic_dec_explicit(ptr, IO_SEQ_CST)
+#define io_atomic_load(ptr) io_atomic_load_explicit(ptr, IO_SEQ_CST)
+#define io_atomic_store(ptr, value) io_atomic_store_explicit(ptr, value, IO_SEQ_CST)
+#define io_atomic_fetch_add(ptr, value) io_atomic_fetch_add_explicit(ptr, value, IO_SEQ_CST)
+#define io_atomic_fetch_or(ptr, value) io_atomic_fetch_or_explicit(ptr, value, IO_SEQ_CST)
+#define io_atomic_fetch_and(ptr, value) io_atomic_fetch_and_explicit(ptr, value, IO_SEQ_CST)
+#define io_atomic_exchange(ptr, value) io_atomic_exchange_explicit(ptr, value, IO_SEQ_CST)
+#define io_atomic_compare_exchange(ptr, expected, desired) \
+    io_atomic_compare_exchange_explicit(ptr, expected, desired, IO_SEQ_CST, IO_SEQ_CST)
+
+/* Atomic with `order` only if `shared`, for counters of objects that may be confined to one thread */
+#define io_atomic_inc_if(shared, ptr, order) ((shared) ? io_atomic_inc_explicit(ptr, order) : ++*(ptr))
+#define io_atomic_dec_if(shared, ptr, order) ((shared) ? io_atomic_dec_explicit(ptr, order) : --*(ptr))
+#define io_atomic_load_if(shared, ptr, order) ((shared) ? io_atomic_load_explicit(ptr, order) : *(ptr))
+#define io_atomic_store_if(shared, ptr, value, order) \
+    ((shared) ? io_atomic_store_explicit(ptr, value, order) : (void)(*(ptr) = (value)))
 #endif
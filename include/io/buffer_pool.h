@@ -0,0 +1,239 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_BUFFER_POOL_H
+#define IO_BUFFER_POOL_H
+
+#include <io/config.h>
+
+#include <io/allocator.h>
+#include <io/assert.h>
+#include <io/atomic.h>
+#include <io/err.h>
+#include <io/thread.h>
+
+#include <stddef.h>
+
+#define IO_BUFFER_POOL_DEFAULT_SIZE (16 * 1024)
+#define IO_BUFFER_POOL_DEFAULT_MAX_IDLE 64
+
+struct io_BufferPool;
+
+/** io_Buffer
+ * @brief A reference counted buffer, usually handed out by an io_BufferPool.
+ * The buffer returns to its pool once the last reference is released,
+ * this may happen on any thread. Buffers made by io_Buffer_create
+ * have no pool and are freed instead.
+ */
+typedef struct io_Buffer {
+    struct io_BufferPool* pool;
+    io_Allocator* allocator;
+    struct io_Buffer* next;
+    size_t refcount;
+    size_t size;
+    size_t capacity;
+} io_Buffer;
+
+IO_INLINE(void*)
+io_Buffer_data(io_Buffer* buffer)
+{
+    return buffer + 1;
+}
+
+IO_INLINE(size_t)
+io_Buffer_size(const io_Buffer* buffer)
+{
+    return buffer->size;
+}
+
+IO_INLINE(size_t)
+io_Buffer_capacity(const io_Buffer* buffer)
+{
+    return buffer->capacity;
+}
+
+IO_INLINE(void)
+io_Buffer_retain(io_Buffer* buffer)
+{
+    io_atomic_inc(&buffer->refcount);
+}
+
+IO_INLINE(void)
+io_Buffer_release(io_Buffer* buffer);
+
+/** io_BufferPool
+ * @brief Pool of equally sized buffers. At most `max_idle` released buffers
+ * are kept for reuse, the rest are returned to the allocator so that memory
+ * follows the number of buffers in use. `max` bounds the buffers in use,
+ * 0 means unbounded.
+ */
+typedef struct io_BufferPool {
+    io_Allocator* allocator;
+    io_Buffer* idle;
+    io_Mutex mtx;
+    size_t buffer_size;
+    size_t max;
+    size_t max_idle;
+    size_t num_idle;
+    size_t num_used;
+} io_BufferPool;
+
+IO_INLINE(io_Err)
+io_BufferPool_init(io_BufferPool* pool, io_Allocator* allocator, size_t buffer_size, size_t max)
+{
+    IO_ASSERT(buffer_size > 0, "Buffer size must not be zero");
+    pool->allocator = allocator;
+    pool->idle = NULL;
+    pool->buffer_size = buffer_size;
+    pool->max = max;
+    pool->max_idle = IO_BUFFER_POOL_DEFAULT_MAX_IDLE;
+    pool->num_idle = 0;
+    pool->num_used = 0;
+    return io_Mutex_init(&pool->mtx);
+}
+
+IO_INLINE(void)
+io_BufferPool_trim(io_BufferPool* pool, size_t keep)
+{
+    io_Mutex_lock(&pool->mtx);
+    while (pool->num_idle > keep) {
+        io_Buffer* buffer = pool->idle;
+        pool->idle = buffer->next;
+        pool->num_idle--;
+        io_Allocator_free(pool->allocator, buffer);
+    }
+    io_Mutex_unlock(&pool->mtx);
+}
+
+IO_INLINE(void)
+io_BufferPool_deinit(io_BufferPool* pool)
+{
+    IO_ASSERT(pool->num_used == 0, "Buffers still in use");
+    io_BufferPool_trim(pool, 0);
+    io_Mutex_deinit(&pool->mtx);
+}
+
+/** io_BufferPool_configure
+ * @brief Changes the buffer size and the limits, idle buffers
+ * of the old size are dropped. Buffers in use keep their size.
+ */
+IO_INLINE(void)
+io_BufferPool_configure(io_BufferPool* pool, size_t buffer_size, size_t max, size_t max_idle)
+{
+    IO_ASSERT(buffer_size > 0, "Buffer size must not be zero");
+    io_BufferPool_trim(pool, 0);
+    io_Mutex_lock(&pool->mtx);
+    pool->buffer_size = buffer_size;
+    pool->max = max;
+    pool->max_idle = max_idle;
+    io_Mutex_unlock(&pool->mtx);
+}
+
+/** io_BufferPool_acquire
+ * @brief Takes a buffer with a single reference, NULL if the pool
+ * is exhausted or out of memory.
+ */
+IO_INLINE(io_Buffer*)
+io_BufferPool_acquire(io_BufferPool* pool)
+{
+    io_Mutex_lock(&pool->mtx);
+    if (pool->max && pool->num_used >= pool->max) {
+        io_Mutex_unlock(&pool->mtx);
+        return NULL;
+    }
+    io_Buffer* buffer = pool->idle;
+    size_t capacity = pool->buffer_size;
+    if (buffer) {
+        pool->idle = buffer->next;
+        pool->num_idle--;
+    }
+    pool->num_used++;
+    io_Mutex_unlock(&pool->mtx);
+    if (!buffer) {
+        buffer = io_Allocator_alloc(pool->allocator, sizeof(io_Buffer) + capacity);
+        if (!buffer) {
+            io_Mutex_lock(&pool->mtx);
+            pool->num_used--;
+            io_Mutex_unlock(&pool->mtx);
+            return NULL;
+        }
+        buffer->pool = pool;
+        buffer->allocator = pool->allocator;
+        buffer->capacity = capacity;
+    }
+    buffer->next = NULL;
+    buffer->refcount = 1;
+    buffer->size = 0;
+    return buffer;
+}
+
+IO_INLINE(void)
+io_BufferPool_put(io_BufferPool* pool, io_Buffer* buffer)
+{
+    io_Mutex_lock(&pool->mtx);
+    pool->num_used--;
+    if (pool->num_idle < pool->max_idle && buffer->capacity == pool->buffer_size) {
+        buffer->next = pool->idle;
+        pool->idle = buffer;
+        pool->num_idle++;
+        buffer = NULL;
+    }
+    io_Mutex_unlock(&pool->mtx);
+    if (buffer) {
+        io_Allocator_free(pool->allocator, buffer);
+    }
+}
+
+IO_INLINE(size_t)
+io_BufferPool_buffer_size(io_BufferPool* pool)
+{
+    io_Mutex_lock(&pool->mtx);
+    size_t size = pool->buffer_size;
+    io_Mutex_unlock(&pool->mtx);
+    return size;
+}
+
+IO_INLINE(size_t)
+io_BufferPool_num_used(io_BufferPool* pool)
+{
+    io_Mutex_lock(&pool->mtx);
+    size_t used = pool->num_used;
+    io_Mutex_unlock(&pool->mtx);
+    return used;
+}
+
+/** io_Buffer_create
+ * @brief Allocates a buffer of `capacity` bytes outside of any pool.
+ */
+IO_INLINE(io_Buffer*)
+io_Buffer_create(io_Allocator* allocator, size_t capacity)
+{
+    io_Buffer* buffer = io_Allocator_alloc(allocator, sizeof(io_Buffer) + capacity);
+    if (!buffer) {
+        return NULL;
+    }
+    buffer->pool = NULL;
+    buffer->allocator = allocator;
+    buffer->next = NULL;
+    buffer->refcount = 1;
+    buffer->size = 0;
+    buffer->capacity = capacity;
+    return buffer;
+}
+
+IO_INLINE(void)
+io_Buffer_release(io_Buffer* buffer)
+{
+    if (io_atomic_dec(&buffer->refcount) == 0) {
+        if (buffer->pool) {
+            io_BufferPool_put(buffer->pool, buffer);
+        } else {
+            io_Allocator_free(buffer->allocator, buffer);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,281 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_CHAIN_H
+#define IO_CHAIN_H
+
+#include <io/config.h>
+
+#include <io/descriptor.h>
+#include <io/read.h>
+#include <io/task.h>
+#include <io/vec.h>
+#include <io/write.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum io_ChainStepKind {
+    IO_CHAIN_READ,
+    IO_CHAIN_WRITE,
+    IO_CHAIN_WAIT,
+} io_ChainStepKind;
+
+typedef struct io_ChainStep {
+    io_ChainStepKind kind;
+    io_OpType type;
+    union {
+        void* read;
+        const void* write;
+    } addr;
+    size_t size;
+} io_ChainStep;
+
+IO_DEFINE_VEC(io_ChainStepVec, io_ChainStep, (void))
+
+/** io_OpChainCallback
+ * @brief Called once the chain ends. `completed` is the number of
+ * steps that ran to completion, `size` the bytes transferred by the
+ * last step that ran.
+ */
+typedef void (*io_OpChainCallback)(void* user_data, size_t completed, size_t size, io_Err err);
+
+/** io_OpChain
+ * @brief A sequence of read, write and readiness steps on one descriptor,
+ * similar to linked SQEs in io_uring. The steps run back-to-back on the
+ * descriptor's loop, the chain only goes back to the reactor when a step
+ * would block. The callback is called once, after the last step or after
+ * the first step that fails. A read that returns less than its size ends
+ * the chain as well, writes are retried until everything is written.
+ * While waiting, the chain occupies the handle slot of its current step.
+ */
+typedef struct io_OpChain {
+    io_Op base;
+    io_Allocator* allocator;
+    io_Descriptor* descriptor;
+    io_ChainStepVec steps;
+    io_OpChainCallback callback;
+    void* user_data;
+    size_t index;  // Current step
+    size_t offset; // Bytes of the current write step that are written
+    size_t size;   // Bytes transferred by the last step that ran
+    io_Err err;
+} io_OpChain;
+
+IO_INLINE(void)
+io_OpChain_destroy(io_OpChain* chain)
+{
+    io_Allocator* allocator = chain->allocator;
+    io_ChainStepVec_deinit(&chain->steps);
+    io_Allocator_free(allocator, chain);
+}
+
+IO_INLINE(void)
+io_OpChain_finalize(io_OpChain* chain)
+{
+    chain->callback(chain->user_data, chain->index, chain->size, chain->err);
+    io_OpChain_destroy(chain);
+}
+
+IO_INLINE(void)
+io_OpChain_finish(io_OpChain* chain, io_Err err)
+{
+    chain->err = err;
+    io_Context* context = io_Descriptor_get_context(chain->descriptor);
+    if ((io_Op_flags(&chain->base) & IO_OP_TRYIO) || !io_Context_completes_inline(context)) {
+        // Still on the submitting thread or the callback belongs on a worker
+        io_Op_set_flags(&chain->base, IO_OP_COMPLETED);
+        io_Context_post_completion(context, &chain->base.base);
+    } else {
+        io_OpChain_finalize(chain);
+    }
+}
+
+/** io_OpChain_block
+ * @brief Hands the chain back to the reactor until the descriptor is ready for `type`.
+ */
+IO_INLINE(void)
+io_OpChain_block(io_OpChain* chain, io_OpType type)
+{
+    chain->base.type = type;
+    if (io_Op_flags(&chain->base) & IO_OP_TRYIO) {
+        // The pending submit registers the chain once we return
+        return;
+    }
+    io_Descriptor* descriptor = chain->descriptor;
+    uint64_t seq = chain->base.seq;
+    if (io_Descriptor_cancelled(descriptor, seq)) {
+        // io_Op_cancel missed the chain while this step ran
+        io_OpChain_finish(chain, io_SystemErr(IO_ECANCELED));
+        return;
+    }
+    // Trying the step again on submit is futile and would count as a miss.
+    // Once submitted, another runner may run the chain, don't touch it anymore.
+    io_Op_set_flags(&chain->base, IO_OP_NOTRY);
+    io_Err err = io_Handle_submit(descriptor->handle, &chain->base);
+    if (err) {
+        // The chain was handed back
+        io_OpChain_finish(chain, err);
+    } else if (io_Descriptor_cancelled(descriptor, seq)) {
+        // The cancel came while we submitted, it may have searched the slots before
+        io_Handle_cancel_op(descriptor->handle, type, seq);
+    }
+}
+
+IO_INLINE(bool)
+io_OpChain_would_block(io_Err err)
+{
+    return err == io_SystemErr(IO_EAGAIN) || err == io_SystemErr(IO_EWOULDBLOCK);
+}
+
+IO_INLINE(void)
+io_OpChain_run(io_OpChain* chain, bool ready)
+{
+    while (chain->index < io_ChainStepVec_size(&chain->steps)) {
+        io_ChainStep* step = io_ChainStepVec_at(&chain->steps, chain->index);
+        io_Err err = IO_ERR_OK;
+        size_t size = 0;
+        switch (step->kind) {
+        case IO_CHAIN_READ:
+            size = step->size;
+            err = io_perform_read(chain->descriptor, step->addr.read, &size);
+            if (!err && size == 0 && step->size > 0) {
+                err = IO_ERR_EOF;
+            }
+            break;
+        case IO_CHAIN_WRITE:
+            size = step->size - chain->offset;
+            err = io_perform_write(chain->descriptor, (const char*)step->addr.write + chain->offset, &size);
+            if (!err) {
+                chain->offset += size;
+                size = chain->offset;
+            }
+            break;
+        case IO_CHAIN_WAIT:
+            if (!ready || chain->base.type != step->type) {
+                err = io_SystemErr(IO_EAGAIN);
+            }
+            break;
+        }
+        ready = false;
+        if (io_OpChain_would_block(err)) {
+            io_OpChain_block(chain, step->type);
+            return;
+        }
+        chain->size = size;
+        if (err) {
+            io_OpChain_finish(chain, err);
+            return;
+        }
+        if (step->kind == IO_CHAIN_WRITE && chain->offset < step->size) {
+            continue;
+        }
+        chain->offset = 0;
+        chain->index++;
+        if (step->kind == IO_CHAIN_READ && size < step->size) {
+            break;
+        }
+    }
+    io_OpChain_finish(chain, IO_ERR_OK);
+}
+
+IO_INLINE(void)
+io_OpChain_fn(void* self)
+{
+    io_OpChain* chain = self;
+    io_OpFlags flags = io_Op_flags(&chain->base);
+    if (flags & IO_OP_COMPLETED) {
+        io_OpChain_finalize(chain);
+    } else {
+        // Without TRYIO the reactor reported the current step ready
+        io_OpChain_run(chain, !(flags & IO_OP_TRYIO));
+    }
+}
+
+IO_INLINE(void)
+io_OpChain_abort(void* self, io_Err err)
+{
+    io_OpChain* chain = self;
+    chain->err = err;
+    io_Op_set_flags(&chain->base, IO_OP_COMPLETED);
+    io_Context_post_completion(io_Descriptor_get_context(chain->descriptor), &chain->base.base);
+}
+
+/** io_OpChain_create
+ * @brief Creates an empty chain on `descriptor`, add the steps and submit it
+ * with io_Descriptor_async_chain. A chain that's never submitted must be
+ * destroyed with io_OpChain_destroy.
+ */
+IO_INLINE(io_OpChain*)
+io_OpChain_create(io_Descriptor* descriptor, io_OpChainCallback callback, void* user_data)
+{
+    io_Allocator* allocator = io_Descriptor_allocator(descriptor);
+    io_OpChain* chain = io_Allocator_alloc(allocator, sizeof(io_OpChain));
+    if (!chain) {
+        return NULL;
+    }
+    io_Op_init(&chain->base, IO_OP_READ, io_OpChain_fn, io_OpChain_abort);
+    chain->allocator = allocator;
+    chain->descriptor = descriptor;
+    io_ChainStepVec_init(&chain->steps, allocator);
+    chain->callback = callback;
+    chain->user_data = user_data;
+    chain->index = 0;
+    chain->offset = 0;
+    chain->size = 0;
+    chain->err = IO_ERR_OK;
+    return chain;
+}
+
+IO_INLINE(io_Err)
+io_OpChain_read(io_OpChain* chain, void* addr, size_t size)
+{
+    io_ChainStep step = {.kind = IO_CHAIN_READ, .type = IO_OP_READ, .addr.read = addr, .size = size};
+    return io_ChainStepVec_push_back(&chain->steps, step);
+}
+
+IO_INLINE(io_Err)
+io_OpChain_write(io_OpChain* chain, const void* addr, size_t size)
+{
+    io_ChainStep step = {.kind = IO_CHAIN_WRITE, .type = IO_OP_WRITE, .addr.write = addr, .size = size};
+    return io_ChainStepVec_push_back(&chain->steps, step);
+}
+
+IO_INLINE(io_Err)
+io_OpChain_wait(io_OpChain* chain, io_OpType type)
+{
+    io_ChainStep step = {.kind = IO_CHAIN_WAIT, .type = type, .size = 0};
+    return io_ChainStepVec_push_back(&chain->steps, step);
+}
+
+/** io_Descriptor_async_chain_with_token
+ * @brief Submits `chain`, the chain is owned by the descriptor from now on.
+ * If `token` isn't NULL it refers to the chain, io_Op_cancel finds it in
+ * whichever slot its current step waits in and a chain caught between
+ * two steps stops before the next one.
+ */
+IO_INLINE(io_Err)
+io_Descriptor_async_chain_with_token(io_Descriptor* descriptor, io_OpChain* chain, io_OpToken* token)
+{
+    IO_ASSERT(chain->descriptor == descriptor, "Chain belongs to another descriptor");
+    if (descriptor->handle == NULL) {
+        io_OpChain_destroy(chain);
+        return io_SystemErr(IO_EBADF);
+    }
+    if (io_ChainStepVec_size(&chain->steps) > 0) {
+        chain->base.type = io_ChainStepVec_at(&chain->steps, 0)->type;
+    }
+    io_Descriptor_submit(descriptor, &chain->base, token);
+    return IO_ERR_OK;
+}
+
+IO_INLINE(io_Err)
+io_Descriptor_async_chain(io_Descriptor* descriptor, io_OpChain* chain)
+{
+    return io_Descriptor_async_chain_with_token(descriptor, chain, NULL);
+}
+
+#endif
@@ -14,7 +14,9 @@
 #ifndef IO_MOCKING
 #define IO_MOCKING 0
 #endif
+#ifndef IO_WITH_THREADS
 #define IO_WITH_THREADS 1
+#endif
 #define IO_WITH_POLL 1
 #define IO_DEFAULT_TIMEOUT 10 // seconds
 
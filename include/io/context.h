@@ -8,90 +8,271 @@
 #define IO_CONTEXT_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 #include <io/allocator.h>
 #include <io/assert.h>
+#include <io/hash.h>
 #include <io/loop.h>
 #include <io/poll.h>
 #include <io/queue.h>
+#include <io/resolver.h>
 #include <io/thread.h>
 #include <io/vec.h>
+#include <io/worker_pool.h>
 
-#define io_LoopVec_destroy_element(vec) io_Loop_destroy(*(vec))
+// Slots of loops that failed to start are NULL
+#define io_LoopVec_destroy_element(vec) (*(vec) ? io_Loop_destroy(*(vec)) : (void)0)
 
 IO_DEFINE_VEC(io_LoopVec, io_Loop*, io_LoopVec_destroy_element)
-IO_DEFINE_VEC(io_ThreadVec, io_Thread, io_Thread_deinit)
+
+/** io_PlacementPolicy
+ * @brief How io_Context_next_loop picks the loop for a new descriptor.
+ */
+typedef enum io_PlacementPolicy {
+    IO_PLACEMENT_ROUND_ROBIN,   // Each loop in turn
+    IO_PLACEMENT_LEAST_HANDLES, // The loop with the fewest live descriptors
+    IO_PLACEMENT_LEAST_BUSY,    // The loop with the lowest recent busy ratio
+    IO_PLACEMENT_TWO_CHOICES,   // The less loaded of two random loops
+    IO_PLACEMENT_LOCAL,         // The loop of the calling thread
+} io_PlacementPolicy;
+
+/** io_ElasticOptions
+ * @brief Bounds and thresholds of io_Context_scale. Loop counts include
+ * the loop of the thread that runs the context, the thresholds are average
+ * busy ratios in IO_LOOP_BUSY_SCALE units.
+ */
+typedef struct io_ElasticOptions {
+    size_t min_loops;          // At least 1
+    size_t max_loops;          // At least min_loops
+    unsigned grow_threshold;   // Add a loop at or above this average
+    unsigned shrink_threshold; // Park a loop below this average
+    size_t patience;           // Consecutive checks before a loop is added or parked
+} io_ElasticOptions;
+
+typedef enum io_StartGate {
+    IO_START_GATE_CLOSED, // Threads wait for io_Context_run
+    IO_START_GATE_OPEN,   // Threads run their loop
+    IO_START_GATE_ABORT,  // Threads exit without running
+} io_StartGate;
 
 typedef struct io_Context {
     io_LoopVec threadLoops;
     io_ThreadVec threads;
     io_ThisThreadData this_loop;
+    io_Resolver resolver;
     io_Allocator* allocator;
     io_Loop* loop;
-    size_t num_threads;
+    size_t num_threads; // Published with release after the loop's slot, see io_Context_grow
     size_t num_tasks;
     size_t round_robin_index;
+    io_PlacementPolicy placement;
+    io_ThreadOptions* thread_options; // One per thread loop, NULL for defaults
+    // Threads started by io_Context_set_num_threads_with_options
+    // wait at the start gate until the context runs
+    io_Mutex gate_mtx;
+    io_Cond gate_cond;
+    io_StartGate gate;
+    size_t gate_arrived;
+    io_Err gate_err;
+    size_t num_gated;  // Threads waiting at the start gate
+    size_t num_active; // Thread loops that take new descriptors, the others are parked
+    io_ElasticOptions elastic;
+    bool is_elastic;
+    bool running;  // Set while io_Context_run runs, changes under gate_mtx
+    bool draining; // Acceptors refuse new accepts, see io_Context_drain
+    size_t grow_strikes;
+    size_t shrink_strikes;
+    io_WorkerPool* workers; // Runs the completions if set, see io_Context_init_with_workers
+    size_t num_followers;   // Extra threads that run `loop`, see io_Context_set_num_followers
+    bool shared_nothing;    // Loops share no state, see io_Context_set_shared_nothing
+    io_Allocator** loop_allocators; // One per loop in shared-nothing mode, NULL for the context's
+    bool single_threaded;   // No locking on the hot paths, see io_Context_init_single_threaded
 } io_Context;
 
+/** io_Context_create_loop
+ * @brief Creates a loop with a poll reactor that allocates from `allocator`,
+ * counting its tasks in the context unless the context is shared-nothing.
+ */
 IO_INLINE(io_Err)
-io_Context_init(io_Context* context, io_Allocator* allocator)
+io_Context_create_loop(io_Context* context, io_Allocator* allocator, io_Loop** out)
+{
+    io_Err err = IO_ERR_OK;
+    io_Loop* loop;
+    size_t* task_counter = context->shared_nothing ? NULL : &context->num_tasks;
+    if ((err = io_Loop_create(&loop, task_counter, allocator))) {
+        return err;
+    }
+    if (context->single_threaded) {
+        io_Loop_set_single_threaded(loop);
+    } else if (context->shared_nothing) {
+        io_Loop_set_shared_nothing(loop);
+    }
+    io_Reactor* reactor = NULL;
+    if ((err = io_Poll_create(&reactor, loop, allocator))) {
+        io_Loop_destroy(loop);
+        return err;
+    }
+    io_Loop_set_reactor(loop, reactor);
+    *out = loop;
+    return IO_ERR_OK;
+}
+
+IO_INLINE(io_Err)
+io_Context_init_with_threading(io_Context* context, io_Allocator* allocator, bool single_threaded)
 {
     context->allocator = allocator ? allocator : io_SystemAllocator();
     context->num_threads = 0;
     context->num_tasks = 0;
     context->round_robin_index = 0;
+    context->placement = IO_PLACEMENT_ROUND_ROBIN;
+    context->thread_options = NULL;
+    context->gate = IO_START_GATE_CLOSED;
+    context->gate_arrived = 0;
+    context->gate_err = IO_ERR_OK;
+    context->num_gated = 0;
+    context->num_active = 0;
+    context->elastic = (io_ElasticOptions){0};
+    context->is_elastic = false;
+    context->running = false;
+    context->draining = false;
+    context->grow_strikes = 0;
+    context->shrink_strikes = 0;
+    context->workers = NULL;
+    context->num_followers = 0;
+    context->shared_nothing = false;
+    context->loop_allocators = NULL;
+    context->single_threaded = single_threaded;
     io_LoopVec_init(&context->threadLoops, context->allocator);
     io_ThreadVec_init(&context->threads, context->allocator);
     io_Err err = IO_ERR_OK;
     io_Loop* loop;
-    if ((err = io_Loop_create(&loop, &context->num_tasks, context->allocator))) {
+    if ((err = io_Context_create_loop(context, context->allocator, &loop))) {
         return err;
     }
-    io_Reactor* reactor = NULL;
-    if ((err = io_Poll_create(&reactor, loop, context->allocator))) {
-        io_Loop_destroy(loop);
-        return err;
-    }
-    io_Loop_set_reactor(loop, reactor);
     if ((err = io_ThisThreadData_init(&context->this_loop))) {
-        goto destroy_reactor;
+        goto destroy_loop;
+    }
+    if ((err = io_Resolver_init(&context->resolver, context->allocator))) {
+        goto deinit_this_loop;
+    }
+    if ((err = io_Mutex_init(&context->gate_mtx))) {
+        goto deinit_resolver;
+    }
+    if ((err = io_Cond_init(&context->gate_cond))) {
+        goto deinit_gate_mtx;
     }
     io_ThisThreadData_set(&context->this_loop, loop);
     context->loop = loop;
     return IO_ERR_OK;
-destroy_reactor:
-    io_Reactor_destroy(reactor);
+deinit_gate_mtx:
+    io_Mutex_deinit(&context->gate_mtx);
+deinit_resolver:
+    io_Resolver_deinit(&context->resolver);
+deinit_this_loop:
+    io_ThisThreadData_deinit(&context->this_loop);
+destroy_loop:
+    io_Loop_destroy(loop);
     return err;
 }
 
+IO_INLINE(io_Err)
+io_Context_init(io_Context* context, io_Allocator* allocator)
+{
+    return io_Context_init_with_threading(context, allocator, false);
+}
+
+/** io_Context_init_single_threaded
+ * @brief Like io_Context_init, for programs that only ever use the context
+ * from the thread that runs it. The loop and its reactor then skip all
+ * mutexes and atomics on their hot paths. Thread loops, followers and
+ * worker pools aren't available, and tasks must not be posted from other threads.
+ */
+IO_INLINE(io_Err)
+io_Context_init_single_threaded(io_Context* context, io_Allocator* allocator)
+{
+    return io_Context_init_with_threading(context, allocator, true);
+}
+
+/** io_Context_loop_allocator
+ * @brief The allocator of loop `index`, 0 is the loop of the thread that runs the context.
+ */
+IO_INLINE(io_Allocator*)
+io_Context_loop_allocator(io_Context* context, size_t index)
+{
+    return context->loop_allocators ? context->loop_allocators[index] : context->allocator;
+}
+
+/** io_Context_num_thread_loops
+ * @brief The number of thread loops, parked ones included. May be read
+ * from any thread while io_Context_grow adds a loop.
+ */
+IO_INLINE(size_t)
+io_Context_num_thread_loops(const io_Context* context)
+{
+    return io_atomic_load_explicit(&context->num_threads, IO_ACQUIRE);
+}
+
+/** io_Context_loop_at
+ * @brief The loop at `index`, 0 is the loop of the thread that runs the context.
+ */
+IO_INLINE(io_Loop*)
+io_Context_loop_at(io_Context* context, size_t index)
+{
+    if (index == 0) {
+        return context->loop;
+    }
+    return *io_LoopVec_at(&context->threadLoops, index - 1);
+}
+
+/** io_Context_link_loops
+ * @brief Links the loops in a ring, each loop wakes the next one when it stops.
+ */
+IO_INLINE(void)
+io_Context_link_loops(io_Context* context)
+{
+    if (context->shared_nothing) {
+        // Each loop stops on its own
+        return;
+    }
+    size_t num_threads = io_Context_num_thread_loops(context);
+    io_Loop* prev = context->loop;
+    for (size_t i = 1; i <= num_threads; ++i) {
+        io_Loop* loop = io_Context_loop_at(context, i);
+        prev->sibling = loop;
+        prev = loop;
+    }
+    prev->sibling = num_threads ? context->loop : NULL;
+}
+
 IO_INLINE(io_Err)
 io_Context_set_num_threads(io_Context* context, size_t num_threads)
 {
+    if (context->single_threaded) {
+        return io_SystemErr(IO_ENOTSUP);
+    }
     io_Err err = IO_ERR_OK;
     for (size_t i = 0; i < num_threads; i++) {
         io_Loop* loop;
-        if ((err = io_Loop_create(&loop, &context->num_tasks, context->allocator))) {
+        if ((err = io_Context_create_loop(context, io_Context_loop_allocator(context, i + 1), &loop))) {
             goto reset_loop_clear;
         }
-        io_Reactor* reactor = NULL;
-        if ((err = io_Poll_create(&reactor, loop, context->allocator))) {
-            io_Loop_destroy(loop);
-            goto reset_loop_clear;
-        }
-        io_Loop_set_reactor(loop, reactor);
         io_LoopVec_push_back(&context->threadLoops, loop);
     }
     context->num_threads = num_threads;
+    context->num_active = num_threads;
+    io_Context_link_loops(context);
     return IO_ERR_OK;
 reset_loop_clear:
     io_LoopVec_clear(&context->threadLoops);
     return err;
 }
 
-IO_INLINE(void)
-io_Context_deinit(io_Context* context)
+IO_INLINE(const io_ThreadOptions*)
+io_Context_thread_options(io_Context* context, size_t index)
 {
-    io_Loop_destroy(context->loop);
+    return context->thread_options ? &context->thread_options[index] : NULL;
 }
 
 typedef struct io_ContextThreadData {
@@ -99,35 +280,354 @@ typedef struct io_ContextThreadData {
     size_t index;
 } io_ContextThreadData;
 
+/** io_Context_boot_thread
+ * @brief Thread function of io_Context_set_num_threads_with_options. The
+ * thread sets itself up, creates its loop and waits at the start gate.
+ */
 IO_INLINE(void*)
-io_Context_run_thread(void* user_data)
+io_Context_boot_thread(void* user_data)
 {
     io_ContextThreadData* data = user_data;
-    io_Loop* loop = *io_LoopVec_at(&data->context->threadLoops, data->index);
-    io_ThisThreadData_set(&data->context->this_loop, loop);
-    io_Loop_run(loop);
-    io_free(data->context->allocator, data);
+    io_Context* context = data->context;
+    io_Loop* loop = NULL;
+    // Pin first, so that the loop's memory is first touched on its CPU
+    io_Err err = io_Thread_setup_self(io_Context_thread_options(context, data->index));
+    if (!err) {
+        err = io_Context_create_loop(context, io_Context_loop_allocator(context, data->index + 1), &loop);
+    }
+    io_Mutex_lock(&context->gate_mtx);
+    *io_LoopVec_at(&context->threadLoops, data->index) = loop;
+    if (err && !context->gate_err) {
+        context->gate_err = err;
+    }
+    context->gate_arrived++;
+    io_Cond_broadcast(&context->gate_cond);
+    while (context->gate == IO_START_GATE_CLOSED) {
+        io_Cond_wait(&context->gate_cond, &context->gate_mtx);
+    }
+    bool run = context->gate == IO_START_GATE_OPEN;
+    io_Mutex_unlock(&context->gate_mtx);
+    if (run) {
+        io_ThisThreadData_set(&context->this_loop, loop);
+        io_Loop_run(loop);
+    }
+    io_free(context->allocator, data);
     return NULL;
 }
 
+IO_INLINE(void)
+io_Context_set_gate(io_Context* context, io_StartGate gate)
+{
+    io_Mutex_lock(&context->gate_mtx);
+    context->gate = gate;
+    io_Cond_broadcast(&context->gate_cond);
+    io_Mutex_unlock(&context->gate_mtx);
+}
+
+/** io_Context_set_num_threads_with_options
+ * @brief Like io_Context_set_num_threads, but loop `i` runs on a thread started
+ * with `options[i]`, `options` may be NULL. The threads start right away:
+ * each thread pins itself, allocates its loop, so that the loop's queue, reactor
+ * and pools are local to its CPU, and then waits until the context runs.
+ * The loops can be used for placement as soon as the function returns.
+ */
 IO_INLINE(io_Err)
-io_Context_run_threads(io_Context* context)
+io_Context_set_num_threads_with_options(io_Context* context, size_t num_threads, const io_ThreadOptions* options)
 {
+#if IO_WITH_THREADS
+    IO_REQUIRE(io_LoopVec_size(&context->threadLoops) == 0, "Thread loops already set");
+    if (context->single_threaded) {
+        return io_SystemErr(IO_ENOTSUP);
+    }
     io_Err err = IO_ERR_OK;
-    for (size_t i = 0; i < context->num_threads; i++) {
+    if (options) {
+        context->thread_options = io_alloc(context->allocator, num_threads * sizeof(io_ThreadOptions));
+        if (!context->thread_options) {
+            return io_SystemErr(IO_ENOMEM);
+        }
+        memcpy(context->thread_options, options, num_threads * sizeof(io_ThreadOptions));
+    }
+    if ((err = io_LoopVec_resize(&context->threadLoops, num_threads))) {
+        goto free_options;
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        *io_LoopVec_at(&context->threadLoops, i) = NULL;
+    }
+    context->gate = IO_START_GATE_CLOSED;
+    context->gate_arrived = 0;
+    context->gate_err = IO_ERR_OK;
+    size_t started = 0;
+    for (; started < num_threads; ++started) {
         io_ContextThreadData* data = io_alloc(context->allocator, sizeof(io_ContextThreadData));
         if (!data) {
             err = io_SystemErr(IO_ENOMEM);
-            goto clear_thread_vec;
+            break;
         }
         data->context = context;
-        data->index = i;
+        data->index = started;
         io_Thread thread;
-        if ((err = io_Thread_init(&thread, io_Context_run_thread, data))) {
+        if ((err = io_Thread_init_with_options(&thread, io_Context_thread_options(context, started), io_Context_boot_thread, data))) {
             io_free(context->allocator, data);
+            break;
+        }
+        io_ThreadVec_push_back(&context->threads, thread);
+    }
+    io_Mutex_lock(&context->gate_mtx);
+    while (context->gate_arrived < started) {
+        io_Cond_wait(&context->gate_cond, &context->gate_mtx);
+    }
+    if (!err) {
+        err = context->gate_err;
+    }
+    io_Mutex_unlock(&context->gate_mtx);
+    if (err) {
+        goto abort_threads;
+    }
+    context->num_threads = num_threads;
+    context->num_active = num_threads;
+    context->num_gated = num_threads;
+    io_Context_link_loops(context);
+    return IO_ERR_OK;
+abort_threads:
+    io_Context_set_gate(context, IO_START_GATE_ABORT);
+    io_ThreadVec_clear(&context->threads);
+    io_LoopVec_clear(&context->threadLoops);
+free_options:
+    if (context->thread_options) {
+        io_free(context->allocator, context->thread_options);
+        context->thread_options = NULL;
+    }
+    return err;
+#else
+    (void)context;
+    (void)num_threads;
+    (void)options;
+    return io_SystemErr(IO_ENOTSUP);
+#endif
+}
+
+/** io_Context_set_shared_nothing
+ * @brief Thread-per-core mode: like io_Context_set_num_threads_with_options,
+ * but the loops share no state. Every loop, the calling thread's included,
+ * is confined to its thread like a single-threaded loop: its queue, task
+ * counter, pools and reactor take no locks and no atomics, and its mailbox
+ * is the only way in from other threads, see io_Loop_send. Each loop counts
+ * its own tasks and runs until it is out of them, new descriptors stay on the
+ * loop of the thread that creates them (IO_PLACEMENT_LOCAL). Give each loop
+ * its own listening socket with io_TcpAcceptor_init_sharded.
+ * Loop `i` and the ops of its descriptors allocate from `allocators[i]`,
+ * 0 being the calling thread's loop, or from the context's allocator if
+ * `allocators` is NULL. Each allocator is only used by its loop's thread
+ * and doesn't need to be thread-safe.
+ * Call it right after io_Context_init, it replaces the context's loop.
+ * Followers and worker pools aren't available. io_Context_run returns once
+ * the calling thread's loop is out of tasks, io_Context_deinit waits for the others.
+ */
+IO_INLINE(io_Err)
+io_Context_set_shared_nothing(io_Context* context, size_t num_threads, const io_ThreadOptions* options,
+                              io_Allocator* const* allocators)
+{
+    IO_REQUIRE(io_Loop_get_task_count(context->loop) == 0 && io_Loop_num_handles(context->loop) == 0,
+               "Context already in use");
+    if (context->single_threaded || context->workers || context->num_followers) {
+        return io_SystemErr(IO_ENOTSUP);
+    }
+    io_Err err = IO_ERR_OK;
+    if (allocators) {
+        context->loop_allocators = io_alloc(context->allocator, (num_threads + 1) * sizeof(io_Allocator*));
+        if (!context->loop_allocators) {
+            return io_SystemErr(IO_ENOMEM);
+        }
+        memcpy(context->loop_allocators, allocators, (num_threads + 1) * sizeof(io_Allocator*));
+    }
+    context->shared_nothing = true;
+    context->placement = IO_PLACEMENT_LOCAL;
+    // The context's loop was made for sharing, replace it with a confined one
+    io_Loop* loop;
+    if ((err = io_Context_create_loop(context, io_Context_loop_allocator(context, 0), &loop))) {
+        goto reset_mode;
+    }
+    err = options ? io_Context_set_num_threads_with_options(context, num_threads, options)
+                  : io_Context_set_num_threads(context, num_threads);
+    if (err) {
+        io_Loop_destroy(loop);
+        goto reset_mode;
+    }
+    io_Loop_destroy(context->loop);
+    context->loop = loop;
+    io_ThisThreadData_set(&context->this_loop, loop);
+    return IO_ERR_OK;
+reset_mode:
+    context->shared_nothing = false;
+    context->placement = IO_PLACEMENT_ROUND_ROBIN;
+    if (context->loop_allocators) {
+        io_free(context->allocator, context->loop_allocators);
+        context->loop_allocators = NULL;
+    }
+    return err;
+}
+
+/** io_Context_deinit
+ * @brief Joins the threads of the thread loops and followers, then destroys
+ * the loops. The threads run until their loops are out of tasks, so stop
+ * or drain a context whose descriptors still wait for I/O first.
+ */
+IO_INLINE(void)
+io_Context_deinit(io_Context* context)
+{
+    if (context->workers) {
+        io_WorkerPool_deinit(context->workers);
+        io_free(context->allocator, context->workers);
+    }
+    if (context->num_gated) {
+        io_Context_set_gate(context, IO_START_GATE_ABORT);
+    }
+    io_ThreadVec_deinit(&context->threads);
+    io_Resolver_deinit(&context->resolver);
+    io_LoopVec_deinit(&context->threadLoops);
+    io_Loop_destroy(context->loop);
+    if (context->thread_options) {
+        io_free(context->allocator, context->thread_options);
+    }
+    if (context->loop_allocators) {
+        io_free(context->allocator, context->loop_allocators);
+    }
+    io_Cond_deinit(&context->gate_cond);
+    io_Mutex_deinit(&context->gate_mtx);
+}
+
+/** io_Context_init_with_workers
+ * @brief Like io_Context_init, but the completions of all operations run on
+ * a pool of `num_workers` threads. The loops then only perform the I/O and
+ * hand the finished operations over, through lock-free queues, so that
+ * CPU-heavy callbacks don't delay the readiness of other descriptors.
+ * Multishot operations deliver every chunk or batch on a worker and read the
+ * next one once the callback returned. Callbacks of the resolver still run on
+ * the loops.
+ * Callbacks of different operations may run in parallel, use an io_Strand
+ * to serialize the ones that share state.
+ */
+IO_INLINE(io_Err)
+io_Context_init_with_workers(io_Context* context, io_Allocator* allocator, size_t num_workers)
+{
+#if IO_WITH_THREADS
+    io_Err err = IO_ERR_OK;
+    if ((err = io_Context_init(context, allocator))) {
+        return err;
+    }
+    context->workers = io_alloc(context->allocator, sizeof(io_WorkerPool));
+    if (!context->workers) {
+        err = io_SystemErr(IO_ENOMEM);
+        goto deinit_context;
+    }
+    if ((err = io_WorkerPool_init(context->workers, context->loop, num_workers, context->allocator))) {
+        io_free(context->allocator, context->workers);
+        context->workers = NULL;
+        goto deinit_context;
+    }
+    return IO_ERR_OK;
+deinit_context:
+    io_Context_deinit(context);
+    return err;
+#else
+    (void)context;
+    (void)allocator;
+    (void)num_workers;
+    return io_SystemErr(IO_ENOTSUP);
+#endif
+}
+
+IO_INLINE(void*)
+io_Context_run_thread(void* user_data)
+{
+    io_ContextThreadData* data = user_data;
+    io_Loop* loop = *io_LoopVec_at(&data->context->threadLoops, data->index);
+    // The loop already exists, failing to name or pin the thread isn't fatal
+    (void)io_Thread_setup_self(io_Context_thread_options(data->context, data->index));
+    io_ThisThreadData_set(&data->context->this_loop, loop);
+    io_Loop_run(loop);
+    io_free(data->context->allocator, data);
+    return NULL;
+}
+
+/** io_Context_start_thread
+ * @brief Starts the thread that runs thread loop `index`.
+ */
+IO_INLINE(io_Err)
+io_Context_start_thread(io_Context* context, size_t index)
+{
+    io_Err err = IO_ERR_OK;
+    io_ContextThreadData* data = io_alloc(context->allocator, sizeof(io_ContextThreadData));
+    if (!data) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    data->context = context;
+    data->index = index;
+    io_Thread thread;
+    if ((err = io_Thread_init_with_options(&thread, io_Context_thread_options(context, index), io_Context_run_thread, data))) {
+        io_free(context->allocator, data);
+        return err;
+    }
+    // io_Context_grow may start a thread from a loop while io_Context_run starts the others
+    io_Mutex_lock(&context->gate_mtx);
+    io_ThreadVec_push_back(&context->threads, thread);
+    io_Mutex_unlock(&context->gate_mtx);
+    return IO_ERR_OK;
+}
+
+/** io_Context_set_num_followers
+ * @brief Lets `num_followers` more threads run the context's main loop
+ * together with the thread that calls io_Context_run, sharing its reactor
+ * in leader/follower fashion, see io_Loop. A descriptor is then never stuck
+ * behind one busy thread, which suits few connections with uneven request
+ * cost. Completions of one descriptor may run on different threads.
+ */
+IO_INLINE(void)
+io_Context_set_num_followers(io_Context* context, size_t num_followers)
+{
+    IO_REQUIRE((!context->single_threaded && !context->shared_nothing) || num_followers == 0,
+               "Single-threaded or shared-nothing context");
+    context->num_followers = num_followers;
+}
+
+IO_INLINE(void*)
+io_Context_run_follower(void* user_data)
+{
+    io_Context* context = user_data;
+    io_ThisThreadData_set(&context->this_loop, context->loop);
+    io_Loop_run(context->loop);
+    return NULL;
+}
+
+/** io_Context_run_threads
+ * @brief Starts the followers and the threads of the first `num_threads`
+ * thread loops, io_Context_grow starts the threads of later ones.
+ */
+IO_INLINE(io_Err)
+io_Context_run_threads(io_Context* context, size_t num_threads)
+{
+    io_Err err = IO_ERR_OK;
+    for (size_t i = 0; i < context->num_followers; i++) {
+        io_Thread thread;
+        if ((err = io_Thread_init(&thread, io_Context_run_follower, context))) {
             goto clear_thread_vec;
         }
+        io_Mutex_lock(&context->gate_mtx);
         io_ThreadVec_push_back(&context->threads, thread);
+        io_Mutex_unlock(&context->gate_mtx);
+    }
+    size_t first = 0;
+    if (context->num_gated) {
+        // The first run releases the threads waiting at the start gate,
+        // loops added after them still need their threads
+        first = context->num_gated;
+        context->num_gated = 0;
+        io_Context_set_gate(context, IO_START_GATE_OPEN);
+    }
+    for (size_t i = first; i < num_threads; i++) {
+        if ((err = io_Context_start_thread(context, i))) {
+            goto clear_thread_vec;
+        }
     }
     return IO_ERR_OK;
 clear_thread_vec:
@@ -135,17 +635,86 @@ clear_thread_vec:
     return err;
 }
 
+/** io_Context_set_running
+ * @brief Sets the running flag under the gate mutex, like io_Context_grow
+ * publishes new loops, so that each new loop's thread is started exactly once.
+ * @return The number of thread loops when the flag changed.
+ */
+IO_INLINE(size_t)
+io_Context_set_running(io_Context* context, bool running)
+{
+    io_Mutex_lock(&context->gate_mtx);
+    io_atomic_store_explicit(&context->running, running, IO_RELEASE);
+    size_t num_threads = context->num_threads;
+    // Wakes io_Context_drain
+    io_Cond_broadcast(&context->gate_cond);
+    io_Mutex_unlock(&context->gate_mtx);
+    return num_threads;
+}
+
 IO_INLINE(io_Err)
 io_Context_run(io_Context* context)
 {
     io_Err err = IO_ERR_OK;
-    if ((err = io_Context_run_threads(context))) {
+    size_t num_threads = io_Context_set_running(context, true);
+    if ((err = io_Context_run_threads(context, num_threads))) {
+        io_Context_set_running(context, false);
         return err;
     }
     io_Loop_run(context->loop);
+    io_Context_set_running(context, false);
     return IO_ERR_OK;
 }
 
+/* Embedding: the functions below drive the context's main loop from a host's
+ * own event loop, on the calling thread. They don't start the threads of
+ * thread loops or followers, use io_Context_run for those.
+ */
+
+/** io_Context_run_one
+ * @brief Blocks until one task ran or the context is out of tasks.
+ * @return The number of tasks that ran, 0 or 1.
+ */
+IO_INLINE(size_t)
+io_Context_run_one(io_Context* context)
+{
+    return io_Loop_run_some(context->loop, IO_TIMEOUT_INFINITE, 1);
+}
+
+/** io_Context_poll
+ * @brief Runs the tasks that are ready and checks the reactor once, without blocking.
+ * @return The number of tasks that ran.
+ */
+IO_INLINE(size_t)
+io_Context_poll(io_Context* context)
+{
+    return io_Loop_run_some(context->loop, io_Seconds(0), SIZE_MAX);
+}
+
+/** io_Context_run_for
+ * @brief Runs tasks and waits for events for up to `duration`, or until
+ * the context is out of tasks.
+ * @return The number of tasks that ran.
+ */
+IO_INLINE(size_t)
+io_Context_run_for(io_Context* context, io_Duration duration)
+{
+    return io_Loop_run_some(context->loop, duration, SIZE_MAX);
+}
+
+/** io_Context_get_wait_fd
+ * @brief A single fd for the host to poll for readability next to its own
+ * fds: it becomes readable when a descriptor of the main loop is ready,
+ * a task was queued, an op timed out or the drain deadline passed, then
+ * call io_Context_poll. The fd is owned by the context. Only available on Linux.
+ * @return The fd, or -1 if the reactor has none.
+ */
+IO_INLINE(int)
+io_Context_get_wait_fd(io_Context* context)
+{
+    return io_Reactor_wait_fd(context->loop->reactor);
+}
+
 IO_INLINE(io_Loop*)
 io_Context_this_loop(io_Context* context)
 {
@@ -156,19 +725,291 @@ io_Context_this_loop(io_Context* context)
     return loop;
 }
 
+IO_INLINE(size_t)
+io_Context_num_loops(const io_Context* context)
+{
+    return io_atomic_load_explicit(&context->num_active, IO_ACQUIRE) + 1;
+}
+
+/** io_Context_stop
+ * @brief Stops all loops right away: every thread running a loop returns
+ * once its current task finished, and io_Context_run returns. Pending ops
+ * stay pending and queued tasks stay queued, call io_Context_restart and
+ * run the context again to finish them, or cancel them before io_Context_deinit.
+ * May be called from any thread and from within a task.
+ */
+IO_INLINE(void)
+io_Context_stop(io_Context* context)
+{
+    size_t num_threads = io_Context_num_thread_loops(context);
+    for (size_t i = 0; i <= num_threads; ++i) {
+        io_Loop_stop(io_Context_loop_at(context, i));
+    }
+}
+
+/** io_Context_restart
+ * @brief Undoes io_Context_stop and io_Context_drain, so that the context
+ * can run again. Must not be called while the context runs.
+ */
+IO_INLINE(void)
+io_Context_restart(io_Context* context)
+{
+    io_atomic_store_explicit(&context->draining, false, IO_RELEASE);
+    size_t num_threads = io_Context_num_thread_loops(context);
+    for (size_t i = 0; i <= num_threads; ++i) {
+        io_Loop_restart(io_Context_loop_at(context, i));
+    }
+}
+
+IO_INLINE(bool)
+io_Context_draining(io_Context* context)
+{
+    return io_atomic_load_explicit(&context->draining, IO_ACQUIRE);
+}
+
+/** io_Context_drain
+ * @brief Graceful shutdown with bounded latency. Pending accepts are
+ * cancelled right away and new ones fail with ECANCELED. All other ops get
+ * until `timeout` to finish, the ones still pending then are cancelled,
+ * and the loops return once the callbacks ran. If the context is running,
+ * call it from another thread, it returns once io_Context_run returned.
+ * Otherwise the calling thread runs the context until then. In shared-nothing
+ * mode, the other loops return by the same deadline, io_Context_deinit
+ * joins them. Tasks that keep posting themselves keep a loop running,
+ * io_Context_stop ends them.
+ * @param elapsed_ns Receives the time the shutdown took, may be NULL.
+ */
+IO_INLINE(io_Err)
+io_Context_drain(io_Context* context, io_Duration timeout, uint64_t* elapsed_ns)
+{
+    io_Err err = IO_ERR_OK;
+    uint64_t start = io_monotonic_ns();
+    uint64_t deadline = timeout == IO_TIMEOUT_INFINITE ? UINT64_MAX
+                                                       : start + (uint64_t)io_Duration_to_ms(timeout) * 1000000u;
+    io_atomic_store_explicit(&context->draining, true, IO_RELEASE);
+    size_t num_threads = io_Context_num_thread_loops(context);
+    for (size_t i = 0; i <= num_threads; ++i) {
+        io_Loop* loop = io_Context_loop_at(context, i);
+        if (!loop->shared_nothing) {
+            // Shared-nothing loops cancel their accepts themselves, see io_Loop_check_drain
+            io_Reactor_cancel_ops(loop->reactor, IO_OP_ACCEPT);
+        }
+        io_Loop_drain(loop, deadline);
+    }
+    io_Mutex_lock(&context->gate_mtx);
+    bool running = io_atomic_load_explicit(&context->running, IO_ACQUIRE);
+    while (io_atomic_load_explicit(&context->running, IO_ACQUIRE)) {
+        io_Cond_wait(&context->gate_cond, &context->gate_mtx);
+    }
+    io_Mutex_unlock(&context->gate_mtx);
+    if (!running) {
+        err = io_Context_run(context);
+    }
+    if (elapsed_ns) {
+        *elapsed_ns = io_monotonic_ns() - start;
+    }
+    return err;
+}
+
+IO_INLINE(void)
+io_Context_set_placement(io_Context* context, io_PlacementPolicy placement)
+{
+    context->placement = placement;
+}
+
+/** io_Loop_load
+ * @brief The load a placement policy compares, lower is better.
+ */
+IO_INLINE(size_t)
+io_Loop_load(io_Loop* loop, io_PlacementPolicy placement)
+{
+    if (placement == IO_PLACEMENT_LEAST_BUSY) {
+        // Ties on busy time are broken by the number of descriptors
+        return (size_t)io_Loop_busy_ratio(loop) * 65536u + IO_MIN(io_Loop_num_handles(loop), (size_t)65535u);
+    }
+    return io_Loop_num_handles(loop);
+}
+
 IO_INLINE(io_Loop*)
 io_Context_next_loop(io_Context* context)
 {
-    size_t index = io_atomic_fetch_add(&context->round_robin_index, 1);
-    index %= (context->num_threads + 1);
-    switch (index) {
-    case 0:
-        return context->loop;
-        break;
+    if (context->placement == IO_PLACEMENT_LOCAL) {
+        return io_Context_this_loop(context);
+    }
+    size_t num_loops = io_Context_num_loops(context);
+    size_t ticket = io_atomic_fetch_add_explicit(&context->round_robin_index, 1, IO_RELAXED);
+    switch (context->placement) {
+    case IO_PLACEMENT_LEAST_HANDLES:
+    case IO_PLACEMENT_LEAST_BUSY: {
+        // Start the scan at the round robin position, so ties rotate
+        io_Loop* best = io_Context_loop_at(context, ticket % num_loops);
+        size_t best_load = io_Loop_load(best, context->placement);
+        for (size_t i = 1; i < num_loops && best_load > 0; ++i) {
+            io_Loop* loop = io_Context_loop_at(context, (ticket + i) % num_loops);
+            size_t load = io_Loop_load(loop, context->placement);
+            if (load < best_load) {
+                best = loop;
+                best_load = load;
+            }
+        }
+        return best;
+    }
+    case IO_PLACEMENT_TWO_CHOICES: {
+        uint32_t hash = io_hash_bytes(&ticket, sizeof(ticket));
+        io_Loop* a = io_Context_loop_at(context, (hash & 0xffff) % num_loops);
+        io_Loop* b = io_Context_loop_at(context, (hash >> 16) % num_loops);
+        return io_Loop_num_handles(b) < io_Loop_num_handles(a) ? b : a;
+    }
+    case IO_PLACEMENT_ROUND_ROBIN:
     default:
-        return *io_LoopVec_at(&context->threadLoops, index - 1);
-        break;
+        return io_Context_loop_at(context, ticket % num_loops);
+    }
+}
+
+/** io_Context_imbalance
+ * @brief Descriptors on the fullest loop relative to the average, in
+ * percent. 100 means evenly spread, with N loops the worst case is N * 100.
+ */
+IO_INLINE(size_t)
+io_Context_imbalance(io_Context* context)
+{
+    size_t num_loops = io_Context_num_loops(context);
+    size_t total = 0;
+    size_t max = 0;
+    for (size_t i = 0; i < num_loops; ++i) {
+        size_t handles = io_Loop_num_handles(io_Context_loop_at(context, i));
+        total += handles;
+        max = IO_MAX(max, handles);
+    }
+    if (total == 0) {
+        return 100;
+    }
+    return max * num_loops * 100 / total;
+}
+
+/** io_Context_set_elastic
+ * @brief Starts `options->min_loops` loops and lets io_Context_scale vary
+ * the number between min and max. Call it instead of io_Context_set_num_threads.
+ */
+IO_INLINE(io_Err)
+io_Context_set_elastic(io_Context* context, const io_ElasticOptions* options)
+{
+    IO_REQUIRE(io_LoopVec_size(&context->threadLoops) == 0, "Thread loops already set");
+    IO_REQUIRE(options->min_loops >= 1 && options->min_loops <= options->max_loops, "Invalid loop bounds");
+    io_Err err = IO_ERR_OK;
+    if ((err = io_Context_set_num_threads(context, options->min_loops - 1))) {
+        return err;
+    }
+    // Allocate all slots up front, io_Context_grow then fills one in place
+    // and never resizes the vector other threads read
+    if ((err = io_LoopVec_resize(&context->threadLoops, options->max_loops - 1))) {
+        io_LoopVec_clear(&context->threadLoops);
+        context->num_threads = 0;
+        context->num_active = 0;
+        return err;
+    }
+    for (size_t i = context->num_threads; i < options->max_loops - 1; ++i) {
+        *io_LoopVec_at(&context->threadLoops, i) = NULL;
     }
+    context->elastic = *options;
+    context->elastic.patience = IO_MAX(options->patience, (size_t)1);
+    context->is_elastic = true;
+    context->grow_strikes = 0;
+    context->shrink_strikes = 0;
+    return IO_ERR_OK;
+}
+
+/** io_Context_grow
+ * @brief Activates one more loop, a parked one if there is one. A new
+ * loop's thread starts right away if the context is running, otherwise
+ * with the next run. Only for contexts set up with io_Context_set_elastic,
+ * call it from one thread at a time.
+ * @return IO_EINVAL if the context isn't elastic or already has `max_loops` loops.
+ */
+IO_INLINE(io_Err)
+io_Context_grow(io_Context* context)
+{
+    if (context->single_threaded) {
+        return io_SystemErr(IO_ENOTSUP);
+    }
+    if (!context->is_elastic) {
+        return io_SystemErr(IO_EINVAL);
+    }
+    io_Err err = IO_ERR_OK;
+    if (context->num_active < context->num_threads) {
+        io_atomic_inc_explicit(&context->num_active, IO_ACQ_REL);
+        return IO_ERR_OK;
+    }
+    if (context->num_threads + 1 >= context->elastic.max_loops) {
+        return io_SystemErr(IO_EINVAL);
+    }
+    io_Loop* loop;
+    if ((err = io_Context_create_loop(context, context->allocator, &loop))) {
+        return err;
+    }
+    io_BufferPool* pool = io_Loop_buffer_pool(context->loop);
+    io_BufferPool_configure(io_Loop_buffer_pool(loop), pool->buffer_size, pool->max, pool->max_idle);
+    size_t index = context->num_threads;
+    io_Loop* last = io_Context_loop_at(context, index);
+    // The slot was allocated by io_Context_set_elastic, readers only look
+    // at it once the new count is published
+    *io_LoopVec_at(&context->threadLoops, index) = loop;
+    // Join the ring of loops that wake each other when the tasks run out
+    loop->sibling = context->loop;
+    io_atomic_store_explicit(&last->sibling, loop, IO_RELEASE);
+    io_Mutex_lock(&context->gate_mtx);
+    io_atomic_store_explicit(&context->num_threads, index + 1, IO_RELEASE);
+    bool running = context->running;
+    io_Mutex_unlock(&context->gate_mtx);
+    if (running && (err = io_Context_start_thread(context, index))) {
+        // The loop stays parked, its thread starts with the next run
+        return err;
+    }
+    io_atomic_inc_explicit(&context->num_active, IO_ACQ_REL);
+    return IO_ERR_OK;
+}
+
+/** io_Context_scale
+ * @brief Compares the average busy ratio of the active loops with the
+ * thresholds of io_Context_set_elastic, and adds or parks a loop once the
+ * average stayed beyond a threshold for `patience` checks. A loop blocked
+ * in its reactor counts as idle for as long as it waits, see io_Loop_busy_ratio.
+ * Call it periodically from a single thread, for example from a timer on one of the loops.
+ * Parked loops take no new descriptors, their existing descriptors keep working
+ * and the loop's thread sleeps in its reactor without timer wakeups once they're gone.
+ * @return 1 if a loop was added, -1 if one was parked, 0 otherwise.
+ */
+IO_INLINE(int)
+io_Context_scale(io_Context* context)
+{
+    if (!context->is_elastic) {
+        return 0;
+    }
+    size_t num_loops = io_Context_num_loops(context);
+    size_t total = 0;
+    for (size_t i = 0; i < num_loops; ++i) {
+        total += io_Loop_busy_ratio(io_Context_loop_at(context, i));
+    }
+    size_t average = total / num_loops;
+    const io_ElasticOptions* options = &context->elastic;
+    if (average >= options->grow_threshold && num_loops < options->max_loops) {
+        context->shrink_strikes = 0;
+        if (++context->grow_strikes >= options->patience) {
+            context->grow_strikes = 0;
+            return io_Context_grow(context) == IO_ERR_OK ? 1 : 0;
+        }
+    } else if (average < options->shrink_threshold && num_loops > options->min_loops) {
+        context->grow_strikes = 0;
+        if (++context->shrink_strikes >= options->patience) {
+            context->shrink_strikes = 0;
+            io_atomic_dec_explicit(&context->num_active, IO_ACQ_REL);
+            return -1;
+        }
+    } else {
+        context->grow_strikes = 0;
+        context->shrink_strikes = 0;
+    }
+    return 0;
 }
 
 IO_INLINE(void)
@@ -177,10 +1018,126 @@ io_Context_post(io_Context* context, io_Task* task)
     io_Loop_push_task(io_Context_this_loop(context), task);
 }
 
+/** io_Context_post_completion
+ * @brief Posts a completed operation, whose task finalizes it and calls
+ * back the user. Goes to the worker pool if the context has one.
+ */
+IO_INLINE(void)
+io_Context_post_completion(io_Context* context, io_Task* task)
+{
+    if (context->workers) {
+        io_WorkerPool_push(context->workers, task);
+    } else {
+        io_Context_post(context, task);
+    }
+}
+
+/** io_Context_completes_inline
+ * @brief Whether a loop may finalize an operation right where it finished,
+ * instead of going through io_Context_post_completion.
+ */
+IO_INLINE(bool)
+io_Context_completes_inline(const io_Context* context)
+{
+    return context->workers == NULL;
+}
+
+/** io_Context_post_batch
+ * @brief Posts all tasks of `tasks` to the current loop in one go,
+ * see io_Loop_push_tasks.
+ */
+IO_INLINE(void)
+io_Context_post_batch(io_Context* context, io_TaskQueue* tasks)
+{
+    io_Loop_push_tasks(io_Context_this_loop(context), tasks);
+}
+
+/** io_Context_post_spread
+ * @brief Splits `tasks` into contiguous runs of about equal length and
+ * posts one run to each active loop, a single push per loop, whatever the
+ * placement policy. `tasks` is left empty.
+ */
+IO_INLINE(void)
+io_Context_post_spread(io_Context* context, io_TaskQueue* tasks)
+{
+    size_t count = 0;
+    for (io_Task* task = tasks->head; task; task = task->next) {
+        ++count;
+    }
+    size_t num_loops = io_Context_num_loops(context);
+    size_t per_loop = count / num_loops;
+    size_t remainder = count % num_loops;
+    for (size_t i = 0; i < num_loops && !io_TaskQueue_empty(tasks); ++i) {
+        size_t run = per_loop + (i < remainder ? 1 : 0);
+        if (run == 0) {
+            break;
+        }
+        io_TaskQueue part = io_TaskQueue_make();
+        part.head = tasks->head;
+        io_Task* last = tasks->head;
+        for (size_t n = 1; n < run; ++n) {
+            last = last->next;
+        }
+        part.tail = last;
+        tasks->head = last->next;
+        last->next = NULL;
+        io_Loop_push_counted_tasks(io_Context_loop_at(context, i), &part, run);
+    }
+    *tasks = io_TaskQueue_make();
+}
+
+/** io_Context_post_fn
+ * @brief Like io_Context_post, but the task is made from `fn` and a copy of
+ * `capture`, see io_Loop_post_fn. `fn` receives a pointer to the copy.
+ */
+IO_INLINE(io_Err)
+io_Context_post_fn(io_Context* context, io_PostFn fn, const void* capture, size_t capture_len)
+{
+    return io_Loop_post_fn(io_Context_this_loop(context), fn, capture, capture_len);
+}
+
 IO_INLINE(io_Allocator*)
 io_Context_allocator(io_Context* context)
 {
     return context->allocator;
 }
 
+/** io_Context_set_buffer_pool
+ * @brief Configures the read buffer pool of every loop, call it after
+ * io_Context_set_num_threads and before any pooled read is submitted.
+ * `max_buffers` bounds the buffers in use per loop, 0 means unbounded.
+ */
+IO_INLINE(void)
+io_Context_set_buffer_pool(io_Context* context, size_t buffer_size, size_t max_buffers, size_t max_idle)
+{
+    io_BufferPool_configure(io_Loop_buffer_pool(context->loop), buffer_size, max_buffers, max_idle);
+    size_t num_threads = io_Context_num_thread_loops(context);
+    for (size_t i = 1; i <= num_threads; ++i) {
+        io_Loop* loop = io_Context_loop_at(context, i);
+        io_BufferPool_configure(io_Loop_buffer_pool(loop), buffer_size, max_buffers, max_idle);
+    }
+}
+
+/** io_Context_tryio_stats
+ * @brief Sums the speculative I/O counters of all loops, see io_TryIoStats.
+ */
+IO_INLINE(io_TryIoStats)
+io_Context_tryio_stats(io_Context* context)
+{
+    io_TryIoStats stats = {0};
+    io_Reactor_tryio_stats(context->loop->reactor, &stats);
+    size_t num_threads = io_Context_num_thread_loops(context);
+    for (size_t i = 1; i <= num_threads; ++i) {
+        io_Loop* loop = io_Context_loop_at(context, i);
+        io_Reactor_tryio_stats(loop->reactor, &stats);
+    }
+    return stats;
+}
+
+IO_INLINE(io_Resolver*)
+io_Context_resolver(io_Context* context)
+{
+    return &context->resolver;
+}
+
 #endif
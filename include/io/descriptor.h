@@ -8,19 +8,42 @@
 #define IO_DESCRIPTOR_H
 
 #include <io/config.h>
+#include <io/atomic.h>
 #include <io/context.h>
 #include <io/reactor.h>
+#include <io/socket_options.h>
+#include <io/wait.h>
+
+#include <stdbool.h>
 
 typedef struct io_Descriptor {
     io_Context* context;
     io_Handle* handle;
+    io_Loop* loop; // The loop whose reactor owns the handle
+    bool non_blocking;   // Cached O_NONBLOCK state, kept by io_Descriptor_set_non_blocking
+    uint64_t op_seq;     // Last sequence number handed out for an io_OpToken
+    uint64_t cancel_seq; // Last token io_Op_cancel was called with, see io_Descriptor_cancelled
 } io_Descriptor;
 
+/** io_OpToken
+ * @brief Refers to a single submitted op, see io_Op_cancel. The token
+ * stays valid after the op completed, cancelling it is then a no-op.
+ */
+typedef struct io_OpToken {
+    io_Descriptor* descriptor;
+    io_OpType type;
+    uint64_t seq;
+} io_OpToken;
+
 IO_INLINE(void)
 io_Descriptor_init(io_Descriptor* descriptor, io_Context* context)
 {
     descriptor->context = context;
     descriptor->handle = NULL;
+    descriptor->loop = NULL;
+    descriptor->non_blocking = false;
+    descriptor->op_seq = 0;
+    descriptor->cancel_seq = 0;
 }
 
 IO_INLINE(void)
@@ -28,7 +51,9 @@ io_Descriptor_clear_fd(io_Descriptor* descriptor)
 {
     if (descriptor->handle) {
         io_Handle_destroy(descriptor->handle);
+        io_atomic_dec_if(!descriptor->loop->single_threaded, &descriptor->loop->num_handles, IO_RELAXED);
         descriptor->handle = NULL;
+        descriptor->loop = NULL;
     }
 }
 
@@ -40,13 +65,34 @@ io_Descriptor_get_fd(const io_Descriptor* descriptor)
     return io_Handle_get_fd(descriptor->handle);
 }
 
+/** io_Descriptor_set_fd_on_loop
+ * @brief Registers `fd` with the reactor of `loop`, completions
+ * of operations on the descriptor are then run on that loop.
+ */
 IO_INLINE(void)
-io_Descriptor_set_fd(io_Descriptor* descriptor, int fd)
+io_Descriptor_set_fd_on_loop(io_Descriptor* descriptor, io_Loop* loop, int fd)
 {
     if (descriptor->handle) {
         io_Descriptor_clear_fd(descriptor);
     }
-    descriptor->handle = io_Reactor_create_handle(io_Context_next_loop(descriptor->context)->reactor, fd);
+    descriptor->handle = io_Reactor_create_handle(loop->reactor, fd);
+    descriptor->loop = loop;
+    if (descriptor->handle) {
+        io_atomic_inc_if(!loop->single_threaded, &loop->num_handles, IO_RELAXED);
+    }
+    descriptor->non_blocking = false;
+}
+
+IO_INLINE(void)
+io_Descriptor_set_fd(io_Descriptor* descriptor, int fd)
+{
+    io_Descriptor_set_fd_on_loop(descriptor, io_Context_next_loop(descriptor->context), fd);
+}
+
+IO_INLINE(io_Loop*)
+io_Descriptor_get_loop(const io_Descriptor* descriptor)
+{
+    return descriptor->loop;
 }
 
 IO_INLINE(io_Context*)
@@ -55,6 +101,16 @@ io_Descriptor_get_context(io_Descriptor* descriptor)
     return descriptor->context;
 }
 
+/** io_Descriptor_allocator
+ * @brief Allocator for the descriptor's ops: its loop's once it has an fd,
+ * which a shared-nothing context confines to that loop's thread.
+ */
+IO_INLINE(io_Allocator*)
+io_Descriptor_allocator(io_Descriptor* descriptor)
+{
+    return descriptor->loop ? io_Loop_allocator(descriptor->loop) : descriptor->context->allocator;
+}
+
 IO_INLINE(void)
 io_Descriptor_cancel(io_Descriptor* descriptor)
 {
@@ -63,6 +119,68 @@ io_Descriptor_cancel(io_Descriptor* descriptor)
     }
 }
 
+/** io_Descriptor_reserve_token
+ * @brief Sets `token` to refer to the next op of `type` submitted with its sequence number.
+ */
+IO_INLINE(void)
+io_Descriptor_reserve_token(io_Descriptor* descriptor, io_OpType type, io_OpToken* token)
+{
+    token->descriptor = descriptor;
+    token->type = type;
+    token->seq = io_atomic_fetch_add_explicit(&descriptor->op_seq, 1, IO_RELAXED) + 1;
+}
+
+/** io_Descriptor_submit
+ * @brief Submits `op` to the descriptor's handle, if `token` isn't NULL
+ * it's set to refer to the op.
+ * @return The error of io_Handle_submit, the caller still owns the op then.
+ */
+IO_INLINE(io_Err)
+io_Descriptor_submit(io_Descriptor* descriptor, io_Op* op, io_OpToken* token)
+{
+    if (token) {
+        io_Descriptor_reserve_token(descriptor, op->type, token);
+        op->seq = token->seq;
+    }
+    return io_Handle_submit(descriptor->handle, op);
+}
+
+/** io_Descriptor_cancelled
+ * @brief Whether io_Op_cancel was called for the op with `seq` last. Ops
+ * that leave the handle between their steps, like io_OpChain, check it
+ * before they wait again.
+ */
+IO_INLINE(bool)
+io_Descriptor_cancelled(io_Descriptor* descriptor, uint64_t seq)
+{
+    return seq != 0 && io_atomic_load_explicit(&descriptor->cancel_seq, IO_SEQ_CST) == seq;
+}
+
+/** io_Op_cancel
+ * @brief Cancels only the op `token` refers to, its callback gets ECANCELED.
+ * Other ops on the descriptor keep running. An op that moves between the
+ * read and write slot is found in either.
+ * @return true if the op was still pending and is now cancelled, an op that
+ * was between two of its steps is cancelled before the next one instead.
+ */
+IO_INLINE(bool)
+io_Op_cancel(const io_OpToken* token)
+{
+    io_Descriptor* descriptor = token->descriptor;
+    if (token->seq == 0) {
+        return false;
+    }
+    // Published before the slots are searched, an op that isn't in either
+    // yet sees it before it waits again
+    io_atomic_store_explicit(&descriptor->cancel_seq, token->seq, IO_SEQ_CST);
+    if (!descriptor->handle) {
+        return false;
+    }
+    io_OpType other = token->type == IO_OP_READ ? IO_OP_WRITE : IO_OP_READ;
+    return io_Handle_cancel_op(descriptor->handle, token->type, token->seq)
+        || io_Handle_cancel_op(descriptor->handle, other, token->seq);
+}
+
 IO_INLINE(io_Err)
 io_Descriptor_set_non_blocking(io_Descriptor* descriptor, bool non_blocking)
 {
@@ -79,6 +197,7 @@ io_Descriptor_set_non_blocking(io_Descriptor* descriptor, bool non_blocking)
     if (io_fcntl(fd, F_SETFL, flags) == -1) {
         return io_SystemErr(errno);
     }
+    descriptor->non_blocking = non_blocking;
     return IO_ERR_OK;
 }
 
@@ -104,6 +223,144 @@ io_Descriptor_set_timeout(io_Descriptor* descriptor, io_OpType type, io_Duration
     return IO_ERR_OK;
 }
 
+/** io_Descriptor_set_options
+ * @brief Applies the socket options to the descriptor's fd.
+ */
+IO_INLINE(io_Err)
+io_Descriptor_set_options(io_Descriptor* descriptor, const io_SocketOptions* options)
+{
+    if (descriptor->handle == NULL) {
+        return io_SystemErr(EBADF);
+    }
+    return io_SocketOptions_apply(options, io_Descriptor_get_fd(descriptor));
+}
+
+/** io_Descriptor_async_wait
+ * @brief Calls `callback` once the fd is ready for `type` (IO_OP_READ
+ * or IO_OP_WRITE) without performing any I/O, the caller then does
+ * its own syscalls. The wait occupies the same slot as a read
+ * or write op of that type, so don't mix them on one descriptor.
+ */
+IO_INLINE(io_Err)
+io_Descriptor_async_wait_with_token(io_Descriptor* descriptor, io_OpType type, io_WaitCallback callback, void* user_data, io_OpToken* token)
+{
+    if (descriptor->handle == NULL) {
+        return io_SystemErr(EBADF);
+    }
+    io_WaitOp* op = io_WaitOp_create(descriptor->context, io_Descriptor_allocator(descriptor), type, callback, user_data);
+    if (!op) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    io_Descriptor_submit(descriptor, &op->base, token);
+    return IO_ERR_OK;
+}
+
+IO_INLINE(io_Err)
+io_Descriptor_async_wait(io_Descriptor* descriptor, io_OpType type, io_WaitCallback callback, void* user_data)
+{
+    return io_Descriptor_async_wait_with_token(descriptor, type, callback, user_data, NULL);
+}
+
+typedef void (*io_MigrateCallback)(void* user_data, io_Err err);
+
+typedef struct io_MigrateTask {
+    io_Task base;
+    io_Descriptor* descriptor;
+    io_Loop* target;
+    io_MigrateCallback callback;
+    void* user_data;
+    io_HandleState state;
+    io_Err err;
+} io_MigrateTask;
+
+IO_INLINE(void)
+io_MigrateTask_finish(void* self)
+{
+    io_MigrateTask* task = self;
+    io_Allocator* allocator = task->descriptor->context->allocator;
+    if (task->callback) {
+        task->callback(task->user_data, task->err);
+    }
+    io_Allocator_free(allocator, task);
+}
+
+/** io_MigrateTask_adopt
+ * @brief Second half of a migration, registers the fd with the target loop's reactor.
+ */
+IO_INLINE(void)
+io_MigrateTask_adopt(void* self)
+{
+    io_MigrateTask* task = self;
+    io_Descriptor* descriptor = task->descriptor;
+    io_Handle* handle = io_Reactor_create_handle(task->target->reactor, task->state.fd);
+    if (!handle) {
+        // The fd can't be registered anywhere else either, give it up
+        io_close(task->state.fd);
+        descriptor->loop = NULL;
+        task->err = io_SystemErr(IO_ENOMEM);
+    } else {
+        for (size_t idx = IO_OP_MAX; idx--;) {
+            io_Handle_set_timeout(handle, (io_OpType)idx, task->state.timeout[idx]);
+        }
+        io_atomic_inc_explicit(&task->target->num_handles, IO_RELAXED);
+        descriptor->loop = task->target;
+    }
+    descriptor->handle = handle;
+    io_MigrateTask_finish(task);
+}
+
+/** io_MigrateTask_release
+ * @brief First half of a migration, runs on the descriptor's current loop.
+ */
+IO_INLINE(void)
+io_MigrateTask_release(void* self)
+{
+    io_MigrateTask* task = self;
+    io_Descriptor* descriptor = task->descriptor;
+    io_Loop* source = descriptor->loop;
+    if (!descriptor->handle) {
+        task->err = io_SystemErr(IO_EBADF);
+    } else if (!io_Handle_release(descriptor->handle, &task->state)) {
+        task->err = io_SystemErr(IO_EBUSY);
+    } else {
+        descriptor->handle = NULL;
+        io_atomic_dec_explicit(&source->num_handles, IO_RELAXED);
+        task->base.fn = io_MigrateTask_adopt;
+        io_Loop_push_task(task->target, &task->base);
+        return;
+    }
+    io_MigrateTask_finish(task);
+}
+
+/** io_Descriptor_migrate
+ * @brief Moves the descriptor to `target`, so that its completions run there.
+ * The move happens on the descriptor's current loop and fails with EBUSY if an
+ * op is pending at that point. The callback is optional, it runs on the target
+ * loop on success. Don't submit ops on the descriptor until it was called.
+ */
+IO_INLINE(io_Err)
+io_Descriptor_migrate(io_Descriptor* descriptor, io_Loop* target, io_MigrateCallback callback, void* user_data)
+{
+    if (descriptor->handle == NULL) {
+        return io_SystemErr(IO_EBADF);
+    }
+    io_MigrateTask* task = io_Allocator_alloc(descriptor->context->allocator, sizeof(io_MigrateTask));
+    if (!task) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    task->base.fn = io_MigrateTask_release;
+    task->descriptor = descriptor;
+    task->target = target;
+    task->callback = callback;
+    task->user_data = user_data;
+    task->err = IO_ERR_OK;
+    if (target == descriptor->loop) {
+        task->base.fn = io_MigrateTask_finish;
+    }
+    io_Loop_push_task(descriptor->loop, &task->base);
+    return IO_ERR_OK;
+}
+
 IO_INLINE(void)
 io_Descriptor_close(io_Descriptor* descriptor)
 {
@@ -123,6 +380,18 @@ io_Descriptor_close(io_Descriptor* descriptor)
         B##_set_fd(&descriptor->base, fd);                               \
     }                                                                    \
                                                                          \
+    IO_INLINE(void)                                                      \
+    P##_set_fd_on_loop(P* descriptor, io_Loop* loop, int fd)             \
+    {                                                                    \
+        B##_set_fd_on_loop(&descriptor->base, loop, fd);                 \
+    }                                                                    \
+                                                                         \
+    IO_INLINE(io_Loop*)                                                  \
+    P##_get_loop(const P* descriptor)                                    \
+    {                                                                    \
+        return B##_get_loop(&descriptor->base);                          \
+    }                                                                    \
+                                                                         \
     IO_INLINE(int)                                                       \
     P##_get_fd(const P* descriptor)                                      \
     {                                                                    \
@@ -153,6 +422,31 @@ io_Descriptor_close(io_Descriptor* descriptor)
         return B##_set_timeout(&descriptor->base, type, duration);       \
     }                                                                    \
                                                                          \
+    IO_INLINE(io_Err)                                                    \
+    P##_async_wait(P* descriptor, io_OpType type,                        \
+                   io_WaitCallback callback, void* user_data)            \
+    {                                                                    \
+        return B##_async_wait(&descriptor->base, type,                   \
+                              callback, user_data);                      \
+    }                                                                    \
+                                                                         \
+    IO_INLINE(io_Err)                                                    \
+    P##_async_wait_with_token(P* descriptor, io_OpType type,             \
+                              io_WaitCallback callback, void* user_data, \
+                              io_OpToken* token)                         \
+    {                                                                    \
+        return B##_async_wait_with_token(&descriptor->base, type,        \
+                                         callback, user_data, token);    \
+    }                                                                    \
+                                                                         \
+    IO_INLINE(io_Err)                                                    \
+    P##_migrate(P* descriptor, io_Loop* target,                          \
+                io_MigrateCallback callback, void* user_data)            \
+    {                                                                    \
+        return B##_migrate(&descriptor->base, target,                    \
+                           callback, user_data);                         \
+    }                                                                    \
+                                                                         \
     IO_INLINE(void)                                                      \
     P##_cancel(P* descriptor)                                            \
     {                                                                    \
@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_FN_TASK_H
+#define IO_FN_TASK_H
+
+#include <io/config.h>
+
+#include <io/align.h>
+#include <io/allocator.h>
+#include <io/err.h>
+#include <io/task.h>
+#include <io/thread.h>
+
+#include <stddef.h>
+#include <string.h>
+
+/* Captures up to this size are copied into pooled task slots */
+#ifndef IO_FN_TASK_CAPTURE_SIZE
+#define IO_FN_TASK_CAPTURE_SIZE 48
+#endif
+
+#define IO_FN_TASK_DEFAULT_MAX_IDLE 256
+
+typedef void (*io_PostFn)(void* capture);
+
+struct io_FnTaskPool;
+
+/** io_FnTask
+ * @brief A task that calls `fn` with a copy of the caller's capture.
+ * Tasks with small captures come from an io_FnTaskPool, larger ones
+ * are allocated on their own.
+ */
+typedef struct io_FnTask {
+    io_Task base;
+    struct io_FnTaskPool* pool; // NULL for oversized captures
+    io_Allocator* allocator;
+    struct io_FnTask* next;
+    io_PostFn fn;
+    io_max_align capture[];
+} io_FnTask;
+
+/** io_FnTaskPool
+ * @brief Free list of task slots with IO_FN_TASK_CAPTURE_SIZE bytes of capture.
+ * Slots are taken by the posting thread and returned by the loop that ran
+ * them, at most `max_idle` slots are kept.
+ */
+typedef struct io_FnTaskPool {
+    io_Allocator* allocator;
+    io_FnTask* idle;
+    io_Mutex mtx;
+    size_t num_idle;
+    size_t max_idle;
+} io_FnTaskPool;
+
+IO_INLINE(io_Err)
+io_FnTaskPool_init(io_FnTaskPool* pool, io_Allocator* allocator)
+{
+    pool->allocator = allocator;
+    pool->idle = NULL;
+    pool->num_idle = 0;
+    pool->max_idle = IO_FN_TASK_DEFAULT_MAX_IDLE;
+    return io_Mutex_init(&pool->mtx);
+}
+
+IO_INLINE(void)
+io_FnTaskPool_deinit(io_FnTaskPool* pool)
+{
+    while (pool->idle) {
+        io_FnTask* task = pool->idle;
+        pool->idle = task->next;
+        io_Allocator_free(pool->allocator, task);
+    }
+    pool->num_idle = 0;
+    io_Mutex_deinit(&pool->mtx);
+}
+
+IO_INLINE(void)
+io_FnTaskPool_put(io_FnTaskPool* pool, io_FnTask* task)
+{
+    io_Mutex_lock(&pool->mtx);
+    if (pool->num_idle < pool->max_idle) {
+        task->next = pool->idle;
+        pool->idle = task;
+        pool->num_idle++;
+        task = NULL;
+    }
+    io_Mutex_unlock(&pool->mtx);
+    if (task) {
+        io_Allocator_free(pool->allocator, task);
+    }
+}
+
+IO_INLINE(size_t)
+io_FnTaskPool_num_idle(io_FnTaskPool* pool)
+{
+    io_Mutex_lock(&pool->mtx);
+    size_t num_idle = pool->num_idle;
+    io_Mutex_unlock(&pool->mtx);
+    return num_idle;
+}
+
+IO_INLINE(void)
+io_FnTask_fn(void* self)
+{
+    io_FnTask* task = self;
+    task->fn(task->capture);
+    if (task->pool) {
+        io_FnTaskPool_put(task->pool, task);
+    } else {
+        io_Allocator_free(task->allocator, task);
+    }
+}
+
+/** io_FnTaskPool_acquire
+ * @brief Takes a task that calls `fn` with a copy of `capture`,
+ * NULL if out of memory.
+ */
+IO_INLINE(io_FnTask*)
+io_FnTaskPool_acquire(io_FnTaskPool* pool, io_PostFn fn, const void* capture, size_t capture_len)
+{
+    io_FnTask* task = NULL;
+    if (capture_len <= IO_FN_TASK_CAPTURE_SIZE) {
+        io_Mutex_lock(&pool->mtx);
+        task = pool->idle;
+        if (task) {
+            pool->idle = task->next;
+            pool->num_idle--;
+        }
+        io_Mutex_unlock(&pool->mtx);
+        if (!task) {
+            task = io_Allocator_alloc(pool->allocator, sizeof(io_FnTask) + IO_FN_TASK_CAPTURE_SIZE);
+            if (!task) {
+                return NULL;
+            }
+        }
+        task->pool = pool;
+    } else {
+        task = io_Allocator_alloc(pool->allocator, sizeof(io_FnTask) + capture_len);
+        if (!task) {
+            return NULL;
+        }
+        task->pool = NULL;
+    }
+    task->base.fn = io_FnTask_fn;
+    task->allocator = pool->allocator;
+    task->next = NULL;
+    task->fn = fn;
+    if (capture_len) {
+        memcpy(task->capture, capture, capture_len);
+    }
+    return task;
+}
+
+#endif
@@ -26,7 +26,8 @@ io_GaiErr_msg(uint32_t code)
 IO_INLINE(io_Err)
 io_GaiErr(int code)
 {
-    IO_ASSERT(code > 0, "Invalid gai error code");
+    // EAI_* codes are negative on some platforms (e.g. glibc)
+    IO_ASSERT(code != 0, "Invalid gai error code");
     return IO_ERR_PACK(IO_GAI_CATEGORY, (uint32_t)code);
 }
 
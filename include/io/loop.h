@@ -7,46 +7,131 @@
 #ifndef IO_LOOP_H
 #define IO_LOOP_H
 
+#include <io/align.h>
 #include <io/assert.h>
 #include <io/atomic.h>
+#include <io/buffer_pool.h>
 #include <io/err.h>
+#include <io/fn_task.h>
+#include <io/mpsc.h>
 #include <io/queue.h>
 #include <io/reactor.h>
 #include <io/task.h>
 #include <io/thread.h>
+#include <io/timer.h>
+
+#include <stdint.h>
 
 IO_DEFINE_QUEUE(io_TaskQueue, io_Task)
 
+/* Length of the window over which a loop measures its busy share */
+#ifndef IO_LOOP_BUSY_WINDOW_NS
+#define IO_LOOP_BUSY_WINDOW_NS (100u * 1000u * 1000u)
+#endif
+
+#define IO_LOOP_BUSY_SCALE 1024u
+
+/** io_Loop
+ * @brief Runs tasks and its reactor. Several threads may run the same loop,
+ * leader/follower style: the reactor task is queued once, so only the thread
+ * that popped it waits in the reactor, the leader. The others run the tasks
+ * the leader's reactor queued, and wait on `followers` while there are none.
+ * A single-threaded loop skips all locking and atomics, see io_Loop_set_single_threaded,
+ * a shared-nothing loop does the same but still takes mail from other threads.
+ */
 typedef struct io_Loop {
     io_TaskQueue queue;
     io_Task reactor_task;
     io_Mutex mutex;
+    io_Cond followers;    // Signalled when tasks are queued for waiting threads
+    size_t num_waiting;   // Threads waiting on `followers`
+    size_t num_runners;   // Threads in io_Loop_run
     io_Reactor* reactor;
     io_Allocator* allocator;
+    io_BufferPool buffer_pool; // Read buffers for the loop's sockets
+    io_FnTaskPool fn_tasks;    // Task slots for io_Loop_post_fn
     size_t* num_tasks;
+    size_t own_tasks;        // The task counter of loops that don't share one
+    struct io_Loop* sibling; // Next loop sharing num_tasks, woken once no tasks are left
+    io_TaskMpsc mailbox;     // Tasks sent by other threads with io_Loop_send
+    size_t mail_pending;     // Tasks in the mailbox
+    bool mail_blocked;       // Set while the reactor may block without seeing the mailbox
+    size_t num_handles;      // Descriptors registered with the loop's reactor
+    unsigned busy_ratio;     // Moving average of the busy share, in 1/IO_LOOP_BUSY_SCALE
+    uint64_t busy_ns;        // Time spent outside the reactor in the current window
+    uint64_t window_start;
+    uint64_t busy_since;     // When the loop last returned from its reactor
+    uint64_t reactor_since;  // When the loop entered its reactor, 0 while it runs tasks
+    void* mem;               // Start of the allocation, the loop itself is cache line aligned
+    uint64_t drain_deadline; // Pending ops are cancelled from then on, 0 if not draining
     bool needs_interrupt;
+    bool single_threaded;
+    bool shared_nothing; // Single-threaded, but reachable through the mailbox, see io_Loop_set_shared_nothing
+    bool drain_begun;    // The loop's pending accepts were cancelled for the current drain
+    bool stopped;        // Runners return as soon as they see it, see io_Loop_stop
 } io_Loop;
 
+/** io_Loop_create
+ * @brief Creates a loop that counts its tasks in `task_counter`, loops
+ * sharing a counter run until all of them are out of tasks. With a NULL
+ * counter, the loop counts its tasks on its own.
+ */
 IO_INLINE(io_Err)
 io_Loop_create(io_Loop** out, size_t* task_counter, io_Allocator* allocator)
 {
-    io_Loop* loop = io_alloc(allocator, sizeof(io_Loop));
-    if (!loop)
+    // Loops are written by different threads, keep them from sharing cache lines
+    void* mem = io_alloc(allocator, IO_ALIGNUP(sizeof(io_Loop), IO_CACHE_LINE_SIZE) + IO_CACHE_LINE_SIZE);
+    if (!mem)
         return io_SystemErr(IO_ENOMEM);
-    loop->num_tasks = task_counter;
+    io_Loop* loop = IO_ALIGNAS(IO_CACHE_LINE_SIZE, mem);
+    loop->mem = mem;
+    loop->own_tasks = 0;
+    loop->num_tasks = task_counter ? task_counter : &loop->own_tasks;
+    io_TaskMpsc_init(&loop->mailbox);
+    loop->mail_pending = 0;
+    loop->mail_blocked = false;
     loop->queue = (io_TaskQueue){0};
     loop->reactor = NULL;
     loop->allocator = allocator;
+    loop->sibling = NULL;
+    loop->num_handles = 0;
+    loop->busy_ratio = 0;
+    loop->busy_ns = 0;
+    loop->window_start = 0;
+    loop->busy_since = 0;
+    loop->reactor_since = 0;
+    loop->drain_deadline = 0;
     loop->needs_interrupt = false;
+    loop->single_threaded = false;
+    loop->shared_nothing = false;
+    loop->drain_begun = false;
+    loop->stopped = false;
+    loop->num_waiting = 0;
+    loop->num_runners = 0;
     io_Err err = IO_ERR_OK;
     if ((err = io_Mutex_init(&loop->mutex))) {
         goto free_loop;
     }
+    if ((err = io_Cond_init(&loop->followers))) {
+        goto deinit_mutex;
+    }
+    if ((err = io_BufferPool_init(&loop->buffer_pool, allocator, IO_BUFFER_POOL_DEFAULT_SIZE, 0))) {
+        goto deinit_cond;
+    }
+    if ((err = io_FnTaskPool_init(&loop->fn_tasks, allocator))) {
+        goto deinit_buffer_pool;
+    }
     io_TaskQueue_push(&loop->queue, &loop->reactor_task);
     *out = loop;
     return IO_ERR_OK;
+deinit_buffer_pool:
+    io_BufferPool_deinit(&loop->buffer_pool);
+deinit_cond:
+    io_Cond_deinit(&loop->followers);
+deinit_mutex:
+    io_Mutex_deinit(&loop->mutex);
 free_loop:
-    io_free(allocator, loop);
+    io_free(allocator, mem);
     return err;
 }
 
@@ -60,16 +145,82 @@ io_Loop_set_reactor(io_Loop* loop, io_Reactor* reactor)
     loop->reactor = reactor;
 }
 
+/** io_Loop_set_single_threaded
+ * @brief Confines the loop to the thread that runs it: its queue, pools
+ * and task counter are no longer locked or updated atomically, and the
+ * reactor created for the loop afterwards does the same for its handles.
+ * Must be called before the reactor is created. Tasks may then only be
+ * pushed from the loop's own thread, and the loop's task counter must not
+ * be shared with other loops.
+ */
+IO_INLINE(void)
+io_Loop_set_single_threaded(io_Loop* loop)
+{
+    IO_REQUIRE(loop->reactor == NULL, "Loop already has a reactor");
+    loop->single_threaded = true;
+    io_Mutex_elide(&loop->mutex);
+    io_Mutex_elide(&loop->buffer_pool.mtx);
+    io_Mutex_elide(&loop->fn_tasks.mtx);
+}
+
+/** io_Loop_set_shared_nothing
+ * @brief Like io_Loop_set_single_threaded, but other threads may still
+ * hand tasks to the loop with io_Loop_send, and stop or drain it. The
+ * mailbox is then the loop's only synchronized path, tasks sent to it
+ * count towards the loop's tasks once the loop collected them.
+ */
+IO_INLINE(void)
+io_Loop_set_shared_nothing(io_Loop* loop)
+{
+    io_Loop_set_single_threaded(loop);
+    loop->shared_nothing = true;
+}
+
+/** io_Loop_reachable
+ * @brief Whether other threads may reach the loop: send it tasks, stop or drain it.
+ */
+IO_INLINE(bool)
+io_Loop_reachable(const io_Loop* loop)
+{
+    return !loop->single_threaded || loop->shared_nothing;
+}
+
+IO_INLINE(io_Allocator*)
+io_Loop_allocator(io_Loop* loop)
+{
+    return loop->allocator;
+}
+
+IO_INLINE(io_BufferPool*)
+io_Loop_buffer_pool(io_Loop* loop)
+{
+    return &loop->buffer_pool;
+}
+
 IO_INLINE(void)
 io_Loop_decrease_task_count(io_Loop* loop)
 {
-    io_atomic_dec(loop->num_tasks);
+    bool shared = !loop->single_threaded;
+    if (io_atomic_dec_if(shared, loop->num_tasks, IO_SEQ_CST) != 0) {
+        return;
+    }
+    if (loop->sibling || io_atomic_load_if(shared, &loop->num_runners, IO_SEQ_CST) > 1) {
+        // The loops sharing the counter, or the leader of this loop, may be
+        // blocked in their reactor, wake them up so that they see there's nothing left.
+        io_Reactor_interrupt(loop->reactor);
+    }
+    if (io_atomic_load_if(shared, &loop->num_waiting, IO_SEQ_CST) > 0) {
+        io_Mutex_lock(&loop->mutex);
+        io_Cond_broadcast(&loop->followers);
+        io_Mutex_unlock(&loop->mutex);
+    }
 }
 
 IO_INLINE(void)
 io_Loop_increase_task_count(io_Loop* loop)
 {
-    io_atomic_inc(loop->num_tasks);
+    // Whoever increments holds a task already, so the count can't drop to 0 meanwhile
+    io_atomic_inc_if(!loop->single_threaded, loop->num_tasks, IO_RELAXED);
     io_Mutex_lock(&loop->mutex);
     if (loop->needs_interrupt) {
         loop->needs_interrupt = false;
@@ -81,7 +232,11 @@ io_Loop_increase_task_count(io_Loop* loop)
 IO_INLINE(size_t)
 io_Loop_get_task_count(io_Loop* loop)
 {
-    return io_atomic_load(loop->num_tasks);
+    if (loop->shared_nothing) {
+        // Sent tasks keep the loop running until they are collected
+        return *loop->num_tasks + io_atomic_load_explicit(&loop->mail_pending, IO_ACQUIRE);
+    }
+    return io_atomic_load_if(!loop->single_threaded, loop->num_tasks, IO_ACQUIRE);
 }
 
 IO_INLINE(void)
@@ -94,24 +249,343 @@ io_Loop_push_task(io_Loop* loop, io_Task* task)
         loop->needs_interrupt = false;
         io_Reactor_interrupt(loop->reactor);
     }
+    if (loop->num_waiting) {
+        io_Cond_signal(&loop->followers);
+    }
+    io_Mutex_unlock(&loop->mutex);
+}
+
+/** io_Loop_push_counted_tasks
+ * @brief Like io_Loop_push_tasks, for callers that know that `tasks` holds `count` tasks.
+ */
+IO_INLINE(void)
+io_Loop_push_counted_tasks(io_Loop* loop, io_TaskQueue* tasks, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    if (loop->single_threaded) {
+        *loop->num_tasks += count;
+    } else {
+        io_atomic_fetch_add_explicit(loop->num_tasks, count, IO_RELAXED);
+    }
+    io_Mutex_lock(&loop->mutex);
+    io_TaskQueue_push_queue(&loop->queue, tasks);
+    if (loop->needs_interrupt) {
+        loop->needs_interrupt = false;
+        io_Reactor_interrupt(loop->reactor);
+    }
+    if (loop->num_waiting) {
+        io_Cond_broadcast(&loop->followers);
+    }
+    io_Mutex_unlock(&loop->mutex);
+}
+
+/** io_Loop_push_tasks
+ * @brief Moves all tasks of `tasks` to the loop at once, with a single
+ * counter update, one lock and at most one wakeup. `tasks` is left empty.
+ */
+IO_INLINE(void)
+io_Loop_push_tasks(io_Loop* loop, io_TaskQueue* tasks)
+{
+    size_t count = 0;
+    for (io_Task* task = tasks->head; task; task = task->next) {
+        ++count;
+    }
+    io_Loop_push_counted_tasks(loop, tasks, count);
+}
+
+/** io_Loop_send
+ * @brief Queues `task` on `loop` through the loop's lock-free mailbox,
+ * without touching the loop's mutex. This is how the loops of a shared-nothing
+ * context talk to each other. The loop picks sent tasks up once per
+ * reactor turn, and is only woken if it's about to block.
+ * Sends are valid while the target runs, or before it's run, and the task
+ * count keeps it running until their tasks are collected. Once io_Loop_run
+ * returned, nothing collects the mailbox until the loop runs again, mail
+ * must not be left for io_Loop_destroy.
+ */
+IO_INLINE(void)
+io_Loop_send(io_Loop* loop, io_Task* task)
+{
+    if (!io_Loop_reachable(loop)) {
+        // Only the loop's own thread may send, the mailbox isn't needed
+        io_Loop_push_task(loop, task);
+        return;
+    }
+    if (!loop->shared_nothing) {
+        io_atomic_inc_explicit(loop->num_tasks, IO_RELAXED);
+    }
+    // Pairs with the store of mail_blocked and the load of mail_pending in io_Loop_collect_mail
+    io_atomic_inc(&loop->mail_pending);
+    io_TaskMpsc_push(&loop->mailbox, task);
+    if (io_atomic_exchange(&loop->mail_blocked, false)) {
+        io_Reactor_interrupt(loop->reactor);
+    }
+}
+
+/** io_Loop_collect_mail
+ * @brief Moves the sent tasks to the queue, called with the mutex held.
+ * @return Whether the reactor may block.
+ */
+IO_INLINE(bool)
+io_Loop_collect_mail(io_Loop* loop)
+{
+    io_Task* task;
+    while (io_atomic_load_explicit(&loop->mail_pending, IO_RELAXED) > 0 && (task = io_TaskMpsc_pop(&loop->mailbox))) {
+        if (loop->shared_nothing) {
+            // Only the loop's thread counts its tasks, the sender counted it in mail_pending
+            ++*loop->num_tasks;
+        }
+        io_atomic_dec_explicit(&loop->mail_pending, IO_RELAXED);
+        io_TaskQueue_push(&loop->queue, task);
+    }
+    if (!io_TaskQueue_empty(&loop->queue)) {
+        return false;
+    }
+    io_atomic_store(&loop->mail_blocked, true);
+    if (io_atomic_load(&loop->mail_pending) > 0) {
+        // A send is halfway done, don't block
+        io_atomic_store_explicit(&loop->mail_blocked, false, IO_RELAXED);
+        return false;
+    }
+    return true;
+}
+
+/** io_Loop_post_fn
+ * @brief Runs `fn` on the loop with a copy of `capture`. Captures of up to
+ * IO_FN_TASK_CAPTURE_SIZE bytes use the loop's pooled task slots, so
+ * posting doesn't allocate once the pool is warm.
+ */
+IO_INLINE(io_Err)
+io_Loop_post_fn(io_Loop* loop, io_PostFn fn, const void* capture, size_t capture_len)
+{
+    io_FnTask* task = io_FnTaskPool_acquire(&loop->fn_tasks, fn, capture, capture_len);
+    if (!task) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    io_Loop_push_task(loop, &task->base);
+    return IO_ERR_OK;
+}
+
+IO_INLINE(size_t)
+io_Loop_num_handles(io_Loop* loop)
+{
+    return io_atomic_load_if(!loop->single_threaded, &loop->num_handles, IO_RELAXED);
+}
+
+/** io_Loop_decay_busy
+ * @brief Folds `idle_ns` spent in the reactor into a busy ratio, as one
+ * idle window per IO_LOOP_BUSY_WINDOW_NS.
+ */
+IO_INLINE(unsigned)
+io_Loop_decay_busy(unsigned ratio, uint64_t idle_ns)
+{
+    for (uint64_t windows = idle_ns / IO_LOOP_BUSY_WINDOW_NS; windows > 0 && ratio > 0; --windows) {
+        ratio = ratio * 7 / 8;
+    }
+    return ratio;
+}
+
+/** io_Loop_busy_ratio
+ * @brief Recent share of time the loop spent running tasks rather than
+ * waiting in its reactor, from 0 to IO_LOOP_BUSY_SCALE. A loop blocked in
+ * its reactor doesn't update its average, so the time it has been waiting
+ * is folded in here, it reads as idle without waking the loop up.
+ */
+IO_INLINE(unsigned)
+io_Loop_busy_ratio(io_Loop* loop)
+{
+    bool shared = !loop->single_threaded;
+    // Pairs with the release in io_Loop_account_idle, an average that
+    // already covers the wait is never decayed twice
+    unsigned ratio = io_atomic_load_if(shared, &loop->busy_ratio, IO_ACQUIRE);
+    uint64_t since = io_atomic_load_if(shared, &loop->reactor_since, IO_RELAXED);
+    if (since == 0) {
+        return ratio;
+    }
+    uint64_t now = io_monotonic_ns();
+    return now > since ? io_Loop_decay_busy(ratio, now - since) : ratio;
+}
+
+/** io_Loop_account_busy
+ * @brief Called before the loop enters its reactor, adds the time since it
+ * left the reactor to the window and folds full windows into busy_ratio.
+ */
+IO_INLINE(void)
+io_Loop_account_busy(io_Loop* loop, uint64_t now)
+{
+    if (loop->window_start == 0) {
+        loop->window_start = now;
+    } else {
+        loop->busy_ns += now - loop->busy_since;
+    }
+    uint64_t window = now - loop->window_start;
+    if (window >= IO_LOOP_BUSY_WINDOW_NS) {
+        unsigned ratio = (unsigned)(loop->busy_ns * IO_LOOP_BUSY_SCALE / window);
+        bool shared = !loop->single_threaded;
+        unsigned average = io_atomic_load_if(shared, &loop->busy_ratio, IO_RELAXED);
+        io_atomic_store_if(shared, &loop->busy_ratio, (average * 7 + ratio) / 8, IO_RELAXED);
+        loop->busy_ns = 0;
+        loop->window_start = now;
+    }
+    io_atomic_store_if(!loop->single_threaded, &loop->reactor_since, now, IO_RELAXED);
+}
+
+/** io_Loop_account_idle
+ * @brief Called once the loop returned from its reactor. A wait of whole
+ * windows is folded into busy_ratio the way io_Loop_busy_ratio reported it
+ * meanwhile, and starts a new window.
+ */
+IO_INLINE(void)
+io_Loop_account_idle(io_Loop* loop, uint64_t now)
+{
+    bool shared = !loop->single_threaded;
+    uint64_t idle_ns = now - loop->reactor_since;
+    io_atomic_store_if(shared, &loop->reactor_since, 0, IO_RELAXED);
+    loop->busy_since = now;
+    if (idle_ns >= IO_LOOP_BUSY_WINDOW_NS) {
+        unsigned average = io_atomic_load_if(shared, &loop->busy_ratio, IO_RELAXED);
+        io_atomic_store_if(shared, &loop->busy_ratio, io_Loop_decay_busy(average, idle_ns), IO_RELEASE);
+        loop->busy_ns = 0;
+        loop->window_start = now;
+    }
+}
+
+/** io_Loop_stop
+ * @brief Makes the threads running the loop return once their current task
+ * finished, without waiting for the remaining tasks. Pending ops stay
+ * pending. May be called from any thread, the loop stays stopped until
+ * io_Loop_restart.
+ */
+IO_INLINE(void)
+io_Loop_stop(io_Loop* loop)
+{
+    io_atomic_store_if(io_Loop_reachable(loop), &loop->stopped, true, IO_RELEASE);
+    io_Reactor_interrupt(loop->reactor);
+    io_Mutex_lock(&loop->mutex);
+    io_Cond_broadcast(&loop->followers);
     io_Mutex_unlock(&loop->mutex);
 }
 
+IO_INLINE(bool)
+io_Loop_stopped(io_Loop* loop)
+{
+    return io_atomic_load_if(io_Loop_reachable(loop), &loop->stopped, IO_ACQUIRE);
+}
+
+/** io_Loop_restart
+ * @brief Undoes io_Loop_stop and io_Loop_drain, call it before running
+ * the loop again. Must not be called while the loop runs.
+ */
+IO_INLINE(void)
+io_Loop_restart(io_Loop* loop)
+{
+    bool shared = io_Loop_reachable(loop);
+    io_atomic_store_if(shared, &loop->stopped, false, IO_RELEASE);
+    io_atomic_store_if(shared, &loop->drain_deadline, 0, IO_RELEASE);
+    loop->drain_begun = false;
+}
+
+/** io_Loop_drain
+ * @brief Lets the ops pending on the loop's reactor run until `deadline`, in
+ * io_monotonic_ns time, and cancels the ones left after it. A shared-nothing
+ * loop also cancels its pending accepts at its next reactor turn. The loop
+ * then returns once the callbacks of the cancelled ops ran.
+ */
+IO_INLINE(void)
+io_Loop_drain(io_Loop* loop, uint64_t deadline)
+{
+    io_atomic_store_if(io_Loop_reachable(loop), &loop->drain_deadline, deadline, IO_RELEASE);
+    // A leader blocked in the reactor has to pick up the deadline
+    io_Reactor_interrupt(loop->reactor);
+}
+
+IO_INLINE(uint64_t)
+io_Loop_drain_deadline(io_Loop* loop)
+{
+    return io_atomic_load_if(io_Loop_reachable(loop), &loop->drain_deadline, IO_ACQUIRE);
+}
+
+/** io_Loop_bound_wait
+ * @brief Shortens the reactor wait of a draining loop, so that it wakes up at the deadline.
+ */
+IO_INLINE(io_Duration)
+io_Loop_bound_wait(io_Loop* loop, io_Duration wait, uint64_t now)
+{
+    uint64_t deadline = io_Loop_drain_deadline(loop);
+    if (deadline == 0 || wait == io_Seconds(0)) {
+        return wait;
+    }
+    uint64_t remaining_ms = deadline > now ? (deadline - now + 999999u) / 1000000u : 0;
+    io_Duration bound = io_Milliseconds((int)IO_MIN(remaining_ms, (uint64_t)INT32_MAX));
+    return wait == IO_TIMEOUT_INFINITE || bound < wait ? bound : wait;
+}
+
+/** io_Loop_check_drain
+ * @brief Called after each reactor turn, cancels all pending ops once the
+ * drain deadline passed. Ops the callbacks submit afterwards are cancelled
+ * on the next turn. Other threads can't reach the reactor of a shared-nothing
+ * loop, so it cancels its pending accepts itself once the drain began.
+ */
+IO_INLINE(void)
+io_Loop_check_drain(io_Loop* loop, uint64_t now)
+{
+    uint64_t deadline = io_Loop_drain_deadline(loop);
+    if (deadline == 0) {
+        return;
+    }
+    if (now >= deadline) {
+        io_Reactor_cancel_ops(loop->reactor, 0);
+    } else if (loop->shared_nothing && !loop->drain_begun) {
+        loop->drain_begun = true;
+        io_Reactor_cancel_ops(loop->reactor, IO_OP_ACCEPT);
+    }
+}
+
 IO_INLINE(void)
 io_Loop_run(io_Loop* loop)
 {
     IO_REQUIRE(loop->reactor, "Reactor must be set before running the loop");
-    while (io_Loop_get_task_count(loop) > 0) {
+    bool shared = !loop->single_threaded;
+    bool reachable = io_Loop_reachable(loop);
+    io_atomic_inc_if(shared, &loop->num_runners, IO_SEQ_CST);
+    while (io_Loop_get_task_count(loop) > 0 && !io_Loop_stopped(loop)) {
         while (1) {
             io_Mutex_lock(&loop->mutex);
             io_Task* task = io_TaskQueue_pop(&loop->queue);
-            IO_ASSERT(task, "Task queue must never be empty");
-            bool empty = io_TaskQueue_empty(&loop->queue);
+            if (!task) {
+                // Another thread leads, wait for the tasks its reactor queues
+                io_atomic_inc(&loop->num_waiting);
+                if (io_Loop_get_task_count(loop) > 0 && !io_Loop_stopped(loop)) {
+                    io_Cond_wait(&loop->followers, &loop->mutex);
+                }
+                io_atomic_dec(&loop->num_waiting);
+                io_Mutex_unlock(&loop->mutex);
+                break;
+            }
+            bool empty = task == &loop->reactor_task && reachable ? io_Loop_collect_mail(loop)
+                                                                  : io_TaskQueue_empty(&loop->queue);
             loop->needs_interrupt = empty;
             io_Mutex_unlock(&loop->mutex);
             if (task == &loop->reactor_task) {
-                io_Reactor_run(loop->reactor, io_Seconds(empty ? -1 : 0));
+                uint64_t now = io_monotonic_ns();
+                io_Loop_account_busy(loop, now);
+                io_Reactor_run(loop->reactor, io_Loop_bound_wait(loop, io_Seconds(empty ? -1 : 0), now));
+                io_atomic_store_if(reachable, &loop->mail_blocked, false, IO_RELAXED);
+                io_Loop_account_idle(loop, io_monotonic_ns());
+                io_Mutex_lock(&loop->mutex);
                 io_TaskQueue_push(&loop->queue, &loop->reactor_task);
+                if (loop->num_waiting) {
+                    // Hand the lead to a waiting thread while this one runs the events
+                    io_Cond_signal(&loop->followers);
+                }
+                io_Mutex_unlock(&loop->mutex);
+                io_Loop_check_drain(loop, loop->busy_since);
+                if (io_Loop_get_task_count(loop) == 0 || io_Loop_stopped(loop)) {
+                    // The remaining tasks ran on other loops, or the loop was stopped
+                    break;
+                }
             } else {
                 task->fn(task);
                 io_Loop_decrease_task_count(loop);
@@ -119,15 +593,110 @@ io_Loop_run(io_Loop* loop)
             }
         }
     }
+    io_atomic_dec_if(shared, &loop->num_runners, IO_SEQ_CST);
+    if (loop->sibling) {
+        io_Reactor_interrupt(loop->sibling->reactor);
+    }
+    if (io_atomic_load_if(shared, &loop->num_waiting, IO_SEQ_CST) > 0) {
+        // Followers of a loop whose last task ran on another loop wait for
+        // a leader that's gone, let them see that nothing is left
+        io_Mutex_lock(&loop->mutex);
+        io_Cond_broadcast(&loop->followers);
+        io_Mutex_unlock(&loop->mutex);
+    }
+}
+
+/** io_Loop_park
+ * @brief Called when a host stops driving the loop with io_Loop_run_some.
+ * Interrupts the reactor if tasks are left, so that the wait fd stays
+ * readable, and otherwise lets the next push interrupt it.
+ */
+IO_INLINE(void)
+io_Loop_park(io_Loop* loop)
+{
+    io_Mutex_lock(&loop->mutex);
+    bool idle = io_Loop_reachable(loop) ? io_Loop_collect_mail(loop) : io_TaskQueue_empty(&loop->queue);
+    loop->needs_interrupt = idle;
+    io_Mutex_unlock(&loop->mutex);
+    if (!idle) {
+        io_Reactor_interrupt(loop->reactor);
+    }
+}
+
+/** io_Loop_run_some
+ * @brief Runs at most `max_tasks` tasks on the calling thread, for hosts
+ * that drive the loop from their own event loop instead of io_Loop_run.
+ * When there's nothing to run, the loop waits in its reactor until
+ * `timeout` expired, a zero timeout never blocks. Once the timeout expired,
+ * the function returns at its next reactor turn, tasks queued meanwhile
+ * are left for the next call. Returns early once the loop is out of tasks.
+ * Must not be called while another thread runs the loop.
+ * @return The number of tasks that ran.
+ */
+IO_INLINE(size_t)
+io_Loop_run_some(io_Loop* loop, io_Duration timeout, size_t max_tasks)
+{
+    IO_REQUIRE(loop->reactor, "Reactor must be set before running the loop");
+    bool shared = !loop->single_threaded;
+    bool reachable = io_Loop_reachable(loop);
+    uint64_t deadline = timeout == IO_TIMEOUT_INFINITE
+                          ? UINT64_MAX
+                          : io_monotonic_ns() + (uint64_t)io_Duration_to_ms(timeout) * 1000000u;
+    bool polled = false; // Whether the reactor ran since the deadline passed
+    size_t ran = 0;
+    io_atomic_inc_if(shared, &loop->num_runners, IO_SEQ_CST);
+    while (ran < max_tasks && io_Loop_get_task_count(loop) > 0 && !io_Loop_stopped(loop)) {
+        io_Mutex_lock(&loop->mutex);
+        io_Task* task = io_TaskQueue_pop(&loop->queue);
+        IO_REQUIRE(task, "Loop is run by another thread");
+        if (task != &loop->reactor_task) {
+            io_Mutex_unlock(&loop->mutex);
+            task->fn(task);
+            io_Loop_decrease_task_count(loop);
+            ++ran;
+            continue;
+        }
+        bool idle = reachable ? io_Loop_collect_mail(loop) : io_TaskQueue_empty(&loop->queue);
+        uint64_t now = io_monotonic_ns();
+        if (polled && now >= deadline) {
+            io_TaskQueue_push(&loop->queue, &loop->reactor_task);
+            io_Mutex_unlock(&loop->mutex);
+            break;
+        }
+        loop->needs_interrupt = idle;
+        io_Mutex_unlock(&loop->mutex);
+        io_Duration wait = io_Seconds(0);
+        if (idle && now < deadline) {
+            uint64_t remaining_ms = (deadline - now + 999999u) / 1000000u;
+            wait = deadline == UINT64_MAX ? IO_TIMEOUT_INFINITE
+                                          : io_Milliseconds((int)IO_MIN(remaining_ms, (uint64_t)INT32_MAX));
+        }
+        io_Loop_account_busy(loop, now);
+        io_Reactor_run(loop->reactor, io_Loop_bound_wait(loop, wait, now));
+        io_atomic_store_if(reachable, &loop->mail_blocked, false, IO_RELAXED);
+        io_Loop_account_idle(loop, io_monotonic_ns());
+        polled = polled || loop->busy_since >= deadline;
+        io_Mutex_lock(&loop->mutex);
+        io_TaskQueue_push(&loop->queue, &loop->reactor_task);
+        io_Mutex_unlock(&loop->mutex);
+        io_Loop_check_drain(loop, loop->busy_since);
+    }
+    io_atomic_dec_if(shared, &loop->num_runners, IO_SEQ_CST);
+    io_Loop_park(loop);
+    return ran;
 }
 
 IO_INLINE(void)
 io_Loop_destroy(io_Loop* loop)
 {
+    IO_ASSERT(io_atomic_load(&loop->mail_pending) == 0, "Mail was sent to the loop after it stopped running");
+    io_Cond_deinit(&loop->followers);
     io_Mutex_deinit(&loop->mutex);
     if (loop->reactor)
         io_Reactor_destroy(loop->reactor);
-    io_free(loop->allocator, loop);
+    io_BufferPool_deinit(&loop->buffer_pool);
+    io_FnTaskPool_deinit(&loop->fn_tasks);
+    io_free(loop->allocator, loop->mem);
 }
 
 #endif
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_MPSC_H
+#define IO_MPSC_H
+
+#include <io/config.h>
+
+#include <io/atomic.h>
+#include <io/task.h>
+
+#include <stddef.h>
+
+/** io_TaskMpsc
+ * @brief Intrusive multi-producer single-consumer task queue after
+ * Dmitry Vyukov. Pushing is wait-free, popping may fail spuriously
+ * while a push is halfway done.
+ */
+typedef struct io_TaskMpsc {
+    io_Task* head; // Consumer side
+    io_Task* tail; // Producer side
+    io_Task stub;
+} io_TaskMpsc;
+
+IO_INLINE(void)
+io_TaskMpsc_init(io_TaskMpsc* queue)
+{
+    queue->stub.next = NULL;
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+}
+
+IO_INLINE(void)
+io_TaskMpsc_push(io_TaskMpsc* queue, io_Task* task)
+{
+    io_atomic_store(&task->next, NULL);
+    io_Task* prev = io_atomic_exchange(&queue->tail, task);
+    io_atomic_store(&prev->next, task);
+}
+
+IO_INLINE(io_Task*)
+io_TaskMpsc_pop(io_TaskMpsc* queue)
+{
+    io_Task* head = queue->head;
+    io_Task* next = io_atomic_load(&head->next);
+    if (head == &queue->stub) {
+        if (!next) {
+            return NULL;
+        }
+        queue->head = next;
+        head = next;
+        next = io_atomic_load(&next->next);
+    }
+    if (next) {
+        queue->head = next;
+        return head;
+    }
+    if (head != io_atomic_load(&queue->tail)) {
+        // A producer swapped the tail but didn't link it yet
+        return NULL;
+    }
+    io_TaskMpsc_push(queue, &queue->stub);
+    next = io_atomic_load(&head->next);
+    if (next) {
+        queue->head = next;
+        return head;
+    }
+    return NULL;
+}
+
+#endif
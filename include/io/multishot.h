@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_MULTISHOT_H
+#define IO_MULTISHOT_H
+
+#include <io/config.h>
+
+#include <io/atomic.h>
+#include <io/loop.h>
+#include <io/reactor.h>
+#include <io/task.h>
+
+#include <stdbool.h>
+
+/* Multishot ops (IO_OP_MULTISHOT) stay in their handle slot after
+ * readiness. The reactor pushes the op to its loop on every readiness
+ * event, unless it's still queued or running (IO_OP_QUEUED). The flag is
+ * only cleared by io_Multishot_end once the run is over, so with followers
+ * at most one thread performs the op at a time. Readiness seen meanwhile
+ * isn't lost, the poll is level-triggered and reports it again. The op
+ * ends in one of two ways:
+ * - it disarms itself on EOF or an error, io_Multishot_disarm.
+ * - it's aborted by cancel or a timeout, io_Multishot_abort marks it
+ *   completed and makes sure it runs once more on its loop to finalize,
+ *   or leaves that to io_Multishot_end if it's running.
+ * All runs of the op happen on the loop that owns the handle.
+ */
+
+/** io_Multishot_begin
+ * @brief Called first thing in the op's task function.
+ * @return true if the op was aborted and must be finalized.
+ */
+IO_INLINE(bool)
+io_Multishot_begin(io_Op* op)
+{
+    return (io_atomic_load(&op->flags) & IO_OP_COMPLETED) != 0;
+}
+
+/** io_Multishot_end
+ * @brief Called last thing in the op's task function if the op is still
+ * armed, lets the reactor queue it again.
+ * @return true if the op was aborted during the run and must be finalized.
+ */
+IO_INLINE(bool)
+io_Multishot_end(io_Op* op)
+{
+    return (io_atomic_fetch_and(&op->flags, ~IO_OP_QUEUED) & IO_OP_COMPLETED) != 0;
+}
+
+IO_INLINE(void)
+io_Multishot_abort(io_Op* op, io_Loop* loop)
+{
+    if (!(io_atomic_fetch_or(&op->flags, IO_OP_COMPLETED | IO_OP_QUEUED) & IO_OP_QUEUED)) {
+        io_Loop_push_task(loop, &op->base);
+    }
+}
+
+/** io_Multishot_disarm
+ * @brief Stops the op from within its task function.
+ * @return true if the op is now owned by the caller and may be freed,
+ * false if an abort got there first, io_Multishot_end then finalizes it.
+ */
+IO_INLINE(bool)
+io_Multishot_disarm(io_Op* op, io_Handle* handle)
+{
+    return io_Handle_disarm(handle, op);
+}
+
+#endif
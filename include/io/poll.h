@@ -10,6 +10,7 @@
 #include <io/config.h>
 
 #ifdef IO_WITH_POLL
+#include <io/atomic.h>
 #include <io/err.h>
 #include <io/hashmap.h>
 #include <io/loop.h>
@@ -29,6 +30,19 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+/* Consecutive misses after which submits stop trying the op speculatively */
+#ifndef IO_POLL_TRYIO_MISS_LIMIT
+#define IO_POLL_TRYIO_MISS_LIMIT 2
+#endif
+
+/* While speculation is off, every n-th submit probes anyway */
+#ifndef IO_POLL_TRYIO_PROBE_INTERVAL
+#define IO_POLL_TRYIO_PROBE_INTERVAL 8
+#endif
+
+/* Op type without a pollfd entry, see io_PollHandle.pfd_index */
+#define IO_POLL_NO_PFD SIZE_MAX
+
 /* forward declarations begin */
 
 typedef struct io_Poll io_Poll;
@@ -46,6 +60,12 @@ typedef struct io_PollHandle {
     io_Timer timer[IO_OP_MAX];
     io_Mutex mtx;
     int fd;
+    unsigned tryio_misses[IO_OP_MAX]; // Consecutive speculative misses
+    unsigned tryio_skips[IO_OP_MAX];  // Submits skipped since the last probe
+    size_t activity;                  // Ops dispatched, see io_Handle_activity
+    uint32_t wait_events;             // Events registered with the poll's wait fd
+    size_t pfd_index[IO_OP_MAX];      // Entry in the poll's fds, guarded by the fds lock
+    bool pfd_pending[IO_OP_MAX];      // Whether pfd_index refers to the pending entries
 } io_PollHandle;
 
 IO_INLINE(uint32_t)
@@ -69,6 +89,7 @@ io_PollHandleVec_deinit_entry(io_PollHandle** handle)
 IO_DEFINE_HASHMAP(io_FdToIdxMap, int, size_t, io_hash_fd, io_cmp_int, ((int)-1))
 IO_DEFINE_VEC(io_PollFdVec, struct pollfd, (void))
 IO_DEFINE_VEC(io_PollHandleVec, io_PollHandle*, io_PollHandleVec_deinit_entry)
+IO_DEFINE_VEC(io_PollOwnerVec, io_PollHandle*, (void))
 IO_DEFINE_OBJ_POOL(io_PollHandlePool, io_PollHandle, prev, next)
 
 /* io_poll_handle end */
@@ -124,6 +145,24 @@ cleanup:
     return err;
 }
 
+/* io_PollHandleMap_try_lock
+ * @brief Like io_PollHandleMap_try_get, but also locks the handle. Holding
+ * the map's lock meanwhile makes sure the handle isn't freed in between.
+ */
+IO_INLINE(io_PollHandle*)
+io_PollHandleMap_try_lock(io_PollHandleMap* map, int fd)
+{
+    io_Mutex_lock(&map->mtx);
+    io_PollHandle* handle = NULL;
+    io_FdToIdxMap_iter iter = io_FdToIdxMap_find(&map->map, fd);
+    if (iter) {
+        handle = *io_PollHandleVec_at(&map->handles, iter->value);
+        io_Mutex_lock(&handle->mtx);
+    }
+    io_Mutex_unlock(&map->mtx);
+    return handle;
+}
+
 /* io_PollHandleMap_try_get
  * @brief Get the poll handle for the given file descriptor.
  * @param map The handle map.
@@ -169,6 +208,8 @@ typedef struct io_PollTimer {
     io_Mutex mtx;
     io_Timer timer;
     bool armed;
+    int fd;               // timerfd in the wait fd, -1 until io_Poll_wait_fd
+    uint64_t fd_deadline; // When fd fires, in io_monotonic_ns time, 0 if it is disarmed
 } io_PollTimer;
 
 IO_INLINE(void)
@@ -177,6 +218,24 @@ io_PollTimer_init(io_PollTimer* timer)
     io_Mutex_init(&timer->mtx);
     io_Timer_init(&timer->timer, (io_Duration)0);
     timer->armed = false;
+    timer->fd = -1;
+    timer->fd_deadline = 0;
+}
+
+/** io_PollTimer_set_fd_deadline
+ * @brief Programs the timerfd to fire at `deadline`, or disarms it if 0.
+ * This also clears an expiration nobody read. Called with the lock held.
+ */
+IO_INLINE(void)
+io_PollTimer_set_fd_deadline(io_PollTimer* timer, uint64_t deadline)
+{
+#if IO_HAVE_EPOLL
+    struct itimerspec spec = {0};
+    spec.it_value.tv_sec = (time_t)(deadline / 1000000000u);
+    spec.it_value.tv_nsec = (long)(deadline % 1000000000u);
+    (void)io_timerfd_settime(timer->fd, TFD_TIMER_ABSTIME, &spec, NULL);
+#endif
+    timer->fd_deadline = deadline;
 }
 
 IO_INLINE(void)
@@ -189,6 +248,28 @@ io_PollTimer_update(io_PollTimer* timer, io_Duration duration)
         io_Timer_set(&timer->timer, duration);
         timer->armed = true;
     }
+    uint64_t deadline = (uint64_t)timer->timer.expire * 1000000000u;
+    if (timer->fd >= 0 && (timer->fd_deadline == 0 || deadline < timer->fd_deadline)) {
+        io_PollTimer_set_fd_deadline(timer, deadline);
+    }
+    io_Mutex_unlock(&timer->mtx);
+}
+
+/** io_PollTimer_sync_fd
+ * @brief Sets the timerfd to the earliest op timeout, or to `drain_deadline`
+ * if that comes first and hasn't passed yet. Called after each reactor run.
+ */
+IO_INLINE(void)
+io_PollTimer_sync_fd(io_PollTimer* timer, uint64_t drain_deadline)
+{
+    io_Mutex_lock(&timer->mtx);
+    if (timer->fd >= 0) {
+        uint64_t deadline = timer->armed ? (uint64_t)timer->timer.expire * 1000000000u : 0;
+        if (drain_deadline > io_monotonic_ns() && (deadline == 0 || drain_deadline < deadline)) {
+            deadline = drain_deadline;
+        }
+        io_PollTimer_set_fd_deadline(timer, deadline);
+    }
     io_Mutex_unlock(&timer->mtx);
 }
 
@@ -215,56 +296,202 @@ io_PollTimer_deinit(io_PollTimer* timer)
 /* io_PollFds begin */
 
 typedef struct io_PollFds {
-    io_PollFdVec fds;
-    io_PollFdVec pending_fds;
+    io_PollFdVec fds;               // Handed to poll(), the interrupt pipe comes first
+    io_PollOwnerVec owners;         // Handle of each entry in fds, NULL once it's gone
+    io_PollFdVec pending_fds;       // Armed while the reactor is busy with fds
+    io_PollOwnerVec pending_owners; // Handle of each pending entry
     io_Mutex mtx;
+    bool busy; // Between io_PollFds_begin and io_PollFds_end only the reactor moves entries
 } io_PollFds;
 
 IO_INLINE(void)
 io_PollFds_init(io_PollFds* fds, io_Allocator* allocator)
 {
     io_PollFdVec_init(&fds->fds, allocator);
+    io_PollOwnerVec_init(&fds->owners, allocator);
     io_PollFdVec_init(&fds->pending_fds, allocator);
+    io_PollOwnerVec_init(&fds->pending_owners, allocator);
     io_Mutex_init(&fds->mtx);
+    fds->busy = false;
 }
 
 IO_INLINE(void)
 io_PollFds_deinit(io_PollFds* fds)
 {
     io_PollFdVec_deinit(&fds->fds);
+    io_PollOwnerVec_deinit(&fds->owners);
     io_PollFdVec_deinit(&fds->pending_fds);
+    io_PollOwnerVec_deinit(&fds->pending_owners);
     io_Mutex_deinit(&fds->mtx);
 }
 
+/** io_PollFds_op_type
+ * @brief The op type an entry polls for, -1 for the interrupt pipe.
+ */
+IO_INLINE(int)
+io_PollFds_op_type(const struct pollfd* pfd)
+{
+    switch (pfd->events & (POLLIN | POLLOUT)) {
+    case POLLIN:
+        return IO_OP_READ;
+    case POLLOUT:
+        return IO_OP_WRITE;
+    default:
+        return -1;
+    }
+}
+
+/** io_PollFds_push
+ * @brief Appends an entry owned by `owner`, to the pending entries while the
+ * reactor is busy with fds. Called with the lock held.
+ */
 IO_INLINE(io_Err)
-io_PollFds_add_fd(io_PollFds* fds, struct pollfd pfd)
+io_PollFds_push(io_PollFds* fds, io_PollHandle* owner, struct pollfd pfd, size_t* index)
 {
+    io_PollFdVec* vec = fds->busy ? &fds->pending_fds : &fds->fds;
+    io_PollOwnerVec* owners = fds->busy ? &fds->pending_owners : &fds->owners;
+    io_Err err = io_PollFdVec_push_back(vec, pfd);
+    if (err) {
+        return err;
+    }
+    if ((err = io_PollOwnerVec_push_back(owners, owner))) {
+        io_PollFdVec_pop_back(vec);
+        return err;
+    }
+    *index = io_PollFdVec_size(vec) - 1;
+    return IO_ERR_OK;
+}
+
+/** io_PollFds_swap_remove
+ * @brief Removes the entry at `index` by moving the last one into its place.
+ * Called with the lock held.
+ */
+IO_INLINE(void)
+io_PollFds_swap_remove(io_PollFdVec* vec, io_PollOwnerVec* owners, size_t index)
+{
+    size_t last = io_PollFdVec_size(vec) - 1;
+    if (index != last) {
+        struct pollfd* moved_pfd = io_PollFdVec_at(vec, last);
+        io_PollHandle* moved = *io_PollOwnerVec_at(owners, last);
+        *io_PollFdVec_at(vec, index) = *moved_pfd;
+        *io_PollOwnerVec_at(owners, index) = moved;
+        if (moved) {
+            moved->pfd_index[io_PollFds_op_type(moved_pfd)] = index;
+        }
+    }
+    io_PollFdVec_resize(vec, last);
+    io_PollOwnerVec_resize(owners, last);
+}
+
+/** io_PollFds_arm
+ * @brief Makes sure the fd of `handle` is polled for the op `type`, called
+ * with the handle locked. An entry left behind by a cancelled op is reused.
+ */
+IO_INLINE(io_Err)
+io_PollFds_arm(io_PollFds* fds, io_PollHandle* handle, io_OpType type, struct pollfd pfd)
+{
+    io_Err err = IO_ERR_OK;
     io_Mutex_lock(&fds->mtx);
-    io_Err err = io_PollFdVec_push_back(&fds->pending_fds, pfd);
+    if (handle->pfd_index[type] == IO_POLL_NO_PFD) {
+        bool pending = fds->busy;
+        if (!(err = io_PollFds_push(fds, handle, pfd, &handle->pfd_index[type]))) {
+            handle->pfd_pending[type] = pending;
+        }
+    }
     io_Mutex_unlock(&fds->mtx);
     return err;
 }
 
+/** io_PollFds_disarm
+ * @brief Removes the entry of `handle` for the op `type` in O(1), called with
+ * the handle locked. While the reactor is busy with fds the entry stays in
+ * place and is dropped once poll() returns. `forget` detaches it from the
+ * handle anyway, for handles that are about to be freed.
+ */
+IO_INLINE(void)
+io_PollFds_disarm(io_PollFds* fds, io_PollHandle* handle, io_OpType type, bool forget)
+{
+    io_Mutex_lock(&fds->mtx);
+    size_t index = handle->pfd_index[type];
+    if (index == IO_POLL_NO_PFD) {
+        // Not polled
+    } else if (handle->pfd_pending[type]) {
+        io_PollFds_swap_remove(&fds->pending_fds, &fds->pending_owners, index);
+        handle->pfd_index[type] = IO_POLL_NO_PFD;
+    } else if (!fds->busy) {
+        IO_ASSERT(index > 0, "Must not remove the interrupt fd");
+        io_PollFds_swap_remove(&fds->fds, &fds->owners, index);
+        handle->pfd_index[type] = IO_POLL_NO_PFD;
+    } else if (forget) {
+        *io_PollOwnerVec_at(&fds->owners, index) = NULL;
+        handle->pfd_index[type] = IO_POLL_NO_PFD;
+    }
+    io_Mutex_unlock(&fds->mtx);
+}
+
+/** io_PollFds_begin
+ * @brief Merges the pending entries into fds and marks fds busy until
+ * io_PollFds_end, meanwhile new entries are pending and none are removed.
+ */
 IO_INLINE(io_Err)
-io_PollFds_update(io_PollFds* fds)
+io_PollFds_begin(io_PollFds* fds)
 {
-    io_Err err = IO_ERR_OK;
     io_Mutex_lock(&fds->mtx);
+    size_t size = io_PollFdVec_size(&fds->fds);
     size_t pending = io_PollFdVec_size(&fds->pending_fds);
+    io_Err err = io_PollFdVec_resize(&fds->fds, size + pending);
+    if (!err && (err = io_PollOwnerVec_resize(&fds->owners, size + pending))) {
+        io_PollFdVec_resize(&fds->fds, size);
+    }
+    if (err) {
+        goto cleanup;
+    }
     for (size_t i = 0; i < pending; i++) {
-        if ((err = io_PollFdVec_push_back(&fds->fds, *io_PollFdVec_at(&fds->pending_fds, i)))) {
-            break;
-        }
+        struct pollfd* pfd = io_PollFdVec_at(&fds->pending_fds, i);
+        io_PollHandle* owner = *io_PollOwnerVec_at(&fds->pending_owners, i);
+        int type = io_PollFds_op_type(pfd);
+        *io_PollFdVec_at(&fds->fds, size + i) = *pfd;
+        *io_PollOwnerVec_at(&fds->owners, size + i) = owner;
+        owner->pfd_index[type] = size + i;
+        owner->pfd_pending[type] = false;
     }
     io_PollFdVec_clear(&fds->pending_fds);
+    io_PollOwnerVec_clear(&fds->pending_owners);
+    fds->busy = true;
+cleanup:
     io_Mutex_unlock(&fds->mtx);
     return err;
 }
 
-IO_INLINE(io_PollFdVec*)
-io_PollFds_get(io_PollFds* fds)
+/** io_PollFds_end
+ * @brief Keeps the first `size` entries of fds, which the reactor compacted.
+ */
+IO_INLINE(void)
+io_PollFds_end(io_PollFds* fds, size_t size)
+{
+    io_Mutex_lock(&fds->mtx);
+    io_PollFdVec_resize(&fds->fds, size);
+    io_PollOwnerVec_resize(&fds->owners, size);
+    fds->busy = false;
+    io_Mutex_unlock(&fds->mtx);
+}
+
+/** io_PollFds_keep
+ * @brief Moves the entry at `from` of the handle to `to` while compacting,
+ * or drops it if `keep` is false. Called with the handle locked.
+ */
+IO_INLINE(void)
+io_PollFds_keep(io_PollFds* fds, io_PollHandle* handle, int type, size_t from, size_t to, bool keep)
 {
-    return &fds->fds;
+    io_Mutex_lock(&fds->mtx);
+    if (!keep) {
+        handle->pfd_index[type] = IO_POLL_NO_PFD;
+    } else if (to < from) {
+        *io_PollFdVec_at(&fds->fds, to) = *io_PollFdVec_at(&fds->fds, from);
+        *io_PollOwnerVec_at(&fds->owners, to) = handle;
+        handle->pfd_index[type] = to;
+    }
+    io_Mutex_unlock(&fds->mtx);
 }
 
 /* io_PollFds end */
@@ -275,28 +502,105 @@ struct io_Poll {
     io_Allocator* allocator;
     io_Loop* loop;
     io_PollHandlePool handle_allocator;
+    io_Mutex handle_allocator_mtx; // Handles are created and destroyed from any thread
     io_PollHandleMap handles;
     io_PollFds fds;
     io_PollTimer timer;
     int interrupt_fds[2];
+    size_t tryio_attempts;
+    size_t tryio_hits;
+    size_t tryio_skipped;
+    bool single_threaded; // Copied from the loop, no locks or atomics are needed then
+    int wait_fd;          // epoll fd mirroring the armed handles, -1 until io_Poll_wait_fd
 };
 
 /* th_poll_handle implementation begin */
 
+/** io_PollHandle_should_try
+ * @brief Whether to perform the op speculatively before waiting for readiness.
+ * Once the recent attempts for the op type missed, the attempt is skipped, except
+ * for a probe every IO_POLL_TRYIO_PROBE_INTERVAL submits. The counters are only
+ * a hint, so they are accessed with relaxed atomics and not under the handle lock.
+ */
+IO_INLINE(bool)
+io_PollHandle_should_try(io_PollHandle* handle, io_OpType type)
+{
+    bool shared = !handle->poll->single_threaded;
+    if (io_atomic_load_if(shared, &handle->tryio_misses[type], IO_RELAXED) < IO_POLL_TRYIO_MISS_LIMIT) {
+        return true;
+    }
+    if (io_atomic_inc_if(shared, &handle->tryio_skips[type], IO_RELAXED) >= IO_POLL_TRYIO_PROBE_INTERVAL) {
+        io_atomic_store_if(shared, &handle->tryio_skips[type], 0, IO_RELAXED);
+        return true;
+    }
+    return false;
+}
+
+IO_INLINE(void)
+io_PollHandle_record_try(io_PollHandle* handle, io_OpType type, bool hit)
+{
+    io_Poll* poll = handle->poll;
+    bool shared = !poll->single_threaded;
+    io_atomic_inc_if(shared, &poll->tryio_attempts, IO_RELAXED);
+    if (hit) {
+        io_atomic_inc_if(shared, &poll->tryio_hits, IO_RELAXED);
+        io_atomic_inc_if(shared, &handle->activity, IO_RELAXED);
+        io_atomic_store_if(shared, &handle->tryio_misses[type], 0, IO_RELAXED);
+    } else if (io_atomic_load_if(shared, &handle->tryio_misses[type], IO_RELAXED) < IO_POLL_TRYIO_MISS_LIMIT) {
+        io_atomic_inc_if(shared, &handle->tryio_misses[type], IO_RELAXED);
+    }
+}
+
+/** io_PollHandle_sync_wait
+ * @brief Mirrors the armed ops of the handle to the poll's wait fd, called
+ * with the handle locked whenever an op slot changes. A failed registration
+ * only means the host isn't woken for the fd, the reactor still polls it.
+ */
+IO_INLINE(void)
+io_PollHandle_sync_wait(io_PollHandle* handle)
+{
+#if IO_HAVE_EPOLL
+    int wait_fd = io_atomic_load_explicit(&handle->poll->wait_fd, IO_ACQUIRE);
+    if (wait_fd < 0) {
+        return;
+    }
+    uint32_t events = (handle->ops[IO_OP_READ] ? (uint32_t)EPOLLIN : 0u)
+                    | (handle->ops[IO_OP_WRITE] ? (uint32_t)EPOLLOUT : 0u);
+    if (events == handle->wait_events) {
+        return;
+    }
+    struct epoll_event event = {.events = events, .data.fd = handle->fd};
+    int op = events == 0 ? EPOLL_CTL_DEL : handle->wait_events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    if (io_epoll_ctl(wait_fd, op, handle->fd, &event) == 0 || op == EPOLL_CTL_DEL) {
+        handle->wait_events = events;
+    }
+#else
+    (void)handle;
+#endif
+}
+
 IO_INLINE(io_Err)
 io_PollHandle_submit(void* self, io_Op* op)
 {
     io_PollHandle* handle = (io_PollHandle*)self;
     io_Poll* poll = handle->poll;
-    io_Op_set_flags(op, IO_OP_TRYIO);
-    io_Op_perform(op);
-    if (io_Op_flags(op) & IO_OP_COMPLETED) {
-        return IO_ERR_OK;
+    if (io_Op_flags(op) & (IO_OP_NOTRY | IO_OP_MULTISHOT)) {
+        // Nothing to try, an attempt would only count as a miss
+    } else if (io_PollHandle_should_try(handle, op->type)) {
+        io_OpType tried_type = op->type;
+        io_Op_set_flags(op, IO_OP_TRYIO);
+        io_Op_perform(op);
+        if (io_Op_flags(op) & IO_OP_COMPLETED) {
+            io_PollHandle_record_try(handle, tried_type, true);
+            return IO_ERR_OK;
+        }
+        io_PollHandle_record_try(handle, tried_type, false);
+        io_Op_clear_flags(op, IO_OP_TRYIO);
+    } else {
+        io_atomic_inc_if(!poll->single_threaded, &poll->tryio_skipped, IO_RELAXED);
     }
-    io_Op_clear_flags(op, IO_OP_TRYIO);
     io_OpType op_type = op->type;
     io_Mutex_lock(&handle->mtx);
-    handle->ops[op_type] = op;
     struct pollfd pfd = {.fd = handle->fd, .events = 0};
     switch (op_type) {
     case IO_OP_READ:
@@ -309,19 +613,42 @@ io_PollHandle_submit(void* self, io_Op* op)
         IO_ASSERT(0, "Invalid operation type");
         break;
     }
+    io_Err err = io_PollFds_arm(&poll->fds, handle, op_type, pfd);
+    if (err) {
+        // The op is handed back to the caller
+        io_Mutex_unlock(&handle->mtx);
+        return err;
+    }
+    handle->ops[op_type] = op;
     if (handle->timeout[op_type] != IO_TIMEOUT_INFINITE) {
         io_Timer_set(&handle->timer[op_type], handle->timeout[op_type]);
         io_PollTimer_update(&poll->timer, handle->timeout[op_type]);
     }
+    io_PollHandle_sync_wait(handle);
     io_Mutex_unlock(&handle->mtx);
-    io_Err err = io_PollFds_add_fd(&poll->fds, pfd);
-    if (err) {
-        return err;
-    }
     io_Loop_increase_task_count(poll->loop);
     return IO_ERR_OK;
 }
 
+IO_INLINE(bool)
+io_PollHandle_disarm(void* self, io_Op* op)
+{
+    io_PollHandle* handle = self;
+    bool armed = false;
+    io_Mutex_lock(&handle->mtx);
+    if (handle->ops[op->type] == op) {
+        handle->ops[op->type] = NULL;
+        armed = true;
+        io_PollFds_disarm(&handle->poll->fds, handle, op->type, false);
+        io_PollHandle_sync_wait(handle);
+    }
+    io_Mutex_unlock(&handle->mtx);
+    if (armed) {
+        io_Loop_decrease_task_count(handle->poll->loop);
+    }
+    return armed;
+}
+
 IO_INLINE(void)
 io_PollHandle_set_timeout(void* self, io_OpType op_type, io_Duration duration)
 {
@@ -336,16 +663,38 @@ io_PollHandle_cancel(void* self)
 {
     io_PollHandle* handle = self;
     io_Mutex_lock(&handle->mtx);
-    for (int i = IO_OP_MAX; --i;) {
-        io_Op* op = IO_MOVE_PTR(handle->ops[i - 1]);
+    for (int i = IO_OP_MAX; i--;) {
+        io_Op* op = IO_MOVE_PTR(handle->ops[i]);
         if (op) {
             io_Op_abort(op, io_SystemErr(IO_ECANCELED));
             io_Loop_decrease_task_count(handle->poll->loop);
+            io_PollFds_disarm(&handle->poll->fds, handle, (io_OpType)i, false);
         }
     }
+    io_PollHandle_sync_wait(handle);
     io_Mutex_unlock(&handle->mtx);
 }
 
+IO_INLINE(bool)
+io_PollHandle_cancel_op(void* self, io_OpType type, uint64_t seq)
+{
+    io_PollHandle* handle = self;
+    io_Mutex_lock(&handle->mtx);
+    io_Op* op = handle->ops[type];
+    // The slot owns the op, so it's alive while we hold the lock. Once the
+    // reactor took it out of the slot the op is on its way to complete.
+    bool found = op && op->seq == seq;
+    if (found) {
+        handle->ops[type] = NULL;
+        io_Op_abort(op, io_SystemErr(IO_ECANCELED));
+        io_Loop_decrease_task_count(handle->poll->loop);
+        io_PollFds_disarm(&handle->poll->fds, handle, type, false);
+        io_PollHandle_sync_wait(handle);
+    }
+    io_Mutex_unlock(&handle->mtx);
+    return found;
+}
+
 IO_INLINE(int)
 io_PollHandle_get_fd(const void* self)
 {
@@ -353,13 +702,88 @@ io_PollHandle_get_fd(const void* self)
     return handle->fd;
 }
 
+IO_INLINE(void)
+io_Poll_free_handle(io_Poll* poll, io_PollHandle* handle)
+{
+    // Wait for a reactor run that looked the handle up before it was removed
+    io_Mutex_lock(&handle->mtx);
+    io_Mutex_unlock(&handle->mtx);
+    io_Mutex_deinit(&handle->mtx);
+    io_Mutex_lock(&poll->handle_allocator_mtx);
+    io_Allocator_free(&poll->handle_allocator.base, handle);
+    io_Mutex_unlock(&poll->handle_allocator_mtx);
+}
+
+/** io_PollHandle_unwait
+ * @brief Drops the fd from the wait fd before it's closed.
+ */
+IO_INLINE(void)
+io_PollHandle_unwait(io_PollHandle* handle)
+{
+#if IO_HAVE_EPOLL
+    io_Mutex_lock(&handle->mtx);
+    int wait_fd = io_atomic_load_explicit(&handle->poll->wait_fd, IO_ACQUIRE);
+    if (wait_fd >= 0 && handle->wait_events) {
+        struct epoll_event event = {.events = 0, .data.fd = handle->fd};
+        (void)io_epoll_ctl(wait_fd, EPOLL_CTL_DEL, handle->fd, &event);
+        handle->wait_events = 0;
+    }
+    io_Mutex_unlock(&handle->mtx);
+#else
+    (void)handle;
+#endif
+}
+
+/** io_PollHandle_forget
+ * @brief Detaches the pollfd entries from the handle before it's freed,
+ * called with the handle locked.
+ */
+IO_INLINE(void)
+io_PollHandle_forget(io_PollHandle* handle)
+{
+    for (int type = IO_OP_MAX; type--;) {
+        io_PollFds_disarm(&handle->poll->fds, handle, (io_OpType)type, true);
+    }
+}
+
 IO_INLINE(void)
 io_PollHandle_destroy(void* self)
 {
     io_PollHandle* handle = self;
+    io_PollHandle_unwait(handle);
+    io_Mutex_lock(&handle->mtx);
+    io_PollHandle_forget(handle);
+    io_Mutex_unlock(&handle->mtx);
     io_PollHandleMap_remove(&handle->poll->handles, handle->fd);
-    close(handle->fd);
-    io_Allocator_free(&handle->poll->handle_allocator.base, self);
+    io_close(handle->fd);
+    io_Poll_free_handle(handle->poll, handle);
+}
+
+IO_INLINE(bool)
+io_PollHandle_release(void* self, io_HandleState* state)
+{
+    io_PollHandle* handle = self;
+    io_Mutex_lock(&handle->mtx);
+    for (size_t idx = IO_OP_MAX; idx--;) {
+        if (handle->ops[idx]) {
+            io_Mutex_unlock(&handle->mtx);
+            return false;
+        }
+        state->timeout[idx] = handle->timeout[idx];
+    }
+    state->fd = handle->fd;
+    io_PollHandle_forget(handle);
+    io_Mutex_unlock(&handle->mtx);
+    io_PollHandleMap_remove(&handle->poll->handles, handle->fd);
+    io_Poll_free_handle(handle->poll, handle);
+    return true;
+}
+
+IO_INLINE(size_t)
+io_PollHandle_activity(const void* self)
+{
+    io_PollHandle* handle = (io_PollHandle*)self;
+    return io_atomic_load_explicit(&handle->activity, IO_RELAXED);
 }
 
 IO_INLINE(void)
@@ -379,22 +803,37 @@ io_PollHandle_init(io_PollHandle* handle, io_Poll* poll, int fd)
 {
     static io_HandleMethods methods = {
         .submit = io_PollHandle_submit,
+        .disarm = io_PollHandle_disarm,
         .cancel = io_PollHandle_cancel,
+        .cancel_op = io_PollHandle_cancel_op,
         .destroy = io_PollHandle_destroy,
+        .release = io_PollHandle_release,
+        .activity = io_PollHandle_activity,
         .set_timeout = io_PollHandle_set_timeout,
         .get_fd = io_PollHandle_get_fd,
     };
     handle->base.methods = &methods;
-    for (size_t idx = IO_OP_MAX - 1; idx--;) {
+    for (size_t idx = IO_OP_MAX; idx--;) {
         handle->ops[idx] = NULL;
     }
     handle->poll = poll;
     handle->fd = fd;
+    handle->activity = 0;
+    handle->wait_events = 0;
     handle->timeout[0] = IO_TIMEOUT_INFINITE;
     handle->timeout[1] = IO_TIMEOUT_INFINITE;
     io_Timer_init(&handle->timer[0], IO_TIMEOUT_INFINITE);
     io_Timer_init(&handle->timer[1], IO_TIMEOUT_INFINITE);
+    for (size_t idx = IO_OP_MAX; idx--;) {
+        handle->tryio_misses[idx] = 0;
+        handle->tryio_skips[idx] = 0;
+        handle->pfd_index[idx] = IO_POLL_NO_PFD;
+        handle->pfd_pending[idx] = false;
+    }
     io_Mutex_init(&handle->mtx);
+    if (poll->single_threaded) {
+        io_Mutex_elide(&handle->mtx);
+    }
 }
 
 /* th_poll_handle implementation end */
@@ -403,7 +842,9 @@ IO_INLINE(io_Handle*)
 io_Poll_create_handle(void* self, int fd)
 {
     io_Poll* poll = self;
+    io_Mutex_lock(&poll->handle_allocator_mtx);
     io_PollHandle* handle = io_Allocator_alloc(&poll->handle_allocator.base, sizeof(io_PollHandle));
+    io_Mutex_unlock(&poll->handle_allocator_mtx);
     if (!handle)
         return NULL;
     io_PollHandle_init(handle, poll, fd);
@@ -415,28 +856,30 @@ IO_INLINE(io_Err)
 io_Poll_run(void* self, io_Duration timeout)
 {
     io_Poll* service = self;
-    if (timeout == IO_TIMEOUT_INFINITE) {
-        io_Duration earliest = io_PollTimer_retrieve(&service->timer);
-        if (earliest != IO_TIMEOUT_INFINITE) {
-            timeout = earliest;
-        }
+    bool shared = !service->single_threaded;
+    io_Duration earliest = io_PollTimer_retrieve(&service->timer);
+    if (earliest != IO_TIMEOUT_INFINITE && (timeout == IO_TIMEOUT_INFINITE || earliest < timeout)) {
+        timeout = earliest;
     }
     int timeout_ms = io_Duration_to_ms(timeout);
-    io_Err err = io_PollFds_update(&service->fds);
+    io_Err err = io_PollFds_begin(&service->fds);
     if (err) {
         return err;
     }
-    io_PollFdVec* fds = io_PollFds_get(&service->fds);
+    io_PollFdVec* fds = &service->fds.fds;
     nfds_t nfds = (nfds_t)io_PollFdVec_size(fds);
     int ret = io_poll(io_PollFdVec_begin(fds), nfds, timeout_ms);
-    if (ret <= 0) {
+    // A poll that timed out because of an op timeout still has to expire the op
+    if (ret < 0 || (ret == 0 && earliest == IO_TIMEOUT_INFINITE)) {
+        io_PollFds_end(&service->fds, nfds);
+        io_PollTimer_sync_fd(&service->timer, io_Loop_drain_deadline(service->loop));
         return IO_ERR_OK;
     }
 
     if (io_PollFdVec_begin(fds)->revents & POLLIN) {
         IO_ASSERT(io_PollFdVec_begin(fds)->fd == service->interrupt_fds[0], "Invalid interrupt fd");
         char c[512];
-        (void)read(service->interrupt_fds[0], &c, sizeof(c));
+        (void)io_read(service->interrupt_fds[0], &c, sizeof(c));
     }
 
     size_t reenqueue = 1;
@@ -444,25 +887,35 @@ io_Poll_run(void* self, io_Duration timeout)
         struct pollfd* pfd = io_PollFdVec_at(fds, i);
         short revents = pfd->revents;
         short events = pfd->events & (POLLIN | POLLOUT);
-        int op_index = 0;
-        switch (events) {
-        case POLLIN:
-            op_index = IO_OP_READ;
-            break;
-        case POLLOUT:
-            op_index = IO_OP_WRITE;
-            break;
-        default:
+        int op_index = io_PollFds_op_type(pfd);
+        if (op_index < 0) {
             continue;
-            break;
         }
-        io_PollHandle* handle = io_PollHandleMap_try_get(&service->handles, pfd->fd);
+        io_PollHandle* handle = io_PollHandleMap_try_lock(&service->handles, pfd->fd);
         if (!handle) // handle was removed
             continue;
-        io_PollHandle_lock(handle);
+        // While fds is busy the owner only changes under the handle's lock
+        if (*io_PollOwnerVec_at(&service->fds.owners, i) != handle) {
+            // Left behind by a freed handle whose fd was reused
+            io_PollHandle_unlock(handle);
+            continue;
+        }
+        bool keep = false;
         io_Op* op = handle->ops[op_index];
-        if (revents && op) {
+        if (op && (revents & events) && (io_Op_flags(op) & IO_OP_MULTISHOT)) {
+            // Multishot ops stay armed, they are queued at most once
+            if (!(io_atomic_fetch_or_explicit(&op->flags, IO_OP_QUEUED, IO_ACQ_REL) & IO_OP_QUEUED)) {
+                io_atomic_inc_if(shared, &handle->activity, IO_RELAXED);
+                io_Loop_push_task(service->loop, &op->base);
+            }
+            if (handle->timeout[op_index] != IO_TIMEOUT_INFINITE) {
+                io_Timer_set(&handle->timer[op_index], handle->timeout[op_index]);
+                io_PollTimer_update(&service->timer, handle->timeout[op_index]);
+            }
+            keep = true;
+        } else if (revents && op) {
             if (revents & events) {
+                io_atomic_inc_if(shared, &handle->activity, IO_RELAXED);
                 io_Loop_push_task(service->loop, &op->base);
             } else if (revents & POLLHUP) {
                 io_Op_abort(op, IO_ERR_EOF);
@@ -485,15 +938,18 @@ io_Poll_run(void* self, io_Duration timeout)
                 if (handle->timeout[op_index] != IO_TIMEOUT_INFINITE) {
                     io_PollTimer_update(&service->timer, handle->timeout[op_index]);
                 }
-                if (reenqueue < i) {
-                    *io_PollFdVec_at(fds, reenqueue) = *pfd;
-                }
-                ++reenqueue;
+                keep = true;
             }
         }
+        io_PollFds_keep(&service->fds, handle, op_index, i, reenqueue, keep);
+        if (keep) {
+            ++reenqueue;
+        }
+        io_PollHandle_sync_wait(handle);
         io_PollHandle_unlock(handle);
     }
-    io_PollFdVec_resize(fds, reenqueue);
+    io_PollFds_end(&service->fds, reenqueue);
+    io_PollTimer_sync_fd(&service->timer, io_Loop_drain_deadline(service->loop));
     return IO_ERR_OK;
 }
 
@@ -505,12 +961,114 @@ io_Poll_interrupt(void* self)
     (void)io_write(service->interrupt_fds[1], &c, 1);
 }
 
+IO_INLINE(void)
+io_Poll_tryio_stats(void* self, io_TryIoStats* stats)
+{
+    io_Poll* service = self;
+    bool shared = !service->single_threaded;
+    stats->attempts += io_atomic_load_if(shared, &service->tryio_attempts, IO_RELAXED);
+    stats->hits += io_atomic_load_if(shared, &service->tryio_hits, IO_RELAXED);
+    stats->skipped += io_atomic_load_if(shared, &service->tryio_skipped, IO_RELAXED);
+}
+
+IO_INLINE(size_t)
+io_Poll_cancel_ops(void* self, io_OpFlags flags)
+{
+    io_Poll* service = self;
+    size_t cancelled = 0;
+    // The map's lock keeps the handles from being freed meanwhile, like in io_PollHandleMap_try_lock
+    io_Mutex_lock(&service->handles.mtx);
+    for (size_t i = 0; i < io_PollHandleVec_size(&service->handles.handles); ++i) {
+        io_PollHandle* handle = *io_PollHandleVec_at(&service->handles.handles, i);
+        io_Mutex_lock(&handle->mtx);
+        for (int type = IO_OP_MAX; type--;) {
+            io_Op* op = handle->ops[type];
+            if (op && (io_Op_flags(op) & flags) == flags) {
+                handle->ops[type] = NULL;
+                io_Op_abort(op, io_SystemErr(IO_ECANCELED));
+                io_Loop_decrease_task_count(service->loop);
+                io_PollFds_disarm(&service->fds, handle, (io_OpType)type, false);
+                ++cancelled;
+            }
+        }
+        io_PollHandle_sync_wait(handle);
+        io_Mutex_unlock(&handle->mtx);
+    }
+    io_Mutex_unlock(&service->handles.mtx);
+    return cancelled;
+}
+
+/** io_Poll_wait_fd
+ * @brief Creates the wait fd on first use: an epoll fd that holds the
+ * interrupt pipe, a timerfd set to the earliest op timeout or drain
+ * deadline and, from then on, the fds of all armed handles. Call it
+ * from the thread that drives the loop.
+ */
+IO_INLINE(int)
+io_Poll_wait_fd(void* self)
+{
+    io_Poll* service = self;
+#if IO_HAVE_EPOLL
+    if (service->wait_fd >= 0) {
+        return service->wait_fd;
+    }
+    int wait_fd = io_epoll_create1(EPOLL_CLOEXEC);
+    if (wait_fd < 0) {
+        return -1;
+    }
+    int timer_fd = -1;
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = service->interrupt_fds[0]};
+    if (io_epoll_ctl(wait_fd, EPOLL_CTL_ADD, service->interrupt_fds[0], &event) != 0) {
+        goto on_err;
+    }
+    timer_fd = io_timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        goto on_err;
+    }
+    event = (struct epoll_event){.events = EPOLLIN, .data.fd = timer_fd};
+    if (io_epoll_ctl(wait_fd, EPOLL_CTL_ADD, timer_fd, &event) != 0) {
+        io_close(timer_fd);
+        goto on_err;
+    }
+    io_Mutex_lock(&service->timer.mtx);
+    service->timer.fd = timer_fd;
+    io_Mutex_unlock(&service->timer.mtx);
+    io_PollTimer_sync_fd(&service->timer, io_Loop_drain_deadline(service->loop));
+    io_atomic_store_explicit(&service->wait_fd, wait_fd, IO_RELEASE);
+    // Handles armed from now on register themselves, catch up with the others
+    if (io_PollFds_begin(&service->fds) == IO_ERR_OK) {
+        io_PollFdVec* fds = &service->fds.fds;
+        size_t nfds = io_PollFdVec_size(fds);
+        for (size_t i = 1; i < nfds; ++i) {
+            io_PollHandle* handle = io_PollHandleMap_try_lock(&service->handles, io_PollFdVec_at(fds, i)->fd);
+            if (handle) {
+                io_PollHandle_sync_wait(handle);
+                io_PollHandle_unlock(handle);
+            }
+        }
+        io_PollFds_end(&service->fds, nfds);
+    }
+    return wait_fd;
+on_err:
+    io_close(wait_fd);
+    return -1;
+#else
+    (void)service;
+    return -1;
+#endif
+}
+
 IO_INLINE(void)
 io_Poll_destroy(void* self)
 {
     io_Poll* service = self;
+    if (service->wait_fd >= 0) {
+        io_close(service->wait_fd);
+        io_close(service->timer.fd);
+    }
     io_PollHandleMap_deinit(&service->handles);
     io_PollHandlePool_deinit(&service->handle_allocator);
+    io_Mutex_deinit(&service->handle_allocator_mtx);
     io_PollFds_deinit(&service->fds);
     io_PollTimer_deinit(&service->timer);
     io_close(service->interrupt_fds[0]);
@@ -529,8 +1087,16 @@ io_Poll_create(io_Reactor** out, io_Loop* loop, io_Allocator* allocator)
     service->base.destroy = io_Poll_destroy;
     service->base.create_handle = io_Poll_create_handle;
     service->base.interrupt = io_Poll_interrupt;
+    service->base.tryio_stats = io_Poll_tryio_stats;
+    service->base.wait_fd = io_Poll_wait_fd;
+    service->base.cancel_ops = io_Poll_cancel_ops;
+    service->wait_fd = -1;
     service->allocator = allocator;
     service->loop = loop;
+    service->tryio_attempts = 0;
+    service->tryio_hits = 0;
+    service->tryio_skipped = 0;
+    service->single_threaded = loop->single_threaded;
     io_Err err = IO_ERR_OK;
     if (io_pipe(service->interrupt_fds) == -1) {
         err = io_SystemErr(errno);
@@ -538,15 +1104,24 @@ io_Poll_create(io_Reactor** out, io_Loop* loop, io_Allocator* allocator)
     }
     io_PollFds_init(&service->fds, allocator);
     struct pollfd pfd = {.fd = service->interrupt_fds[0], .events = POLLIN};
-    if ((err = io_PollFds_add_fd(&service->fds, pfd))) {
+    size_t interrupt_index = 0;
+    if ((err = io_PollFds_push(&service->fds, NULL, pfd, &interrupt_index))) {
         goto on_PollFds_err;
     }
     io_PollHandleMap_init(&service->handles, allocator);
     io_PollHandlePool_init(&service->handle_allocator, allocator, 16, 8 * 1024);
+    io_Mutex_init(&service->handle_allocator_mtx);
     io_PollTimer_init(&service->timer);
+    if (service->single_threaded) {
+        io_Mutex_elide(&service->fds.mtx);
+        io_Mutex_elide(&service->handles.mtx);
+        io_Mutex_elide(&service->handle_allocator_mtx);
+        io_Mutex_elide(&service->timer.mtx);
+    }
     *out = &service->base;
     return IO_ERR_OK;
 on_PollFds_err:
+    io_PollFds_deinit(&service->fds);
     io_close(service->interrupt_fds[0]);
     io_close(service->interrupt_fds[1]);
 on_pipe_err:
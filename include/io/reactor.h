@@ -16,12 +16,24 @@
 
 #define IO_TIMEOUT_INFINITE ((io_Duration)(-1))
 
+/** io_HandleState
+ * @brief What a handle hands over when it's released, see io_Handle_release.
+ */
+typedef struct io_HandleState {
+    int fd;
+    io_Duration timeout[IO_OP_MAX];
+} io_HandleState;
+
 typedef struct io_HandleMethods {
     void (*cancel)(void* self);
+    bool (*cancel_op)(void* self, io_OpType type, uint64_t seq);
     io_Err (*submit)(void* self, io_Op* op);
+    bool (*disarm)(void* self, io_Op* op);
     void (*set_timeout)(void* self, io_OpType type, io_Duration duration);
     int (*get_fd)(const void* self);
     void (*destroy)(void* self);
+    bool (*release)(void* self, io_HandleState* state);
+    size_t (*activity)(const void* self);
 } io_HandleMethods;
 
 typedef struct io_Handle {
@@ -34,12 +46,39 @@ io_Handle_cancel(io_Handle* io_handle)
     io_handle->methods->cancel(io_handle);
 }
 
+/** io_Handle_submit
+ * @brief Hands `op` to the handle. If it fails, the handle didn't take
+ * the op and the caller still owns it.
+ */
 IO_INLINE(io_Err)
 io_Handle_submit(io_Handle* io_handle, io_Op* iot)
 {
     return io_handle->methods->submit(io_handle, iot);
 }
 
+/** io_Handle_cancel_op
+ * @brief Aborts the op of `type` with ECANCELED if it's still pending and
+ * carries `seq`, other ops on the handle are left alone. The fd is no longer
+ * polled for the op, unless the reactor is inside poll() at that moment: then
+ * it's dropped as soon as poll() returns.
+ * @return true if the op was cancelled.
+ */
+IO_INLINE(bool)
+io_Handle_cancel_op(io_Handle* io_handle, io_OpType type, uint64_t seq)
+{
+    return io_handle->methods->cancel_op(io_handle, type, seq);
+}
+
+/** io_Handle_disarm
+ * @brief Removes a multishot op from the handle, returns false if
+ * the op isn't armed anymore (it was cancelled or timed out).
+ */
+IO_INLINE(bool)
+io_Handle_disarm(io_Handle* io_handle, io_Op* op)
+{
+    return io_handle->methods->disarm(io_handle, op);
+}
+
 IO_INLINE(int)
 io_Handle_get_fd(const io_Handle* io_handle)
 {
@@ -52,17 +91,50 @@ io_Handle_set_timeout(io_Handle* io_handle, io_OpType type, io_Duration duration
     io_handle->methods->set_timeout(io_handle, type, duration);
 }
 
+/** io_Handle_release
+ * @brief Removes the handle from its reactor without closing the fd, the fd
+ * and settings are written to `state`. Fails if an op is pending.
+ */
+IO_INLINE(bool)
+io_Handle_release(io_Handle* io_handle, io_HandleState* state)
+{
+    return io_handle->methods->release(io_handle, state);
+}
+
+/** io_Handle_activity
+ * @brief Number of ops the handle dispatched so far, a measure of how hot it is.
+ */
+IO_INLINE(size_t)
+io_Handle_activity(const io_Handle* io_handle)
+{
+    return io_handle->methods->activity(io_handle);
+}
+
 IO_INLINE(void)
 io_Handle_destroy(io_Handle* io_handle)
 {
     io_handle->methods->destroy(io_handle);
 }
 
+/** io_TryIoStats
+ * @brief Counts the speculative attempts made on submit. `attempts - hits`
+ * is the number of syscalls that found the fd not ready, `skipped` the
+ * number of attempts that were left out because recent ones missed.
+ */
+typedef struct io_TryIoStats {
+    size_t attempts;
+    size_t hits;
+    size_t skipped;
+} io_TryIoStats;
+
 typedef struct io_Reactor {
     io_Err (*run)(void* self, io_Duration timeout);
     io_Handle* (*create_handle)(void* self, int fd);
     void (*interrupt)(void* self);
     void (*destroy)(void* self);
+    void (*tryio_stats)(void* self, io_TryIoStats* stats);
+    int (*wait_fd)(void* self);
+    size_t (*cancel_ops)(void* self, io_OpFlags flags);
 } io_Reactor;
 
 IO_INLINE(io_Err)
@@ -83,6 +155,37 @@ io_Reactor_interrupt(io_Reactor* io_service)
     io_service->interrupt(io_service);
 }
 
+/** io_Reactor_tryio_stats
+ * @brief Adds the reactor's speculation counters to `stats`.
+ */
+IO_INLINE(void)
+io_Reactor_tryio_stats(io_Reactor* io_service, io_TryIoStats* stats)
+{
+    if (io_service->tryio_stats)
+        io_service->tryio_stats(io_service, stats);
+}
+
+/** io_Reactor_wait_fd
+ * @brief A pollable fd that becomes readable when the reactor has events
+ * or was interrupted, -1 if the reactor has none. Owned by the reactor.
+ */
+IO_INLINE(int)
+io_Reactor_wait_fd(io_Reactor* io_service)
+{
+    return io_service->wait_fd ? io_service->wait_fd(io_service) : -1;
+}
+
+/** io_Reactor_cancel_ops
+ * @brief Aborts the pending ops of all handles that carry all of `flags`
+ * with ECANCELED, every pending op if `flags` is 0.
+ * @return The number of ops that were cancelled.
+ */
+IO_INLINE(size_t)
+io_Reactor_cancel_ops(io_Reactor* io_service, io_OpFlags flags)
+{
+    return io_service->cancel_ops ? io_service->cancel_ops(io_service, flags) : 0;
+}
+
 IO_INLINE(void)
 io_Reactor_destroy(io_Reactor* io_service)
 {
@@ -10,8 +10,11 @@
 #include <io/config.h>
 
 #include <io/assert.h>
+#include <io/buffer_pool.h>
+#include <io/read_sizer.h>
 #include <io/context.h>
 #include <io/descriptor.h>
+#include <io/multishot.h>
 #include <io/system_call.h>
 #include <io/system_err.h>
 #include <io/task.h>
@@ -24,6 +27,7 @@ typedef void (*io_ReadCallback)(void* user_data, size_t size, io_Err err);
 
 typedef struct io_ReadOp {
     io_Op base;
+    io_Allocator* allocator;
     io_Descriptor* socket;
     io_ReadCallback callback;
     void* addr;
@@ -47,7 +51,7 @@ io_perform_read(io_Descriptor* socket, void* addr, size_t* size)
 IO_INLINE(void)
 io_ReadOp_finalize(io_ReadOp* op)
 {
-    io_Allocator* allocator = io_Descriptor_get_context(op->socket)->allocator;
+    io_Allocator* allocator = op->allocator;
     op->callback(op->user_data, op->size, op->err);
     io_Allocator_free(allocator, op);
 }
@@ -58,7 +62,7 @@ io_ReadOp_complete(io_ReadOp* op, size_t size, io_Err err)
     op->err = err;
     op->size = size;
     io_Op_set_flags(&op->base, IO_OP_COMPLETED);
-    io_Context_post(io_Descriptor_get_context(op->socket), &op->base.base);
+    io_Context_post_completion(io_Descriptor_get_context(op->socket), &op->base.base);
 }
 
 IO_INLINE(void)
@@ -96,10 +100,12 @@ io_ReadOp_abort(void* self, io_Err err)
 IO_INLINE(io_ReadOp*)
 io_ReadOp_create(io_Descriptor* socket, void* addr, size_t size, io_ReadCallback callback, void* user_data)
 {
-    io_ReadOp* op = io_Allocator_alloc(io_Descriptor_get_context(socket)->allocator, sizeof(io_ReadOp));
+    io_Allocator* allocator = io_Descriptor_allocator(socket);
+    io_ReadOp* op = io_Allocator_alloc(allocator, sizeof(io_ReadOp));
     if (!op)
         return NULL;
     io_Op_init(&op->base, IO_OP_READ, io_ReadOp_fn, io_ReadOp_abort);
+    op->allocator = allocator;
     op->socket = socket;
     op->addr = addr;
     op->size = size;
@@ -108,4 +114,283 @@ io_ReadOp_create(io_Descriptor* socket, void* addr, size_t size, io_ReadCallback
     return op;
 }
 
+typedef void (*io_PooledReadCallback)(void* user_data, io_Buffer* buffer, io_Err err);
+
+/** io_PooledReadOp
+ * @brief Read op that holds no buffer while waiting. A buffer is taken
+ * from the descriptor's loop pool only when the read is attempted and
+ * goes straight back if the read would block. On success the callback
+ * owns a reference to the buffer and must release it.
+ * With a `sizer` the read size adapts to the traffic, reads larger
+ * than the pool's buffers get a buffer of their own.
+ */
+typedef struct io_PooledReadOp {
+    io_Op base;
+    io_Allocator* allocator;
+    io_Descriptor* socket;
+    io_ReadSizer* sizer;
+    io_PooledReadCallback callback;
+    void* user_data;
+    io_Buffer* buffer;
+    io_Err err;
+} io_PooledReadOp;
+
+IO_INLINE(void)
+io_PooledReadOp_finalize(io_PooledReadOp* op)
+{
+    io_Allocator* allocator = op->allocator;
+    op->callback(op->user_data, op->buffer, op->err);
+    io_Allocator_free(allocator, op);
+}
+
+IO_INLINE(void)
+io_PooledReadOp_complete(io_PooledReadOp* op, io_Buffer* buffer, io_Err err)
+{
+    op->err = err;
+    op->buffer = buffer;
+    io_Op_set_flags(&op->base, IO_OP_COMPLETED);
+    io_Context_post_completion(io_Descriptor_get_context(op->socket), &op->base.base);
+}
+
+/** io_take_read_buffer
+ * @brief Takes the buffer for the next read on `socket`, `size` is set
+ * to the number of bytes to read.
+ */
+IO_INLINE(io_Buffer*)
+io_take_read_buffer(io_Descriptor* socket, io_ReadSizer* sizer, size_t* size)
+{
+    io_BufferPool* pool = io_Loop_buffer_pool(io_Descriptor_get_loop(socket));
+    if (!sizer) {
+        io_Buffer* buffer = io_BufferPool_acquire(pool);
+        if (buffer) {
+            *size = io_Buffer_capacity(buffer);
+        }
+        return buffer;
+    }
+    *size = io_ReadSizer_next(sizer, io_Descriptor_get_fd(socket));
+    if (*size <= io_BufferPool_buffer_size(pool)) {
+        return io_BufferPool_acquire(pool);
+    }
+    return io_Buffer_create(io_Descriptor_allocator(socket), *size);
+}
+
+IO_INLINE(void)
+io_PooledReadOp_perform(io_PooledReadOp* op)
+{
+    size_t requested = 0;
+    io_Buffer* buffer = io_take_read_buffer(op->socket, op->sizer, &requested);
+    if (!buffer) {
+        io_PooledReadOp_complete(op, NULL, io_SystemErr(IO_ENOMEM));
+        return;
+    }
+    size_t size = requested;
+    io_Err err = io_perform_read(op->socket, io_Buffer_data(buffer), &size);
+    if (err) {
+        io_Buffer_release(buffer);
+        if ((io_Op_flags(&op->base) & IO_OP_TRYIO)
+            && (err == io_SystemErr(IO_EAGAIN)
+                || err == io_SystemErr(IO_EWOULDBLOCK))) {
+            return;
+        }
+        io_PooledReadOp_complete(op, NULL, err);
+        return;
+    }
+    if (op->sizer) {
+        io_ReadSizer_record(op->sizer, requested, size);
+    }
+    buffer->size = size;
+    io_PooledReadOp_complete(op, buffer, IO_ERR_OK);
+}
+
+IO_INLINE(void)
+io_PooledReadOp_fn(void* self)
+{
+    io_PooledReadOp* op = self;
+    if (io_Op_flags(&op->base) & IO_OP_COMPLETED) {
+        io_PooledReadOp_finalize(op);
+    } else {
+        io_PooledReadOp_perform(op);
+    }
+}
+
+IO_INLINE(void)
+io_PooledReadOp_abort(void* self, io_Err err)
+{
+    io_PooledReadOp* op = self;
+    io_PooledReadOp_complete(op, NULL, err);
+}
+
+IO_INLINE(io_PooledReadOp*)
+io_PooledReadOp_create(io_Descriptor* socket, io_ReadSizer* sizer, io_PooledReadCallback callback, void* user_data)
+{
+    io_Allocator* allocator = io_Descriptor_allocator(socket);
+    io_PooledReadOp* op = io_Allocator_alloc(allocator, sizeof(io_PooledReadOp));
+    if (!op)
+        return NULL;
+    io_Op_init(&op->base, IO_OP_READ, io_PooledReadOp_fn, io_PooledReadOp_abort);
+    op->allocator = allocator;
+    op->socket = socket;
+    op->sizer = sizer;
+    op->callback = callback;
+    op->user_data = user_data;
+    op->buffer = NULL;
+    op->err = IO_ERR_OK;
+    return op;
+}
+
+/** io_MultiReadOp
+ * @brief Multishot read, stays armed and reads into a pooled buffer on
+ * every readiness event until EOF, an error or a cancel. The callback
+ * gets every chunk, the final call has no buffer and carries the
+ * error that ended the op (IO_ERR_EOF at end of stream). With a worker
+ * pool the loop reads and a worker delivers, the next chunk is only read
+ * once the callback returned.
+ */
+typedef struct io_MultiReadOp {
+    io_Op base;
+    io_Allocator* allocator;
+    io_Descriptor* socket;
+    io_ReadSizer* sizer;
+    io_PooledReadCallback callback;
+    void* user_data;
+    io_Err err;
+    io_Buffer* chunk; // Handed to a worker with the op
+    bool on_worker;   // The next run delivers on a worker
+    bool done;        // Disarmed or aborted, only the final call is left
+} io_MultiReadOp;
+
+IO_INLINE(void)
+io_MultiReadOp_finalize(io_MultiReadOp* op)
+{
+    io_Allocator* allocator = op->allocator;
+    op->callback(op->user_data, NULL, op->err);
+    io_Allocator_free(allocator, op);
+}
+
+/** io_MultiReadOp_hand_over
+ * @brief Lets a worker run the callbacks, the op stays IO_OP_QUEUED meanwhile.
+ */
+IO_INLINE(void)
+io_MultiReadOp_hand_over(io_MultiReadOp* op)
+{
+    op->on_worker = true;
+    io_Context_post_completion(io_Descriptor_get_context(op->socket), &op->base.base);
+}
+
+IO_INLINE(void)
+io_MultiReadOp_complete(io_MultiReadOp* op)
+{
+    op->done = true;
+    if (io_Context_completes_inline(io_Descriptor_get_context(op->socket))) {
+        io_MultiReadOp_finalize(op);
+    } else {
+        io_MultiReadOp_hand_over(op);
+    }
+}
+
+/** io_MultiReadOp_deliver
+ * @brief The worker's part of a run.
+ */
+IO_INLINE(void)
+io_MultiReadOp_deliver(io_MultiReadOp* op)
+{
+    op->on_worker = false;
+    io_Buffer* chunk = IO_MOVE_PTR(op->chunk);
+    if (chunk) {
+        op->callback(op->user_data, chunk, IO_ERR_OK);
+    }
+    if (op->done || io_Multishot_end(&op->base)) {
+        io_MultiReadOp_finalize(op);
+    }
+}
+
+/** io_MultiReadOp_perform
+ * @brief Reads one chunk on a readiness event.
+ * @return true if the run is over: the op is freed or handed to a worker.
+ */
+IO_INLINE(bool)
+io_MultiReadOp_perform(io_MultiReadOp* op)
+{
+    size_t requested = 0;
+    io_Buffer* buffer = io_take_read_buffer(op->socket, op->sizer, &requested);
+    io_Err err = IO_ERR_OK;
+    if (!buffer) {
+        err = io_SystemErr(IO_ENOMEM);
+    } else {
+        size_t size = requested;
+        err = io_perform_read(op->socket, io_Buffer_data(buffer), &size);
+        if (!err && size > 0) {
+            if (op->sizer) {
+                io_ReadSizer_record(op->sizer, requested, size);
+            }
+            buffer->size = size;
+            if (!io_Context_completes_inline(io_Descriptor_get_context(op->socket))) {
+                op->chunk = buffer;
+                io_MultiReadOp_hand_over(op);
+                return true;
+            }
+            op->callback(op->user_data, buffer, IO_ERR_OK);
+            return false;
+        }
+        io_Buffer_release(buffer);
+        if (!err) {
+            err = IO_ERR_EOF;
+        } else if (err == io_SystemErr(IO_EAGAIN) || err == io_SystemErr(IO_EWOULDBLOCK)) {
+            return false;
+        }
+    }
+    if (!io_Multishot_disarm(&op->base, op->socket->handle)) {
+        return false;
+    }
+    op->err = err;
+    io_MultiReadOp_complete(op);
+    return true;
+}
+
+IO_INLINE(void)
+io_MultiReadOp_fn(void* self)
+{
+    io_MultiReadOp* op = self;
+    if (io_Op_flags(&op->base) & IO_OP_TRYIO) {
+        // Readiness arrives through the reactor
+        return;
+    }
+    if (op->on_worker) {
+        io_MultiReadOp_deliver(op);
+    } else if (io_Multishot_begin(&op->base)) {
+        io_MultiReadOp_complete(op);
+    } else if (!io_MultiReadOp_perform(op) && io_Multishot_end(&op->base)) {
+        io_MultiReadOp_complete(op);
+    }
+}
+
+IO_INLINE(void)
+io_MultiReadOp_abort(void* self, io_Err err)
+{
+    io_MultiReadOp* op = self;
+    op->err = err;
+    io_Multishot_abort(&op->base, io_Descriptor_get_loop(op->socket));
+}
+
+IO_INLINE(io_MultiReadOp*)
+io_MultiReadOp_create(io_Descriptor* socket, io_ReadSizer* sizer, io_PooledReadCallback callback, void* user_data)
+{
+    io_Allocator* allocator = io_Descriptor_allocator(socket);
+    io_MultiReadOp* op = io_Allocator_alloc(allocator, sizeof(io_MultiReadOp));
+    if (!op)
+        return NULL;
+    io_Op_init(&op->base, IO_OP_READ, io_MultiReadOp_fn, io_MultiReadOp_abort);
+    op->allocator = allocator;
+    io_Op_set_flags(&op->base, IO_OP_MULTISHOT);
+    op->socket = socket;
+    op->sizer = sizer;
+    op->callback = callback;
+    op->user_data = user_data;
+    op->err = IO_ERR_OK;
+    op->chunk = NULL;
+    op->on_worker = false;
+    op->done = false;
+    return op;
+}
+
 #endif
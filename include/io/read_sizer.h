@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_READ_SIZER_H
+#define IO_READ_SIZER_H
+
+#include <io/config.h>
+
+#include <io/assert.h>
+#include <io/system_call.h>
+#include <io/utility.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define IO_READ_SIZER_DEFAULT_MIN 64
+#define IO_READ_SIZER_DEFAULT_INITIAL 2048
+#define IO_READ_SIZER_DEFAULT_MAX (64 * 1024)
+
+/** io_ReadSizer
+ * @brief Picks the size of the next read from the recent ones, in the
+ * spirit of Netty's adaptive receive allocator: a read that fills the
+ * buffer doubles the next size, two reads in a row that use less than
+ * half of it halve the next size. The size stays within [min, max].
+ * With `use_fionread` the pending byte count of the fd can raise
+ * the size for a single read.
+ */
+typedef struct io_ReadSizer {
+    size_t min;
+    size_t max;
+    size_t next;
+    bool shrink_pending;
+    bool use_fionread;
+} io_ReadSizer;
+
+IO_INLINE(void)
+io_ReadSizer_init(io_ReadSizer* sizer, size_t min, size_t initial, size_t max, bool use_fionread)
+{
+    IO_ASSERT(min > 0 && min <= initial && initial <= max, "Invalid read sizer bounds");
+    sizer->min = min;
+    sizer->max = max;
+    sizer->next = initial;
+    sizer->shrink_pending = false;
+    sizer->use_fionread = use_fionread;
+}
+
+/** io_ReadSizer_next
+ * @brief The size for the next read on `fd`.
+ */
+IO_INLINE(size_t)
+io_ReadSizer_next(const io_ReadSizer* sizer, int fd)
+{
+    size_t size = sizer->next;
+    if (sizer->use_fionread) {
+        int pending = 0;
+        if (io_ioctl(fd, FIONREAD, &pending) == 0 && (size_t)pending > size) {
+            size = io_next_pow2((size_t)pending);
+            if (size > sizer->max) {
+                size = sizer->max;
+            }
+        }
+    }
+    return size;
+}
+
+/** io_ReadSizer_record
+ * @brief Feeds back that a read of `requested` bytes returned `actual`.
+ */
+IO_INLINE(void)
+io_ReadSizer_record(io_ReadSizer* sizer, size_t requested, size_t actual)
+{
+    if (actual >= requested) {
+        size_t grown = requested * 2;
+        sizer->next = grown > sizer->max ? sizer->max : grown;
+        sizer->shrink_pending = false;
+    } else if (actual <= sizer->next / 2 && sizer->next > sizer->min) {
+        if (sizer->shrink_pending) {
+            size_t shrunk = sizer->next / 2;
+            sizer->next = shrunk < sizer->min ? sizer->min : shrunk;
+            sizer->shrink_pending = false;
+        } else {
+            sizer->shrink_pending = true;
+        }
+    } else {
+        sizer->shrink_pending = false;
+    }
+}
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_REBALANCER_H
+#define IO_REBALANCER_H
+
+#include <io/config.h>
+
+#include <io/atomic.h>
+#include <io/context.h>
+#include <io/descriptor.h>
+#include <io/vec.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct io_RebalanceEntry {
+    io_Descriptor* descriptor;
+    size_t last_activity;
+    size_t delta; // Activity since the previous check
+} io_RebalanceEntry;
+
+IO_DEFINE_VEC(io_RebalanceEntryVec, io_RebalanceEntry, (void))
+IO_DEFINE_VEC(io_RebalanceStrikeVec, size_t, (void))
+
+/** io_Rebalancer
+ * @brief Moves hot descriptors off loops that stay busy. Every call to
+ * io_Rebalancer_check samples the busy ratio of each loop, a loop that's at
+ * or above `threshold` (in IO_LOOP_BUSY_SCALE units) for `patience` checks
+ * in a row hands its most active registered descriptor to the least busy loop.
+ * Only registered descriptors are moved, and only while they have no op pending,
+ * so register descriptors whose owner tolerates the completions moving threads.
+ */
+typedef struct io_Rebalancer {
+    io_Context* context;
+    io_RebalanceEntryVec entries;
+    io_RebalanceStrikeVec strikes; // Consecutive busy checks per loop
+    uint32_t threshold;
+    size_t patience;
+    size_t in_flight; // Migrations that haven't called back yet
+} io_Rebalancer;
+
+IO_INLINE(void)
+io_Rebalancer_init(io_Rebalancer* rebalancer, io_Context* context, uint32_t threshold, size_t patience)
+{
+    rebalancer->context = context;
+    io_RebalanceEntryVec_init(&rebalancer->entries, context->allocator);
+    io_RebalanceStrikeVec_init(&rebalancer->strikes, context->allocator);
+    rebalancer->threshold = threshold;
+    rebalancer->patience = patience ? patience : 1;
+    rebalancer->in_flight = 0;
+}
+
+/** io_Rebalancer_deinit
+ * @brief Must not be called while a migration started by the rebalancer is pending.
+ */
+IO_INLINE(void)
+io_Rebalancer_deinit(io_Rebalancer* rebalancer)
+{
+    IO_ASSERT(io_atomic_load(&rebalancer->in_flight) == 0, "Migration still pending");
+    io_RebalanceEntryVec_deinit(&rebalancer->entries);
+    io_RebalanceStrikeVec_deinit(&rebalancer->strikes);
+}
+
+/** io_Rebalancer_add
+ * @brief Registers `descriptor`, it must be removed before it's closed.
+ */
+IO_INLINE(io_Err)
+io_Rebalancer_add(io_Rebalancer* rebalancer, io_Descriptor* descriptor)
+{
+    size_t activity = descriptor->handle ? io_Handle_activity(descriptor->handle) : 0;
+    io_RebalanceEntry entry = {.descriptor = descriptor, .last_activity = activity, .delta = 0};
+    return io_RebalanceEntryVec_push_back(&rebalancer->entries, entry);
+}
+
+IO_INLINE(void)
+io_Rebalancer_remove(io_Rebalancer* rebalancer, io_Descriptor* descriptor)
+{
+    size_t size = io_RebalanceEntryVec_size(&rebalancer->entries);
+    for (size_t i = 0; i < size; ++i) {
+        io_RebalanceEntry* entry = io_RebalanceEntryVec_at(&rebalancer->entries, i);
+        if (entry->descriptor == descriptor) {
+            *entry = io_RebalanceEntryVec_back(&rebalancer->entries);
+            io_RebalanceEntryVec_pop_back(&rebalancer->entries);
+            return;
+        }
+    }
+}
+
+IO_INLINE(void)
+io_Rebalancer_on_migrated(void* user_data, io_Err err)
+{
+    (void)err; // A busy descriptor is simply tried again on a later check
+    io_Rebalancer* rebalancer = user_data;
+    io_atomic_dec(&rebalancer->in_flight);
+}
+
+/** io_Rebalancer_hottest
+ * @brief The registered descriptor on `loop` with the most activity since the last check.
+ */
+IO_INLINE(io_Descriptor*)
+io_Rebalancer_hottest(io_Rebalancer* rebalancer, io_Loop* loop)
+{
+    io_RebalanceEntry* hottest = NULL;
+    size_t size = io_RebalanceEntryVec_size(&rebalancer->entries);
+    for (size_t i = 0; i < size; ++i) {
+        io_RebalanceEntry* entry = io_RebalanceEntryVec_at(&rebalancer->entries, i);
+        if (entry->descriptor->loop == loop && entry->delta > 0 && (!hottest || entry->delta > hottest->delta)) {
+            hottest = entry;
+        }
+    }
+    return hottest ? hottest->descriptor : NULL;
+}
+
+/** io_Rebalancer_check
+ * @brief Samples the loops and starts the migrations that are due. Call it
+ * periodically from a single thread, for example from a timer on one of
+ * the loops. Checks are skipped while earlier migrations are pending.
+ * @return The number of migrations started.
+ */
+IO_INLINE(size_t)
+io_Rebalancer_check(io_Rebalancer* rebalancer)
+{
+    io_Context* context = rebalancer->context;
+    size_t num_loops = io_Context_num_loops(context);
+    if (num_loops < 2 || io_atomic_load(&rebalancer->in_flight) > 0) {
+        return 0;
+    }
+    size_t old_size = io_RebalanceStrikeVec_size(&rebalancer->strikes);
+    if (io_RebalanceStrikeVec_resize(&rebalancer->strikes, num_loops) != IO_ERR_OK) {
+        return 0;
+    }
+    for (size_t i = old_size; i < num_loops; ++i) {
+        *io_RebalanceStrikeVec_at(&rebalancer->strikes, i) = 0;
+    }
+
+    size_t size = io_RebalanceEntryVec_size(&rebalancer->entries);
+    for (size_t i = 0; i < size; ++i) {
+        io_RebalanceEntry* entry = io_RebalanceEntryVec_at(&rebalancer->entries, i);
+        size_t activity = entry->descriptor->handle ? io_Handle_activity(entry->descriptor->handle) : entry->last_activity;
+        entry->delta = activity - entry->last_activity;
+        entry->last_activity = activity;
+    }
+
+    io_Loop* coolest = io_Context_loop_at(context, 0);
+    for (size_t i = 1; i < num_loops; ++i) {
+        io_Loop* loop = io_Context_loop_at(context, i);
+        if (io_Loop_load(loop, IO_PLACEMENT_LEAST_BUSY) < io_Loop_load(coolest, IO_PLACEMENT_LEAST_BUSY)) {
+            coolest = loop;
+        }
+    }
+
+    size_t started = 0;
+    for (size_t i = 0; i < num_loops; ++i) {
+        io_Loop* loop = io_Context_loop_at(context, i);
+        size_t* strikes = io_RebalanceStrikeVec_at(&rebalancer->strikes, i);
+        uint32_t busy = io_Loop_busy_ratio(loop);
+        if (busy < rebalancer->threshold) {
+            *strikes = 0;
+            continue;
+        }
+        if (++*strikes < rebalancer->patience || loop == coolest || busy <= io_Loop_busy_ratio(coolest)) {
+            continue;
+        }
+        io_Descriptor* descriptor = io_Rebalancer_hottest(rebalancer, loop);
+        if (!descriptor) {
+            continue;
+        }
+        io_atomic_inc(&rebalancer->in_flight);
+        if (io_Descriptor_migrate(descriptor, coolest, io_Rebalancer_on_migrated, rebalancer) != IO_ERR_OK) {
+            io_atomic_dec(&rebalancer->in_flight);
+            continue;
+        }
+        *strikes = 0;
+        ++started;
+    }
+    return started;
+}
+
+#endif
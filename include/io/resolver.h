@@ -0,0 +1,489 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_RESOLVER_H
+#define IO_RESOLVER_H
+
+#include <io/allocator.h>
+#include <io/assert.h>
+#include <io/config.h>
+#include <io/err.h>
+#include <io/gai_err.h>
+#include <io/hash.h>
+#include <io/hashmap.h>
+#include <io/loop.h>
+#include <io/other_err.h>
+#include <io/queue.h>
+#include <io/system_call.h>
+#include <io/system_err.h>
+#include <io/thread.h>
+#include <io/timer.h>
+
+#include <netdb.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#define IO_RESOLVER_MAX_ENDPOINTS 8
+#define IO_RESOLVER_MAX_HOST 256
+#define IO_RESOLVER_MAX_SERVICE 32
+#define IO_RESOLVER_NUM_SHARDS 16
+#define IO_RESOLVER_SHARD_CAPACITY 256
+#define IO_RESOLVER_DEFAULT_WORKERS 2
+#define IO_RESOLVER_DEFAULT_TTL 30 // seconds
+
+typedef struct io_Endpoint {
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    int family;
+    int socktype;
+    int protocol;
+} io_Endpoint;
+
+typedef struct io_ResolverResult {
+    io_Endpoint endpoints[IO_RESOLVER_MAX_ENDPOINTS];
+    size_t count;
+} io_ResolverResult;
+
+typedef void (*io_ResolveCallback)(void* user_data, const io_ResolverResult* result, io_Err err);
+
+/* io_ResolverCache begin */
+
+typedef struct io_ResolverEntry {
+    char* key;
+    io_Timer expire;
+    io_ResolverResult result;
+} io_ResolverEntry;
+
+IO_INLINE(bool)
+io_cmp_cstr(const char* a, const char* b)
+{
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+IO_DEFINE_HASHMAP(io_ResolverCacheMap, const char*, io_ResolverEntry*, io_hash_cstr, io_cmp_cstr, ((const char*)NULL))
+
+typedef struct io_ResolverShard {
+    io_ResolverCacheMap map;
+    io_Mutex mtx;
+} io_ResolverShard;
+
+IO_INLINE(void)
+io_ResolverShard_init(io_ResolverShard* shard, io_Allocator* allocator)
+{
+    io_ResolverCacheMap_init(&shard->map, allocator);
+    io_Mutex_init(&shard->mtx);
+}
+
+/** io_ResolverShard_clear
+ * @brief Drop all entries of the shard, the shard mutex must be held.
+ */
+IO_INLINE(void)
+io_ResolverShard_clear(io_ResolverShard* shard)
+{
+    io_Allocator* allocator = shard->map.allocator;
+    for (io_ResolverCacheMap_iter iter = io_ResolverCacheMap_begin(&shard->map);
+         iter != NULL;
+         iter = io_ResolverCacheMap_next(&shard->map, iter)) {
+        io_free(allocator, iter->value);
+    }
+    io_ResolverCacheMap_deinit(&shard->map);
+    io_ResolverCacheMap_init(&shard->map, allocator);
+}
+
+IO_INLINE(void)
+io_ResolverShard_deinit(io_ResolverShard* shard)
+{
+    io_ResolverShard_clear(shard);
+    io_ResolverCacheMap_deinit(&shard->map);
+    io_Mutex_deinit(&shard->mtx);
+}
+
+/* io_ResolverCache end */
+/* io_ResolveRequest begin */
+
+typedef struct io_Resolver io_Resolver;
+
+typedef struct io_ResolveRequest {
+    io_Task base;
+    struct io_ResolveRequest* next;
+    io_Resolver* resolver;
+    io_Loop* loop;
+    io_ResolveCallback callback;
+    void* user_data;
+    io_Err err;
+    bool cached;
+    io_ResolverResult result;
+    char host[IO_RESOLVER_MAX_HOST];
+    char service[IO_RESOLVER_MAX_SERVICE];
+} io_ResolveRequest;
+
+IO_DEFINE_QUEUE(io_ResolveRequestQueue, io_ResolveRequest)
+
+/* io_ResolveRequest end */
+/* io_Resolver begin */
+
+/** io_Resolver
+ * @brief Name resolver with a sharded TTL cache.
+ * Lookups that miss the cache are run on a small pool of worker threads
+ * (started on demand), the result is posted back to the requesting loop.
+ */
+struct io_Resolver {
+    io_ResolverShard shards[IO_RESOLVER_NUM_SHARDS];
+    io_ResolveRequestQueue queue;
+    io_ResolveRequestQueue cancelled; // Resolved after io_Resolver_deinit began
+    io_ThreadVec workers;
+    io_Mutex mtx;
+    io_Cond cond;
+    io_Allocator* allocator;
+    io_Duration ttl;
+    size_t max_workers;
+    size_t idle_workers;
+    bool stopping;
+};
+
+IO_INLINE(io_Err)
+io_Resolver_init(io_Resolver* resolver, io_Allocator* allocator)
+{
+    io_Err err = IO_ERR_OK;
+    if ((err = io_Mutex_init(&resolver->mtx))) {
+        return err;
+    }
+    if ((err = io_Cond_init(&resolver->cond))) {
+        io_Mutex_deinit(&resolver->mtx);
+        return err;
+    }
+    for (size_t i = 0; i < IO_RESOLVER_NUM_SHARDS; ++i) {
+        io_ResolverShard_init(&resolver->shards[i], allocator);
+    }
+    resolver->queue = io_ResolveRequestQueue_make();
+    resolver->cancelled = io_ResolveRequestQueue_make();
+    io_ThreadVec_init(&resolver->workers, allocator);
+    resolver->allocator = allocator;
+    resolver->ttl = io_Seconds(IO_RESOLVER_DEFAULT_TTL);
+    resolver->max_workers = IO_RESOLVER_DEFAULT_WORKERS;
+    resolver->idle_workers = 0;
+    resolver->stopping = false;
+    return IO_ERR_OK;
+}
+
+/** io_Resolver_cancel_requests
+ * @brief Completes the requests with IO_ECANCELED on the calling thread.
+ */
+IO_INLINE(void)
+io_Resolver_cancel_requests(io_Resolver* resolver, io_ResolveRequestQueue* queue)
+{
+    io_ResolveRequest* request = NULL;
+    while ((request = io_ResolveRequestQueue_pop(queue))) {
+        request->callback(request->user_data, NULL, io_SystemErr(IO_ECANCELED));
+        io_Loop_decrease_task_count(request->loop);
+        io_free(resolver->allocator, request);
+    }
+}
+
+/** io_Resolver_deinit
+ * @brief Joins the workers, lookups that weren't delivered to their loop
+ * yet complete with IO_ECANCELED. Must run before the loops are destroyed.
+ */
+IO_INLINE(void)
+io_Resolver_deinit(io_Resolver* resolver)
+{
+    io_Mutex_lock(&resolver->mtx);
+    resolver->stopping = true;
+    io_Cond_broadcast(&resolver->cond);
+    io_Mutex_unlock(&resolver->mtx);
+    // The workers finish their current lookup and leave the rest queued
+    io_ThreadVec_deinit(&resolver->workers);
+    io_Resolver_cancel_requests(resolver, &resolver->cancelled);
+    io_Resolver_cancel_requests(resolver, &resolver->queue);
+    for (size_t i = 0; i < IO_RESOLVER_NUM_SHARDS; ++i) {
+        io_ResolverShard_deinit(&resolver->shards[i]);
+    }
+    io_Cond_deinit(&resolver->cond);
+    io_Mutex_deinit(&resolver->mtx);
+}
+
+/** io_Resolver_set_ttl
+ * @brief Set how long a successful lookup is served from the cache.
+ */
+IO_INLINE(void)
+io_Resolver_set_ttl(io_Resolver* resolver, io_Duration ttl)
+{
+    resolver->ttl = ttl;
+}
+
+/** io_Resolver_set_max_workers
+ * @brief Set the maximum number of worker threads used for asynchronous lookups.
+ */
+IO_INLINE(void)
+io_Resolver_set_max_workers(io_Resolver* resolver, size_t max_workers)
+{
+    IO_ASSERT(max_workers > 0, "At least one worker is required");
+    io_Mutex_lock(&resolver->mtx);
+    resolver->max_workers = max_workers;
+    io_Mutex_unlock(&resolver->mtx);
+}
+
+IO_INLINE(io_Err)
+io_Resolver_make_key(char* key, size_t size, const char* host, const char* service)
+{
+    int len = snprintf(key, size, "%s:%s", host, service);
+    if (len < 0 || (size_t)len >= size) {
+        return io_SystemErr(IO_EINVAL);
+    }
+    return IO_ERR_OK;
+}
+
+IO_INLINE(io_ResolverShard*)
+io_Resolver_shard(io_Resolver* resolver, const char* key)
+{
+    return &resolver->shards[io_hash_cstr(key) % IO_RESOLVER_NUM_SHARDS];
+}
+
+/** io_Resolver_lookup
+ * @brief Look up a cached result, expired entries are dropped.
+ * @return true if the result was found in the cache.
+ */
+IO_INLINE(bool)
+io_Resolver_lookup(io_Resolver* resolver, const char* host, const char* service, io_ResolverResult* result)
+{
+    char key[IO_RESOLVER_MAX_HOST + IO_RESOLVER_MAX_SERVICE + 1];
+    if (io_Resolver_make_key(key, sizeof(key), host, service)) {
+        return false;
+    }
+    bool hit = false;
+    io_ResolverShard* shard = io_Resolver_shard(resolver, key);
+    io_Mutex_lock(&shard->mtx);
+    io_ResolverCacheMap_iter iter = io_ResolverCacheMap_find(&shard->map, key);
+    if (iter) {
+        io_ResolverEntry* entry = iter->value;
+        if (io_Timer_expired(&entry->expire)) {
+            io_ResolverCacheMap_erase(&shard->map, iter);
+            io_free(resolver->allocator, entry);
+        } else {
+            *result = entry->result;
+            hit = true;
+        }
+    }
+    io_Mutex_unlock(&shard->mtx);
+    return hit;
+}
+
+/** io_Resolver_store
+ * @brief Store a result in the cache, a full shard is flushed.
+ */
+IO_INLINE(void)
+io_Resolver_store(io_Resolver* resolver, const char* host, const char* service, const io_ResolverResult* result)
+{
+    char key[IO_RESOLVER_MAX_HOST + IO_RESOLVER_MAX_SERVICE + 1];
+    if (io_Resolver_make_key(key, sizeof(key), host, service)) {
+        return;
+    }
+    io_ResolverShard* shard = io_Resolver_shard(resolver, key);
+    io_Mutex_lock(&shard->mtx);
+    io_ResolverEntry** found = io_ResolverCacheMap_try_get(&shard->map, key);
+    io_ResolverEntry* entry = found ? *found : NULL;
+    if (!entry) {
+        if (shard->map.size >= IO_RESOLVER_SHARD_CAPACITY) {
+            io_ResolverShard_clear(shard);
+        }
+        size_t len = strlen(key);
+        entry = io_alloc(resolver->allocator, sizeof(io_ResolverEntry) + len + 1);
+        if (!entry) {
+            goto unlock;
+        }
+        entry->key = (char*)(entry + 1);
+        memcpy(entry->key, key, len + 1);
+        if (io_ResolverCacheMap_set(&shard->map, entry->key, entry)) {
+            io_free(resolver->allocator, entry);
+            goto unlock;
+        }
+    }
+    entry->result = *result;
+    io_Timer_init(&entry->expire, resolver->ttl);
+unlock:
+    io_Mutex_unlock(&shard->mtx);
+}
+
+/** io_resolve
+ * @brief Resolve host and service with getaddrinfo, bypassing the cache.
+ */
+IO_INLINE(io_Err)
+io_resolve(const char* host, const char* service, io_ResolverResult* result)
+{
+    struct addrinfo hints = {0};
+    struct addrinfo* servinfo = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int ret = io_getaddrinfo(host, service, &hints, &servinfo);
+    if (ret != 0) {
+        return io_GaiErr(ret);
+    }
+    result->count = 0;
+    for (struct addrinfo* p = servinfo; p != NULL && result->count < IO_RESOLVER_MAX_ENDPOINTS; p = p->ai_next) {
+        if (p->ai_addrlen > sizeof(struct sockaddr_storage)) {
+            continue;
+        }
+        io_Endpoint* endpoint = &result->endpoints[result->count++];
+        memcpy(&endpoint->addr, p->ai_addr, p->ai_addrlen);
+        endpoint->addrlen = p->ai_addrlen;
+        endpoint->family = p->ai_family;
+        endpoint->socktype = p->ai_socktype;
+        endpoint->protocol = p->ai_protocol;
+    }
+    io_freeaddrinfo(servinfo);
+    if (result->count == 0) {
+        return io_OtherErr(IO_OTHER_ERRC_NO_ENDPOINT);
+    }
+    return IO_ERR_OK;
+}
+
+/** io_Resolver_resolve
+ * @brief Resolve host and service synchronously, consulting the cache first.
+ */
+IO_INLINE(io_Err)
+io_Resolver_resolve(io_Resolver* resolver, const char* host, const char* service, io_ResolverResult* result)
+{
+    if (io_Resolver_lookup(resolver, host, service, result)) {
+        return IO_ERR_OK;
+    }
+    io_Err err = io_resolve(host, service, result);
+    if (err) {
+        return err;
+    }
+    io_Resolver_store(resolver, host, service, result);
+    return IO_ERR_OK;
+}
+
+IO_INLINE(void)
+io_ResolveRequest_fn(void* self)
+{
+    io_ResolveRequest* request = self;
+    io_Resolver* resolver = request->resolver;
+    io_Loop* loop = request->loop;
+    bool mailed = !request->cached && loop->shared_nothing;
+    // The cache is filled on the loop, so workers never touch the allocator.
+    if (!request->err && !request->cached) {
+        io_Resolver_store(resolver, request->host, request->service, &request->result);
+    }
+    request->callback(request->user_data, request->err ? NULL : &request->result, request->err);
+    io_free(resolver->allocator, request);
+    if (mailed) {
+        // The worker couldn't touch the loop's task count, the lookup's count is released here
+        io_Loop_decrease_task_count(loop);
+    }
+}
+
+IO_INLINE(void*)
+io_Resolver_run_worker(void* user_data)
+{
+    io_Resolver* resolver = user_data;
+    io_Mutex_lock(&resolver->mtx);
+    while (!resolver->stopping) {
+        io_ResolveRequest* request = io_ResolveRequestQueue_pop(&resolver->queue);
+        if (!request) {
+            ++resolver->idle_workers;
+            io_Cond_wait(&resolver->cond, &resolver->mtx);
+            --resolver->idle_workers;
+            continue;
+        }
+        io_Mutex_unlock(&resolver->mtx);
+        request->err = io_resolve(request->host, request->service, &request->result);
+        io_Mutex_lock(&resolver->mtx);
+        if (resolver->stopping) {
+            // The loop may not run anymore, io_Resolver_deinit cancels the request
+            io_ResolveRequestQueue_push(&resolver->cancelled, request);
+            continue;
+        }
+        io_Mutex_unlock(&resolver->mtx);
+        if (request->loop->shared_nothing) {
+            io_Loop_send(request->loop, &request->base);
+        } else {
+            io_Loop_push_task(request->loop, &request->base);
+            io_Loop_decrease_task_count(request->loop);
+        }
+        io_Mutex_lock(&resolver->mtx);
+    }
+    io_Mutex_unlock(&resolver->mtx);
+    return NULL;
+}
+
+/** io_Resolver_spawn_worker
+ * @brief Start another worker if none is idle, the resolver mutex must be held.
+ */
+IO_INLINE(io_Err)
+io_Resolver_spawn_worker(io_Resolver* resolver)
+{
+    size_t num_workers = io_ThreadVec_size(&resolver->workers);
+    if (resolver->idle_workers > 0 || num_workers >= resolver->max_workers) {
+        return IO_ERR_OK;
+    }
+    io_Err err = IO_ERR_OK;
+    if ((err = io_ThreadVec_resize(&resolver->workers, num_workers + 1))) {
+        return err;
+    }
+    if ((err = io_Thread_init(io_ThreadVec_at(&resolver->workers, num_workers), io_Resolver_run_worker, resolver))) {
+        io_ThreadVec_resize(&resolver->workers, num_workers);
+        return err;
+    }
+    return IO_ERR_OK;
+}
+
+/** io_Resolver_async_resolve
+ * @brief Resolve host and service off-loop, the callback is invoked on the given loop.
+ * Cache hits are posted to the loop directly without involving a worker.
+ * Call it from the loop's thread if the loop is shared-nothing, the workers
+ * then send the results to its mailbox. Single-threaded loops can't take tasks
+ * from the workers, they get IO_ENOTSUP and resolve with io_Resolver_resolve
+ * instead. Lookups still in flight when the
+ * context is deinitialized complete with IO_ECANCELED from io_Context_deinit.
+ */
+IO_INLINE(io_Err)
+io_Resolver_async_resolve(io_Resolver* resolver, io_Loop* loop,
+                          const char* host, const char* service,
+                          io_ResolveCallback callback, void* user_data)
+{
+    if (!io_Loop_reachable(loop)) {
+        return io_SystemErr(IO_ENOTSUP);
+    }
+    if (strlen(host) >= IO_RESOLVER_MAX_HOST || strlen(service) >= IO_RESOLVER_MAX_SERVICE) {
+        return io_SystemErr(IO_EINVAL);
+    }
+    io_ResolveRequest* request = io_alloc(resolver->allocator, sizeof(io_ResolveRequest));
+    if (!request) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    request->base.fn = io_ResolveRequest_fn;
+    request->resolver = resolver;
+    request->loop = loop;
+    request->callback = callback;
+    request->user_data = user_data;
+    request->err = IO_ERR_OK;
+    strcpy(request->host, host);
+    strcpy(request->service, service);
+    request->cached = io_Resolver_lookup(resolver, host, service, &request->result);
+    if (request->cached) {
+        io_Loop_push_task(loop, &request->base);
+        return IO_ERR_OK;
+    }
+    io_Mutex_lock(&resolver->mtx);
+    io_Err err = io_Resolver_spawn_worker(resolver);
+    if (err && io_ThreadVec_size(&resolver->workers) == 0) {
+        io_Mutex_unlock(&resolver->mtx);
+        io_free(resolver->allocator, request);
+        return err;
+    }
+    io_Loop_increase_task_count(loop);
+    io_ResolveRequestQueue_push(&resolver->queue, request);
+    io_Cond_signal(&resolver->cond);
+    io_Mutex_unlock(&resolver->mtx);
+    return IO_ERR_OK;
+}
+
+/* io_Resolver end */
+
+#endif
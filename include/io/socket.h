@@ -7,6 +7,7 @@
 #ifndef IO_SOCKET_H
 #define IO_SOCKET_H
 
+#include <io/chain.h>
 #include <io/config.h>
 #include <io/descriptor.h>
 #include <io/read.h>
@@ -17,6 +18,7 @@
 
 typedef struct io_Socket {
     io_Descriptor base;
+    io_ReadSizer sizer; // Used by io_Socket_async_read_adaptive
 } io_Socket;
 
 DEFINE_DESCRIPTOR_WRAPPERS(io_Socket, io_Descriptor)
@@ -25,6 +27,18 @@ IO_INLINE(void)
 io_Socket_init(io_Socket* socket, io_Context* ctx)
 {
     io_Descriptor_init(&socket->base, ctx);
+    io_ReadSizer_init(&socket->sizer, IO_READ_SIZER_DEFAULT_MIN, IO_READ_SIZER_DEFAULT_INITIAL,
+                      IO_READ_SIZER_DEFAULT_MAX, false);
+}
+
+/** io_Socket_set_adaptive_read
+ * @brief Sets the bounds of the adaptive read size, with `use_fionread`
+ * the bytes pending on the socket are taken into account as well.
+ */
+IO_INLINE(void)
+io_Socket_set_adaptive_read(io_Socket* socket, size_t min, size_t initial, size_t max, bool use_fionread)
+{
+    io_ReadSizer_init(&socket->sizer, min, initial, max, use_fionread);
 }
 
 IO_INLINE(io_Err)
@@ -40,25 +54,131 @@ io_Socket_write(io_Socket* socket, const void* addr, size_t* size)
 }
 
 IO_INLINE(io_Err)
-io_Socket_async_read(io_Socket* socket, void* addr, size_t size, io_ReadCallback callback, void* user_data)
+io_Socket_async_read_with_token(io_Socket* socket, void* addr, size_t size, io_ReadCallback callback, void* user_data, io_OpToken* token)
 {
     io_ReadOp* op = io_ReadOp_create(&socket->base, addr, size, callback, user_data);
     if (!op)
         return io_SystemErr(IO_ENOMEM);
-    io_Handle_submit(socket->base.handle, &op->base);
+    io_Descriptor_submit(&socket->base, &op->base, token);
     return IO_ERR_OK;
 }
 
 IO_INLINE(io_Err)
-io_Socket_async_write(io_Socket* socket, const void* addr, size_t size, io_WriteCallback callback, void* user_data)
+io_Socket_async_read(io_Socket* socket, void* addr, size_t size, io_ReadCallback callback, void* user_data)
+{
+    return io_Socket_async_read_with_token(socket, addr, size, callback, user_data, NULL);
+}
+
+/** io_Socket_async_read_pooled
+ * @brief Reads into a buffer from the loop's pool that is only taken
+ * once the socket is readable, see io_PooledReadOp.
+ */
+IO_INLINE(io_Err)
+io_Socket_async_read_pooled_with_token(io_Socket* socket, io_PooledReadCallback callback, void* user_data, io_OpToken* token)
+{
+    if (socket->base.handle == NULL)
+        return io_SystemErr(IO_EBADF);
+    io_PooledReadOp* op = io_PooledReadOp_create(&socket->base, NULL, callback, user_data);
+    if (!op)
+        return io_SystemErr(IO_ENOMEM);
+    io_Descriptor_submit(&socket->base, &op->base, token);
+    return IO_ERR_OK;
+}
+
+IO_INLINE(io_Err)
+io_Socket_async_read_pooled(io_Socket* socket, io_PooledReadCallback callback, void* user_data)
+{
+    return io_Socket_async_read_pooled_with_token(socket, callback, user_data, NULL);
+}
+
+/** io_Socket_async_read_adaptive
+ * @brief Like io_Socket_async_read_pooled, but the read size follows
+ * the recent reads on the socket, see io_ReadSizer.
+ */
+IO_INLINE(io_Err)
+io_Socket_async_read_adaptive_with_token(io_Socket* socket, io_PooledReadCallback callback, void* user_data, io_OpToken* token)
+{
+    if (socket->base.handle == NULL)
+        return io_SystemErr(IO_EBADF);
+    io_PooledReadOp* op = io_PooledReadOp_create(&socket->base, &socket->sizer, callback, user_data);
+    if (!op)
+        return io_SystemErr(IO_ENOMEM);
+    io_Descriptor_submit(&socket->base, &op->base, token);
+    return IO_ERR_OK;
+}
+
+IO_INLINE(io_Err)
+io_Socket_async_read_adaptive(io_Socket* socket, io_PooledReadCallback callback, void* user_data)
+{
+    return io_Socket_async_read_adaptive_with_token(socket, callback, user_data, NULL);
+}
+
+/** io_Socket_async_read_multishot
+ * @brief Keeps reading until EOF, an error or a cancel, see io_MultiReadOp.
+ * With `adaptive` the read sizes follow the socket's io_ReadSizer.
+ * Cancel the socket before closing it.
+ */
+IO_INLINE(io_Err)
+io_Socket_async_read_multishot_with_token(io_Socket* socket, bool adaptive, io_PooledReadCallback callback, void* user_data, io_OpToken* token)
+{
+    if (socket->base.handle == NULL)
+        return io_SystemErr(IO_EBADF);
+    io_MultiReadOp* op = io_MultiReadOp_create(&socket->base, adaptive ? &socket->sizer : NULL, callback, user_data);
+    if (!op)
+        return io_SystemErr(IO_ENOMEM);
+    io_Descriptor_submit(&socket->base, &op->base, token);
+    return IO_ERR_OK;
+}
+
+IO_INLINE(io_Err)
+io_Socket_async_read_multishot(io_Socket* socket, bool adaptive, io_PooledReadCallback callback, void* user_data)
+{
+    return io_Socket_async_read_multishot_with_token(socket, adaptive, callback, user_data, NULL);
+}
+
+IO_INLINE(io_Err)
+io_Socket_async_write_with_token(io_Socket* socket, const void* addr, size_t size, io_WriteCallback callback, void* user_data, io_OpToken* token)
 {
     io_WriteOp* op = io_WriteOp_create(&socket->base, addr, size, callback, user_data);
     if (!op)
         return io_SystemErr(IO_ENOMEM);
-    io_Handle_submit(socket->base.handle, &op->base);
+    io_Descriptor_submit(&socket->base, &op->base, token);
     return IO_ERR_OK;
 }
 
+IO_INLINE(io_Err)
+io_Socket_async_write(io_Socket* socket, const void* addr, size_t size, io_WriteCallback callback, void* user_data)
+{
+    return io_Socket_async_write_with_token(socket, addr, size, callback, user_data, NULL);
+}
+
+/** io_Socket_create_chain
+ * @brief Creates an empty io_OpChain on the socket.
+ */
+IO_INLINE(io_OpChain*)
+io_Socket_create_chain(io_Socket* socket, io_OpChainCallback callback, void* user_data)
+{
+    return io_OpChain_create(&socket->base, callback, user_data);
+}
+
+IO_INLINE(io_Err)
+io_Socket_async_chain(io_Socket* socket, io_OpChain* chain)
+{
+    return io_Descriptor_async_chain(&socket->base, chain);
+}
+
+IO_INLINE(io_Err)
+io_Socket_async_chain_with_token(io_Socket* socket, io_OpChain* chain, io_OpToken* token)
+{
+    return io_Descriptor_async_chain_with_token(&socket->base, chain, token);
+}
+
+IO_INLINE(io_Err)
+io_Socket_set_options(io_Socket* socket, const io_SocketOptions* options)
+{
+    return io_Descriptor_set_options(&socket->base, options);
+}
+
 IO_INLINE(void)
 io_Socket_deinit(io_Socket* socket)
 {
@@ -79,6 +199,58 @@ io_Socket_deinit(io_Socket* socket)
     }                                                                                                     \
                                                                                                           \
     IO_INLINE(io_Err)                                                                                     \
+    P##_async_read_with_token(P* socket, void* addr, size_t size, io_ReadCallback callback,               \
+                              void* user_data, io_OpToken* token)                                         \
+    {                                                                                                     \
+        return B##_async_read_with_token(&socket->base, addr, size, callback, user_data, token);          \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_read_pooled(P* socket, io_PooledReadCallback callback, void* user_data)                     \
+    {                                                                                                     \
+        return B##_async_read_pooled(&socket->base, callback, user_data);                                 \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_read_pooled_with_token(P* socket, io_PooledReadCallback callback, void* user_data,          \
+                                     io_OpToken* token)                                                   \
+    {                                                                                                     \
+        return B##_async_read_pooled_with_token(&socket->base, callback, user_data, token);               \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_read_adaptive(P* socket, io_PooledReadCallback callback, void* user_data)                   \
+    {                                                                                                     \
+        return B##_async_read_adaptive(&socket->base, callback, user_data);                               \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_read_adaptive_with_token(P* socket, io_PooledReadCallback callback, void* user_data,        \
+                                       io_OpToken* token)                                                 \
+    {                                                                                                     \
+        return B##_async_read_adaptive_with_token(&socket->base, callback, user_data, token);             \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_read_multishot(P* socket, bool adaptive, io_PooledReadCallback callback, void* user_data)   \
+    {                                                                                                     \
+        return B##_async_read_multishot(&socket->base, adaptive, callback, user_data);                    \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_read_multishot_with_token(P* socket, bool adaptive, io_PooledReadCallback callback,         \
+                                        void* user_data, io_OpToken* token)                               \
+    {                                                                                                     \
+        return B##_async_read_multishot_with_token(&socket->base, adaptive, callback, user_data, token);  \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(void)                                                                                       \
+    P##_set_adaptive_read(P* socket, size_t min, size_t initial, size_t max, bool use_fionread)           \
+    {                                                                                                     \
+        B##_set_adaptive_read(&socket->base, min, initial, max, use_fionread);                            \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
     P##_write(P* socket, const void* addr, size_t* size)                                                  \
     {                                                                                                     \
         return B##_write(&socket->base, addr, size);                                                      \
@@ -88,6 +260,37 @@ io_Socket_deinit(io_Socket* socket)
     P##_async_write(P* socket, const void* addr, size_t size, io_WriteCallback callback, void* user_data) \
     {                                                                                                     \
         return B##_async_write(&socket->base, addr, size, callback, user_data);                           \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_write_with_token(P* socket, const void* addr, size_t size, io_WriteCallback callback,       \
+                               void* user_data, io_OpToken* token)                                        \
+    {                                                                                                     \
+        return B##_async_write_with_token(&socket->base, addr, size, callback, user_data, token);         \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_OpChain*)                                                                                \
+    P##_create_chain(P* socket, io_OpChainCallback callback, void* user_data)                             \
+    {                                                                                                     \
+        return B##_create_chain(&socket->base, callback, user_data);                                      \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_chain(P* socket, io_OpChain* chain)                                                         \
+    {                                                                                                     \
+        return B##_async_chain(&socket->base, chain);                                                     \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_async_chain_with_token(P* socket, io_OpChain* chain, io_OpToken* token)                           \
+    {                                                                                                     \
+        return B##_async_chain_with_token(&socket->base, chain, token);                                   \
+    }                                                                                                     \
+                                                                                                          \
+    IO_INLINE(io_Err)                                                                                     \
+    P##_set_options(P* socket, const io_SocketOptions* options)                                           \
+    {                                                                                                     \
+        return B##_set_options(&socket->base, options);                                                   \
     }
 
 #endif
@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_SOCKET_OPTIONS_H
+#define IO_SOCKET_OPTIONS_H
+
+#include <io/config.h>
+
+#include <io/err.h>
+#include <io/system_call.h>
+#include <io/system_err.h>
+
+#include <stdbool.h>
+
+#if IO_OS_POSIX
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+typedef enum io_SocketOption {
+    IO_SOCKOPT_TCP_NODELAY = 1 << 0,
+    IO_SOCKOPT_TCP_QUICKACK = 1 << 1,
+    IO_SOCKOPT_SEND_BUFFER = 1 << 2,
+    IO_SOCKOPT_RECV_BUFFER = 1 << 3,
+    IO_SOCKOPT_BUSY_POLL = 1 << 4,
+    IO_SOCKOPT_DEFER_ACCEPT = 1 << 5,
+    IO_SOCKOPT_FASTOPEN = 1 << 6,
+} io_SocketOption;
+
+/** io_SocketOptions
+ * @brief A set of socket options, only the options marked in `set`
+ * are applied. Use the setters below rather than writing the fields.
+ * TCP_DEFER_ACCEPT and TCP_FASTOPEN only make sense on listeners.
+ */
+typedef struct io_SocketOptions {
+    unsigned set;
+    bool tcp_nodelay;
+    bool tcp_quickack;
+    int send_buffer;
+    int recv_buffer;
+    int busy_poll_us;
+    int defer_accept_s;
+    int fastopen_queue;
+} io_SocketOptions;
+
+IO_INLINE(void)
+io_SocketOptions_init(io_SocketOptions* options)
+{
+    *options = (io_SocketOptions){0};
+}
+
+IO_INLINE(void)
+io_SocketOptions_set_tcp_nodelay(io_SocketOptions* options, bool on)
+{
+    options->set |= IO_SOCKOPT_TCP_NODELAY;
+    options->tcp_nodelay = on;
+}
+
+IO_INLINE(void)
+io_SocketOptions_set_tcp_quickack(io_SocketOptions* options, bool on)
+{
+    options->set |= IO_SOCKOPT_TCP_QUICKACK;
+    options->tcp_quickack = on;
+}
+
+IO_INLINE(void)
+io_SocketOptions_set_send_buffer(io_SocketOptions* options, int bytes)
+{
+    options->set |= IO_SOCKOPT_SEND_BUFFER;
+    options->send_buffer = bytes;
+}
+
+IO_INLINE(void)
+io_SocketOptions_set_recv_buffer(io_SocketOptions* options, int bytes)
+{
+    options->set |= IO_SOCKOPT_RECV_BUFFER;
+    options->recv_buffer = bytes;
+}
+
+IO_INLINE(void)
+io_SocketOptions_set_busy_poll(io_SocketOptions* options, int usec)
+{
+    options->set |= IO_SOCKOPT_BUSY_POLL;
+    options->busy_poll_us = usec;
+}
+
+IO_INLINE(void)
+io_SocketOptions_set_defer_accept(io_SocketOptions* options, int seconds)
+{
+    options->set |= IO_SOCKOPT_DEFER_ACCEPT;
+    options->defer_accept_s = seconds;
+}
+
+/** io_SocketOptions_set_fastopen
+ * @brief Enables TCP Fast Open on a listener, `queue` bounds the
+ * number of pending TFO requests.
+ */
+IO_INLINE(void)
+io_SocketOptions_set_fastopen(io_SocketOptions* options, int queue)
+{
+    options->set |= IO_SOCKOPT_FASTOPEN;
+    options->fastopen_queue = queue;
+}
+
+IO_INLINE(bool)
+io_SocketOptions_empty(const io_SocketOptions* options)
+{
+    return options->set == 0;
+}
+
+IO_INLINE(io_Err)
+io_setsockopt_int(int fd, int level, int name, int value)
+{
+    if (io_setsockopt(fd, level, name, &value, sizeof(value)) == -1) {
+        return io_SystemErr(errno);
+    }
+    return IO_ERR_OK;
+}
+
+/** io_SocketOptions_apply
+ * @brief Applies the options to `fd`, stops at the first failure.
+ * Options the platform doesn't know fail with IO_ENOTSUP.
+ */
+IO_INLINE(io_Err)
+io_SocketOptions_apply(const io_SocketOptions* options, int fd)
+{
+    io_Err err = IO_ERR_OK;
+    if (options->set & IO_SOCKOPT_TCP_NODELAY) {
+        if ((err = io_setsockopt_int(fd, IPPROTO_TCP, TCP_NODELAY, options->tcp_nodelay))) {
+            return err;
+        }
+    }
+    if (options->set & IO_SOCKOPT_TCP_QUICKACK) {
+#ifdef TCP_QUICKACK
+        if ((err = io_setsockopt_int(fd, IPPROTO_TCP, TCP_QUICKACK, options->tcp_quickack))) {
+            return err;
+        }
+#else
+        return io_SystemErr(IO_ENOTSUP);
+#endif
+    }
+    if (options->set & IO_SOCKOPT_SEND_BUFFER) {
+        if ((err = io_setsockopt_int(fd, SOL_SOCKET, SO_SNDBUF, options->send_buffer))) {
+            return err;
+        }
+    }
+    if (options->set & IO_SOCKOPT_RECV_BUFFER) {
+        if ((err = io_setsockopt_int(fd, SOL_SOCKET, SO_RCVBUF, options->recv_buffer))) {
+            return err;
+        }
+    }
+    if (options->set & IO_SOCKOPT_BUSY_POLL) {
+#ifdef SO_BUSY_POLL
+        if ((err = io_setsockopt_int(fd, SOL_SOCKET, SO_BUSY_POLL, options->busy_poll_us))) {
+            return err;
+        }
+#else
+        return io_SystemErr(IO_ENOTSUP);
+#endif
+    }
+    if (options->set & IO_SOCKOPT_DEFER_ACCEPT) {
+#ifdef TCP_DEFER_ACCEPT
+        if ((err = io_setsockopt_int(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, options->defer_accept_s))) {
+            return err;
+        }
+#else
+        return io_SystemErr(IO_ENOTSUP);
+#endif
+    }
+    if (options->set & IO_SOCKOPT_FASTOPEN) {
+#ifdef TCP_FASTOPEN
+        if ((err = io_setsockopt_int(fd, IPPROTO_TCP, TCP_FASTOPEN, options->fastopen_queue))) {
+            return err;
+        }
+#else
+        return io_SystemErr(IO_ENOTSUP);
+#endif
+    }
+    return IO_ERR_OK;
+}
+
+#endif
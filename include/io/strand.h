@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_STRAND_H
+#define IO_STRAND_H
+
+#include <io/config.h>
+
+#include <io/assert.h>
+#include <io/atomic.h>
+#include <io/context.h>
+#include <io/fn_task.h>
+#include <io/mpsc.h>
+#include <io/task.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Tasks a strand runs in a row before it yields to the other tasks of the loop */
+#ifndef IO_STRAND_BATCH
+#define IO_STRAND_BATCH 32
+#endif
+
+/** io_Strand
+ * @brief Runs the tasks posted through it one at a time and in FIFO order,
+ * like an asio strand. No thread ever blocks on a strand: the first task
+ * posted to an idle strand schedules a drain on the posting thread's loop,
+ * tasks posted meanwhile are picked up by that drain. State that is only
+ * touched from tasks of one strand needs no mutex.
+ */
+typedef struct io_Strand {
+    io_Context* context;
+    io_TaskMpsc queue;
+    size_t pending; // Tasks posted and not yet finished
+    io_Task drain;
+} io_Strand;
+
+IO_INLINE(void)
+io_Strand_schedule(io_Strand* strand)
+{
+    io_Context_post(strand->context, &strand->drain);
+}
+
+IO_INLINE(void)
+io_Strand_drain_fn(void* self)
+{
+    io_Strand* strand = (io_Strand*)((char*)self - offsetof(io_Strand, drain));
+    for (size_t i = 0; i < IO_STRAND_BATCH; ++i) {
+        io_Task* task = io_TaskMpsc_pop(&strand->queue);
+        if (!task) {
+            // Caught a push halfway, come back after the loop's other tasks
+            break;
+        }
+        task->fn(task);
+        if (io_atomic_dec(&strand->pending) == 0) {
+            return;
+        }
+    }
+    io_Strand_schedule(strand);
+}
+
+IO_INLINE(void)
+io_Strand_init(io_Strand* strand, io_Context* context)
+{
+    strand->context = context;
+    io_TaskMpsc_init(&strand->queue);
+    strand->pending = 0;
+    strand->drain.fn = io_Strand_drain_fn;
+    strand->drain.next = NULL;
+}
+
+IO_INLINE(void)
+io_Strand_deinit(io_Strand* strand)
+{
+    IO_ASSERT(io_atomic_load(&strand->pending) == 0, "Strand still has tasks");
+    (void)strand;
+}
+
+/** io_Strand_post
+ * @brief Queues `task` on the strand, it runs after all tasks posted before it.
+ * Safe to call from any thread.
+ */
+IO_INLINE(void)
+io_Strand_post(io_Strand* strand, io_Task* task)
+{
+    io_TaskMpsc_push(&strand->queue, task);
+    if (io_atomic_fetch_add(&strand->pending, 1) == 0) {
+        io_Strand_schedule(strand);
+    }
+}
+
+/** io_Strand_dispatch
+ * @brief Like io_Strand_post, but if the strand is idle `task` runs
+ * right away on the calling thread.
+ */
+IO_INLINE(void)
+io_Strand_dispatch(io_Strand* strand, io_Task* task)
+{
+    if (io_atomic_load(&strand->pending) == 0) {
+        size_t expected = 0;
+        if (io_atomic_compare_exchange(&strand->pending, &expected, 1)) {
+            task->fn(task);
+            if (io_atomic_dec(&strand->pending) != 0) {
+                io_Strand_schedule(strand);
+            }
+            return;
+        }
+    }
+    io_Strand_post(strand, task);
+}
+
+/** io_Strand_post_fn
+ * @brief io_Strand_post for a function and a copied capture, see io_Context_post_fn.
+ */
+IO_INLINE(io_Err)
+io_Strand_post_fn(io_Strand* strand, io_PostFn fn, const void* capture, size_t capture_len)
+{
+    io_Loop* loop = io_Context_this_loop(strand->context);
+    io_FnTask* task = io_FnTaskPool_acquire(&loop->fn_tasks, fn, capture, capture_len);
+    if (!task) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    io_Strand_post(strand, &task->base);
+    return IO_ERR_OK;
+}
+
+#endif
@@ -11,9 +11,35 @@
 #include <io/err.h>
 
 #if IO_OS_POSIX
+
+#include <sys/socket.h>
+
+// Flags for io_accept4, emulated with fcntl where accept4 is missing
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+#define IO_HAVE_ACCEPT4 1
+#define IO_SOCK_NONBLOCK SOCK_NONBLOCK
+#define IO_SOCK_CLOEXEC SOCK_CLOEXEC
+#else
+#define IO_HAVE_ACCEPT4 0
+#define IO_SOCK_NONBLOCK 0x01
+#define IO_SOCK_CLOEXEC 0x02
+#endif
+
+// epoll backs the wait fd of the poll reactor, see io_Reactor_wait_fd,
+// a timerfd in it reports op timeouts
+#if defined(__linux__)
+#define IO_HAVE_EPOLL 1
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#else
+#define IO_HAVE_EPOLL 0
+#endif
+
 #if !IO_MOCKING
 
 #include <fcntl.h>
+#include <netdb.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -60,20 +86,112 @@ io_accept(int sockfd, struct sockaddr* addr, socklen_t* addrlen)
     return accept(sockfd, addr, addrlen);
 }
 
+#if IO_HAVE_ACCEPT4 && !defined(_GNU_SOURCE)
+// glibc only declares accept4 with _GNU_SOURCE
+extern int accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags);
+#endif
+
+IO_INLINE(int)
+io_accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags)
+{
+#if IO_HAVE_ACCEPT4
+    return accept4(sockfd, addr, addrlen, flags);
+#else
+    int fd = accept(sockfd, addr, addrlen);
+    if (fd == -1) {
+        return -1;
+    }
+    if ((flags & IO_SOCK_NONBLOCK) && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == -1) {
+        goto on_error;
+    }
+    if ((flags & IO_SOCK_CLOEXEC) && fcntl(fd, F_SETFD, FD_CLOEXEC) == -1) {
+        goto on_error;
+    }
+    return fd;
+on_error:
+    close(fd);
+    return -1;
+#endif
+}
+
 IO_INLINE(int)
 io_connect(int sockfd, const void* addr, socklen_t addrlen)
 {
     return connect(sockfd, addr, addrlen);
 }
 
+IO_INLINE(int)
+io_setsockopt(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+    return setsockopt(sockfd, level, optname, optval, optlen);
+}
+
+IO_INLINE(int)
+io_getsockopt(int sockfd, int level, int optname, void* optval, socklen_t* optlen)
+{
+    return getsockopt(sockfd, level, optname, optval, optlen);
+}
+
+IO_INLINE(ssize_t)
+io_sendto(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen)
+{
+    return sendto(sockfd, buf, len, flags, dest_addr, addrlen);
+}
+
+IO_INLINE(int)
+io_ioctl(int fd, unsigned long request, void* arg)
+{
+    return ioctl(fd, request, arg);
+}
+
 IO_INLINE(int)
 io_pipe(int pipefd[2])
 {
     return pipe(pipefd);
 }
 
+IO_INLINE(int)
+io_getaddrinfo(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+    return getaddrinfo(node, service, hints, res);
+}
+
+IO_INLINE(void)
+io_freeaddrinfo(struct addrinfo* res)
+{
+    freeaddrinfo(res);
+}
+
 #define io_fcntl(...) fcntl(__VA_ARGS__)
 
+#if IO_HAVE_EPOLL
+
+IO_INLINE(int)
+io_epoll_create1(int flags)
+{
+    return epoll_create1(flags);
+}
+
+IO_INLINE(int)
+io_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event)
+{
+    return epoll_ctl(epfd, op, fd, event);
+}
+
+IO_INLINE(int)
+io_timerfd_create(int clockid, int flags)
+{
+    return timerfd_create(clockid, flags);
+}
+
+IO_INLINE(int)
+io_timerfd_settime(int fd, int flags, const struct itimerspec* new_value, struct itimerspec* old_value)
+{
+    return timerfd_settime(fd, flags, new_value, old_value);
+}
+
+#endif // IO_HAVE_EPOLL
+
 #if IO_WITH_POLL
 
 #include <poll.h>
@@ -88,7 +206,9 @@ io_poll(struct pollfd* fds, nfds_t nfds, int timeout)
 #else  // IO_MOCKING
 
 #include <fcntl.h>
+#include <netdb.h>
 #include <poll.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
@@ -100,12 +220,25 @@ typedef struct io_MockSystemCall {
     int (*bind)(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
     int (*listen)(int sockfd, int backlog);
     int (*accept)(int sockfd, struct sockaddr* addr, socklen_t* addrlen);
+    int (*accept4)(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags);
     int (*connect)(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
+    int (*setsockopt)(int sockfd, int level, int optname, const void* optval, socklen_t optlen);
+    int (*getsockopt)(int sockfd, int level, int optname, void* optval, socklen_t* optlen);
+    ssize_t (*sendto)(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen);
     int (*pipe)(int pipefd[2]);
+    int (*ioctl)(int fd, unsigned long request, void* arg);
     int (*fcntl)(int fd, int cmd, ...);
+    int (*getaddrinfo)(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res);
+    void (*freeaddrinfo)(struct addrinfo* res);
 #if IO_WITH_POLL
     int (*poll)(struct pollfd* fds, nfds_t nfds, int timeout);
 #endif
+#if IO_HAVE_EPOLL
+    int (*epoll_create1)(int flags);
+    int (*epoll_ctl)(int epfd, int op, int fd, struct epoll_event* event);
+    int (*timerfd_create)(int clockid, int flags);
+    int (*timerfd_settime)(int fd, int flags, const struct itimerspec* new_value, struct itimerspec* old_value);
+#endif
 } io_MockSystemCall;
 
 extern io_MockSystemCall io_mock_system_call;
@@ -152,20 +285,88 @@ io_accept(int sockfd, struct sockaddr* addr, socklen_t* addrlen)
     return io_mock_system_call.accept(sockfd, addr, addrlen);
 }
 
+IO_INLINE(int)
+io_accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags)
+{
+    return io_mock_system_call.accept4(sockfd, addr, addrlen, flags);
+}
+
 IO_INLINE(int)
 io_connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
 {
     return io_mock_system_call.connect(sockfd, addr, addrlen);
 }
 
+IO_INLINE(int)
+io_setsockopt(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+    return io_mock_system_call.setsockopt(sockfd, level, optname, optval, optlen);
+}
+
+IO_INLINE(int)
+io_getsockopt(int sockfd, int level, int optname, void* optval, socklen_t* optlen)
+{
+    return io_mock_system_call.getsockopt(sockfd, level, optname, optval, optlen);
+}
+
+IO_INLINE(ssize_t)
+io_sendto(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen)
+{
+    return io_mock_system_call.sendto(sockfd, buf, len, flags, dest_addr, addrlen);
+}
+
+IO_INLINE(int)
+io_ioctl(int fd, unsigned long request, void* arg)
+{
+    return io_mock_system_call.ioctl(fd, request, arg);
+}
+
 IO_INLINE(int)
 io_pipe(int pipefd[2])
 {
     return io_mock_system_call.pipe(pipefd);
 }
 
+IO_INLINE(int)
+io_getaddrinfo(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+    return io_mock_system_call.getaddrinfo(node, service, hints, res);
+}
+
+IO_INLINE(void)
+io_freeaddrinfo(struct addrinfo* res)
+{
+    io_mock_system_call.freeaddrinfo(res);
+}
+
 #define io_fcntl(...) io_mock_system_call.fcntl(__VA_ARGS__)
 
+#if IO_HAVE_EPOLL
+IO_INLINE(int)
+io_epoll_create1(int flags)
+{
+    return io_mock_system_call.epoll_create1(flags);
+}
+
+IO_INLINE(int)
+io_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event)
+{
+    return io_mock_system_call.epoll_ctl(epfd, op, fd, event);
+}
+
+IO_INLINE(int)
+io_timerfd_create(int clockid, int flags)
+{
+    return io_mock_system_call.timerfd_create(clockid, flags);
+}
+
+IO_INLINE(int)
+io_timerfd_settime(int fd, int flags, const struct itimerspec* new_value, struct itimerspec* old_value)
+{
+    return io_mock_system_call.timerfd_settime(fd, flags, new_value, old_value);
+}
+#endif // IO_HAVE_EPOLL
+
 #if IO_WITH_POLL
 IO_INLINE(int)
 io_poll(struct pollfd* fds, nfds_t nfds, int timeout)
@@ -29,6 +29,7 @@
 #define IO_EMFILE EMFILE
 #define IO_EADDRINUSE EADDRINUSE
 #define IO_EPIPE EPIPE
+#define IO_EBUSY EBUSY
 #elif TH_OS_WINDOWS
 #define IO_ENOTSUP ERROR_NOT_SUPPORTED
 #define IO_ECANCELED ERROR_CANCELLED
@@ -42,6 +43,7 @@
 #define IO_EMFILE ERROR_TOO_MANY_OPEN_FILES
 #define IO_EADDRINUSE ERROR_ADDRESS_IN_USE
 #define IO_EPIPE ERROR_BROKEN_PIPE
+#define IO_EBUSY ERROR_BUSY
 #endif
 
 IO_INLINE(const char*)
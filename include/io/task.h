@@ -8,6 +8,7 @@
 #define IO_TASK_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <io/err.h>
 
@@ -27,6 +28,10 @@ typedef enum io_OpType {
 typedef enum io_OpFlags {
     IO_OP_COMPLETED = 1,
     IO_OP_TRYIO = 1 << 1,
+    IO_OP_MULTISHOT = 1 << 2, // Stays armed after readiness, see multishot.h
+    IO_OP_QUEUED = 1 << 3,    // Multishot op is waiting in the loop queue or running
+    IO_OP_ACCEPT = 1 << 4,    // Accepts connections, cancelled first by io_Context_drain
+    IO_OP_NOTRY = 1 << 5,     // Only waits for readiness, never performed speculatively on submit
 } io_OpFlags;
 
 typedef void (*io_Op_abort_fn)(void* self, io_Err err);
@@ -36,6 +41,7 @@ typedef struct io_Op {
     io_Op_abort_fn abort;
     io_OpType type;
     io_OpFlags flags;
+    uint64_t seq; // Identifies the op for io_Op_cancel, 0 if no token was taken
 } io_Op;
 
 IO_INLINE(void)
@@ -45,6 +51,7 @@ io_Op_init(io_Op* task, io_OpType type, io_Task_fn fn, io_Op_abort_fn abort)
     task->type = type;
     task->abort = abort;
     task->flags = 0;
+    task->seq = 0;
 }
 
 IO_INLINE(void)
@@ -9,8 +9,6 @@
 
 #include <io/config.h>
 
-#include <io/config.h>
-
 #include <io/acceptor.h>
 #include <io/context.h>
 #include <io/err.h>
@@ -23,6 +21,8 @@
 
 typedef struct io_TcpAcceptor {
     io_Acceptor base;
+    struct io_TcpAcceptor* shards; // Listeners for the thread loops, see io_TcpAcceptor_init_sharded
+    size_t num_shards;
 } io_TcpAcceptor;
 
 DEFINE_DESCRIPTOR_WRAPPERS(io_TcpAcceptor, io_Acceptor)
@@ -49,7 +49,7 @@ io_parse_addr(const char* addr, struct sockaddr_in* sockaddr,
         ipstr[strlen(ipstr) - 1] = '\0';
         if (inet_pton(AF_INET6, &ipstr[1], &sockaddr6->sin6_addr) == 1) {
             sockaddr6->sin6_family = AF_INET6;
-            sockaddr6->sin6_port = port;
+            sockaddr6->sin6_port = htons(port);
             *sockaddr_out = (struct sockaddr*)sockaddr6;
             *sockaddr_len = sizeof(*sockaddr6);
             return IO_ERR_OK;
@@ -57,7 +57,7 @@ io_parse_addr(const char* addr, struct sockaddr_in* sockaddr,
     } else {
         if (inet_pton(AF_INET, ipstr, &sockaddr->sin_addr) == 1) {
             sockaddr->sin_family = AF_INET;
-            sockaddr->sin_port = port;
+            sockaddr->sin_port = htons(port);
             *sockaddr_out = (struct sockaddr*)sockaddr;
             *sockaddr_len = sizeof(*sockaddr);
             return IO_ERR_OK;
@@ -66,21 +66,35 @@ io_parse_addr(const char* addr, struct sockaddr_in* sockaddr,
     return io_SystemErr(IO_EINVAL);
 }
 
+/** io_TcpAcceptor_listen
+ * @brief Opens a listening socket for `addr` and registers it on `loop`.
+ */
 IO_INLINE(io_Err)
-io_TcpAcceptor_init(io_TcpAcceptor* acceptor, io_Context* ctx, const char* addr)
+io_TcpAcceptor_listen(io_TcpAcceptor* acceptor, io_Loop* loop, const char* addr, bool reuse_port)
 {
-    io_Acceptor_init(&acceptor->base, ctx);
-    int fd = io_socket(AF_INET, SOCK_STREAM, 0);
-    if (fd == -1) {
-        return io_SystemErr(errno);
-    }
     struct sockaddr_in sockaddr = {0};
     struct sockaddr_in6 sockaddr6 = {0};
     struct sockaddr* sockaddr_out = NULL;
     socklen_t sockaddr_len = 0;
     io_Err err = IO_ERR_OK;
     if ((err = io_parse_addr(addr, &sockaddr, &sockaddr6, &sockaddr_out, &sockaddr_len))) {
+        return err;
+    }
+    int fd = io_socket(sockaddr_out->sa_family, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return io_SystemErr(errno);
+    }
+    if (reuse_port) {
+#ifdef SO_REUSEPORT
+        int on = 1;
+        if (io_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1) {
+            err = io_SystemErr(errno);
+            goto cleanup_socket;
+        }
+#else
+        err = io_SystemErr(IO_ENOTSUP);
         goto cleanup_socket;
+#endif
     }
     if (io_bind(fd, (struct sockaddr*)sockaddr_out, sockaddr_len) == -1) {
         err = io_SystemErr(errno);
@@ -90,17 +104,134 @@ io_TcpAcceptor_init(io_TcpAcceptor* acceptor, io_Context* ctx, const char* addr)
         err = io_SystemErr(errno);
         goto cleanup_socket;
     }
-    io_Acceptor_set_fd(&acceptor->base, fd);
+    if (loop) {
+        io_Acceptor_set_fd_on_loop(&acceptor->base, loop, fd);
+    } else {
+        io_Acceptor_set_fd(&acceptor->base, fd);
+    }
     return err;
 cleanup_socket:
     io_close(fd);
     return err;
 }
 
+IO_INLINE(io_Err)
+io_TcpAcceptor_init(io_TcpAcceptor* acceptor, io_Context* ctx, const char* addr)
+{
+    io_Acceptor_init(&acceptor->base, ctx);
+    acceptor->shards = NULL;
+    acceptor->num_shards = 0;
+    return io_TcpAcceptor_listen(acceptor, NULL, addr, false);
+}
+
 IO_INLINE(void)
 io_TcpAcceptor_deinit(io_TcpAcceptor* acceptor)
 {
+    for (size_t i = 0; i < acceptor->num_shards; ++i) {
+        io_TcpAcceptor_deinit(&acceptor->shards[i]);
+    }
+    if (acceptor->shards) {
+        io_free(io_Acceptor_get_context(&acceptor->base)->allocator, acceptor->shards);
+        acceptor->shards = NULL;
+    }
+    acceptor->num_shards = 0;
     io_Acceptor_deinit(&acceptor->base);
 }
 
+/** io_TcpAcceptor_init_sharded
+ * @brief Opens one SO_REUSEPORT listener per loop of `ctx`, each
+ * registered only with its own loop's reactor. The kernel spreads
+ * incoming connections across the listeners and accepted sockets
+ * stay on the loop that accepted them.
+ * The thread loops must be created (io_Context_set_num_threads)
+ * before calling this. Use io_TcpAcceptor_shard to submit accepts
+ * on every listener.
+ */
+IO_INLINE(io_Err)
+io_TcpAcceptor_init_sharded(io_TcpAcceptor* acceptor, io_Context* ctx, const char* addr)
+{
+    io_Acceptor_init(&acceptor->base, ctx);
+    acceptor->base.keep_on_loop = true;
+    acceptor->shards = NULL;
+    acceptor->num_shards = 0;
+    io_Err err = IO_ERR_OK;
+    if ((err = io_TcpAcceptor_listen(acceptor, ctx->loop, addr, true))) {
+        return err;
+    }
+    size_t num_loops = io_Context_num_thread_loops(ctx);
+    if (num_loops == 0) {
+        return IO_ERR_OK;
+    }
+    acceptor->shards = io_alloc(ctx->allocator, num_loops * sizeof(io_TcpAcceptor));
+    if (!acceptor->shards) {
+        err = io_SystemErr(IO_ENOMEM);
+        goto cleanup;
+    }
+    for (size_t i = 0; i < num_loops; ++i) {
+        io_TcpAcceptor* shard = &acceptor->shards[i];
+        io_Acceptor_init(&shard->base, ctx);
+        shard->base.keep_on_loop = true;
+        shard->shards = NULL;
+        shard->num_shards = 0;
+        if ((err = io_TcpAcceptor_listen(shard, io_Context_loop_at(ctx, i + 1), addr, true))) {
+            goto cleanup;
+        }
+        acceptor->num_shards++;
+    }
+    return IO_ERR_OK;
+cleanup:
+    io_TcpAcceptor_deinit(acceptor);
+    return err;
+}
+
+/** io_TcpAcceptor_set_options
+ * @brief Applies the options to the listening socket of every shard.
+ */
+IO_INLINE(io_Err)
+io_TcpAcceptor_set_options(io_TcpAcceptor* acceptor, const io_SocketOptions* options)
+{
+    io_Err err = IO_ERR_OK;
+    if ((err = io_Acceptor_set_options(&acceptor->base, options))) {
+        return err;
+    }
+    for (size_t i = 0; i < acceptor->num_shards; ++i) {
+        if ((err = io_Acceptor_set_options(&acceptor->shards[i].base, options))) {
+            return err;
+        }
+    }
+    return IO_ERR_OK;
+}
+
+/** io_TcpAcceptor_set_accept_options
+ * @brief Sets the defaults sockets accepted by any shard are configured with.
+ */
+IO_INLINE(void)
+io_TcpAcceptor_set_accept_options(io_TcpAcceptor* acceptor, const io_SocketOptions* options)
+{
+    io_Acceptor_set_accept_options(&acceptor->base, options);
+    for (size_t i = 0; i < acceptor->num_shards; ++i) {
+        io_Acceptor_set_accept_options(&acceptor->shards[i].base, options);
+    }
+}
+
+/** io_TcpAcceptor_num_shards
+ * @brief Number of listeners, 1 for an acceptor that isn't sharded.
+ */
+IO_INLINE(size_t)
+io_TcpAcceptor_num_shards(const io_TcpAcceptor* acceptor)
+{
+    return acceptor->num_shards + 1;
+}
+
+/** io_TcpAcceptor_shard
+ * @brief The listener at `index`, index 0 is the acceptor itself
+ * and lives on the context's main loop.
+ */
+IO_INLINE(io_TcpAcceptor*)
+io_TcpAcceptor_shard(io_TcpAcceptor* acceptor, size_t index)
+{
+    IO_ASSERT(index <= acceptor->num_shards, "Shard index out of range");
+    return index == 0 ? acceptor : &acceptor->shards[index - 1];
+}
+
 #endif
@@ -9,10 +9,15 @@
 
 #include <io/config.h>
 
+#include <io/context.h>
 #include <io/gai_err.h>
+#include <io/other_err.h>
+#include <io/resolver.h>
 #include <io/socket.h>
 #include <io/system_call.h>
 
+#include <string.h>
+
 #if IO_OS_POSIX
 #include <netdb.h>
 #include <netinet/in.h>
@@ -40,45 +45,292 @@ io_TcpSocket_init(io_TcpSocket* socket, io_Context* ctx, const char* addr)
     return IO_ERR_OK;
 }
 
+/** io_split_host_port
+ * @brief Split "host:port" (or "[ipv6]:port") into host and port.
+ */
+IO_INLINE(io_Err)
+io_split_host_port(const char* addr, char* host, size_t host_size, char* port, size_t port_size)
+{
+    const char* sep = strrchr(addr, ':');
+    if (!sep || sep[1] == '\0') {
+        return io_SystemErr(IO_EINVAL);
+    }
+    size_t host_len = (size_t)(sep - addr);
+    if (host_len > 1 && addr[0] == '[' && addr[host_len - 1] == ']') {
+        ++addr;
+        host_len -= 2;
+    }
+    if (host_len >= host_size || strlen(sep + 1) >= port_size) {
+        return io_SystemErr(IO_EINVAL);
+    }
+    memcpy(host, addr, host_len);
+    host[host_len] = '\0';
+    strcpy(port, sep + 1);
+    return IO_ERR_OK;
+}
+
+IO_INLINE(io_Err)
+io_TcpSocket_connect_endpoints(io_TcpSocket* socket, const io_ResolverResult* result)
+{
+    for (size_t i = 0; i < result->count; ++i) {
+        const io_Endpoint* endpoint = &result->endpoints[i];
+        int fd = io_socket(endpoint->family, endpoint->socktype, endpoint->protocol);
+        if (fd == -1) {
+            continue;
+        }
+        if (io_connect(fd, (const struct sockaddr*)&endpoint->addr, endpoint->addrlen) == -1) {
+            io_close(fd);
+            continue;
+        }
+        io_Socket_set_fd(&socket->base, fd);
+        return IO_ERR_OK;
+    }
+    return io_OtherErr(IO_OTHER_ERRC_NO_ENDPOINT);
+}
+
 IO_INLINE(io_Err)
 io_TcpSocket_connect(io_TcpSocket* socket, const char* addr)
 {
-    struct addrinfo hints = {0};
-    struct addrinfo *servinfo, *p;
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
+    char host[IO_RESOLVER_MAX_HOST];
+    char port[IO_RESOLVER_MAX_SERVICE];
+    io_Err err = IO_ERR_OK;
+    if ((err = io_split_host_port(addr, host, sizeof(host), port, sizeof(port)))) {
+        return err;
+    }
+    io_ResolverResult result;
+    if ((err = io_Resolver_resolve(io_Context_resolver(io_TcpSocket_get_context(socket)), host, port, &result))) {
+        return err;
+    }
+    return io_TcpSocket_connect_endpoints(socket, &result);
+}
 
-    const char* portstr = strrchr(addr, ':') + 1;
-    if (!portstr) {
-        return io_SystemErr(IO_EINVAL);
+/** io_TcpSocket_connect_with_data
+ * @brief Connects to addr and sends `data` with the SYN using TCP Fast Open.
+ * On return `size` holds the number of bytes sent, the kernel falls
+ * back to a regular handshake if no TFO cookie is cached for the peer.
+ * Without MSG_FASTOPEN this is a connect followed by a write.
+ */
+IO_INLINE(io_Err)
+io_TcpSocket_connect_with_data(io_TcpSocket* socket, const char* addr, const void* data, size_t* size)
+{
+    char host[IO_RESOLVER_MAX_HOST];
+    char port[IO_RESOLVER_MAX_SERVICE];
+    io_Err err = IO_ERR_OK;
+    if ((err = io_split_host_port(addr, host, sizeof(host), port, sizeof(port)))) {
+        return err;
+    }
+    io_ResolverResult result;
+    if ((err = io_Resolver_resolve(io_Context_resolver(io_TcpSocket_get_context(socket)), host, port, &result))) {
+        return err;
+    }
+#ifdef MSG_FASTOPEN
+    for (size_t i = 0; i < result.count; ++i) {
+        const io_Endpoint* endpoint = &result.endpoints[i];
+        int fd = io_socket(endpoint->family, endpoint->socktype, endpoint->protocol);
+        if (fd == -1) {
+            continue;
+        }
+        ssize_t sent = io_sendto(fd, data, *size, MSG_FASTOPEN,
+                                 (const struct sockaddr*)&endpoint->addr, endpoint->addrlen);
+        if (sent == -1) {
+            io_close(fd);
+            continue;
+        }
+        io_Socket_set_fd(&socket->base, fd);
+        *size = (size_t)sent;
+        return IO_ERR_OK;
+    }
+    return io_OtherErr(IO_OTHER_ERRC_NO_ENDPOINT);
+#else
+    if ((err = io_TcpSocket_connect_endpoints(socket, &result))) {
+        return err;
+    }
+    return io_Socket_write(&socket->base, data, size);
+#endif
+}
+
+typedef void (*io_ConnectCallback)(void* user_data, io_Err err);
+
+/** io_TcpConnectRequest
+ * @brief State of io_TcpSocket_async_connect. The endpoints are tried in
+ * order with non-blocking connects, a refused one falls through to the next.
+ */
+typedef struct io_TcpConnectRequest {
+    io_TcpSocket* socket;
+    io_Loop* loop;
+    io_ConnectCallback callback;
+    void* user_data;
+    io_ResolverResult result;
+    size_t next;  // Endpoint being connected to
+    uint64_t seq; // Of the caller's io_OpToken, carried by the wait of every endpoint
+} io_TcpConnectRequest;
+
+IO_INLINE(void)
+io_TcpConnectRequest_finish(io_TcpConnectRequest* request, io_Err err)
+{
+    io_ConnectCallback callback = request->callback;
+    void* callback_data = request->user_data;
+    io_free(io_TcpSocket_get_context(request->socket)->allocator, request);
+    callback(callback_data, err);
+}
+
+IO_INLINE(void)
+io_TcpConnectRequest_try_next(io_TcpConnectRequest* request);
+
+IO_INLINE(void)
+io_TcpConnectRequest_on_writable(void* user_data, io_Err err);
+
+/** io_TcpConnectRequest_wait
+ * @brief Waits for the pending connect like io_Descriptor_async_wait,
+ * with the wait op answering to the caller's token.
+ */
+IO_INLINE(io_Err)
+io_TcpConnectRequest_wait(io_TcpConnectRequest* request)
+{
+    io_Descriptor* descriptor = &request->socket->base.base;
+    io_WaitOp* op = io_WaitOp_create(descriptor->context, io_Descriptor_allocator(descriptor), IO_OP_WRITE,
+                                     io_TcpConnectRequest_on_writable, request);
+    if (!op) {
+        return io_SystemErr(IO_ENOMEM);
     }
-    char ipstr[64] = {0};
-    snprintf(ipstr, sizeof(ipstr), "%.*s", (int)(portstr - addr) - 1, addr);
+    op->base.seq = request->seq;
+    io_Err err = io_Handle_submit(descriptor->handle, &op->base);
+    if (err) {
+        io_Allocator_free(op->allocator, op);
+    } else if (io_Descriptor_cancelled(descriptor, request->seq)) {
+        // The cancel came while we submitted, it may have searched the slots before
+        io_Handle_cancel_op(descriptor->handle, IO_OP_WRITE, request->seq);
+    }
+    return err;
+}
 
-    int ret = 0;
-    if ((ret = getaddrinfo(ipstr, portstr, &hints, &servinfo)) != 0) {
-        return io_GaiErr(ret);
+IO_INLINE(void)
+io_TcpConnectRequest_on_writable(void* user_data, io_Err err)
+{
+    io_TcpConnectRequest* request = user_data;
+    io_Descriptor* descriptor = &request->socket->base.base;
+    if (err == io_SystemErr(IO_ECANCELED)) {
+        io_Descriptor_clear_fd(descriptor);
+        io_TcpConnectRequest_finish(request, err);
+        return;
+    }
+    if (!err) {
+        int so_error = 0;
+        socklen_t len = sizeof(so_error);
+        if (io_getsockopt(io_Descriptor_get_fd(descriptor), SOL_SOCKET, SO_ERROR, &so_error, &len) == -1) {
+            err = io_SystemErr(errno);
+        } else if (so_error) {
+            err = io_SystemErr(so_error);
+        }
     }
+    if (!err) {
+        io_TcpConnectRequest_finish(request, IO_ERR_OK);
+        return;
+    }
+    io_Descriptor_clear_fd(descriptor);
+    ++request->next;
+    io_TcpConnectRequest_try_next(request);
+}
 
-    int fd = 0;
-    for (p = servinfo; p != NULL; p = p->ai_next) {
-        if ((fd = io_socket(p->ai_family, p->ai_socktype, p->ai_protocol)) == -1) {
+/** io_TcpConnectRequest_try_next
+ * @brief Starts a non-blocking connect to the next endpoint, the loop
+ * is never blocked on the handshake.
+ */
+IO_INLINE(void)
+io_TcpConnectRequest_try_next(io_TcpConnectRequest* request)
+{
+    io_Descriptor* descriptor = &request->socket->base.base;
+    if (io_Descriptor_cancelled(descriptor, request->seq)) {
+        // Cancelled while resolving or between two endpoints
+        io_TcpConnectRequest_finish(request, io_SystemErr(IO_ECANCELED));
+        return;
+    }
+    for (; request->next < request->result.count; ++request->next) {
+        const io_Endpoint* endpoint = &request->result.endpoints[request->next];
+        int fd = io_socket(endpoint->family, endpoint->socktype, endpoint->protocol);
+        if (fd == -1) {
             continue;
         }
-        if (io_connect(fd, p->ai_addr, p->ai_addrlen) == -1) {
+        io_Descriptor_set_fd_on_loop(descriptor, request->loop, fd);
+        if (!descriptor->handle) {
             io_close(fd);
             continue;
         }
-        break;
+        if (io_Descriptor_set_non_blocking(descriptor, true)) {
+            io_Descriptor_clear_fd(descriptor);
+            continue;
+        }
+        if (io_connect(fd, (const struct sockaddr*)&endpoint->addr, endpoint->addrlen) != -1) {
+            io_TcpConnectRequest_finish(request, IO_ERR_OK);
+            return;
+        }
+        if (errno == EINPROGRESS && io_TcpConnectRequest_wait(request) == IO_ERR_OK) {
+            return;
+        }
+        io_Descriptor_clear_fd(descriptor);
+    }
+    io_TcpConnectRequest_finish(request, io_OtherErr(IO_OTHER_ERRC_NO_ENDPOINT));
+}
+
+IO_INLINE(void)
+io_TcpConnectRequest_on_resolve(void* user_data, const io_ResolverResult* result, io_Err err)
+{
+    io_TcpConnectRequest* request = user_data;
+    if (err) {
+        io_TcpConnectRequest_finish(request, err);
+        return;
+    }
+    request->result = *result;
+    request->next = 0;
+    io_TcpConnectRequest_try_next(request);
+}
+
+/** io_TcpSocket_async_connect_with_token
+ * @brief Connect to addr, the name is resolved off-loop through the context resolver.
+ * The socket is put in non-blocking mode and registered with the calling loop,
+ * the callback runs like the completion of an op on it once the socket is connected.
+ * Single-threaded contexts get IO_ENOTSUP, see io_Resolver_async_resolve.
+ * If `token` isn't NULL, io_Op_cancel stops the connect with ECANCELED, also
+ * while the name is being resolved; io_Op_cancel returns false then.
+ */
+IO_INLINE(io_Err)
+io_TcpSocket_async_connect_with_token(io_TcpSocket* socket, const char* addr, io_ConnectCallback callback, void* user_data, io_OpToken* token)
+{
+    char host[IO_RESOLVER_MAX_HOST];
+    char port[IO_RESOLVER_MAX_SERVICE];
+    io_Err err = IO_ERR_OK;
+    if ((err = io_split_host_port(addr, host, sizeof(host), port, sizeof(port)))) {
+        return err;
+    }
+    io_Context* context = io_TcpSocket_get_context(socket);
+    io_TcpConnectRequest* request = io_alloc(context->allocator, sizeof(io_TcpConnectRequest));
+    if (!request) {
+        return io_SystemErr(IO_ENOMEM);
     }
-    if (p == NULL) {
-        return io_OtherErr(IO_OTHER_ERRC_NO_ENDPOINT);
+    request->socket = socket;
+    request->loop = io_Context_this_loop(context);
+    request->callback = callback;
+    request->user_data = user_data;
+    request->next = 0;
+    request->seq = 0;
+    if (token) {
+        io_Descriptor_reserve_token(&socket->base.base, IO_OP_WRITE, token);
+        request->seq = token->seq;
+    }
+    if ((err = io_Resolver_async_resolve(io_Context_resolver(context), request->loop,
+                                         host, port, io_TcpConnectRequest_on_resolve, request))) {
+        io_free(context->allocator, request);
+        return err;
     }
-    freeaddrinfo(servinfo);
-    io_Socket_set_fd(&socket->base, fd);
     return IO_ERR_OK;
 }
 
+IO_INLINE(io_Err)
+io_TcpSocket_async_connect(io_TcpSocket* socket, const char* addr, io_ConnectCallback callback, void* user_data)
+{
+    return io_TcpSocket_async_connect_with_token(socket, addr, callback, user_data, NULL);
+}
+
 IO_INLINE(void)
 io_TcpSocket_deinit(io_TcpSocket* socket)
 {
@@ -9,23 +9,58 @@
 
 #include <io/config.h>
 #include <io/err.h>
+#include <io/vec.h>
+
+#include <stdbool.h>
+#include <stddef.h>
 
 typedef void* (*io_ThreadFunc)(void* user_data);
 
+typedef enum io_SchedPolicy {
+    IO_SCHED_INHERIT, // Same policy and priority as the creating thread
+    IO_SCHED_OTHER,
+    IO_SCHED_FIFO,
+    IO_SCHED_RR,
+} io_SchedPolicy;
+
+/** io_ThreadOptions
+ * @brief Attributes of a new thread, zeroed options give a default thread.
+ * Naming and pinning are applied by the thread itself with io_Thread_setup_self
+ * and need Linux and _GNU_SOURCE. Without them, the name is ignored and
+ * pinning fails with IO_ENOTSUP.
+ */
+typedef struct io_ThreadOptions {
+    const char* name;  // At most 15 characters, NULL keeps the inherited name
+    size_t stack_size; // 0 for the default
+    bool pin;          // Restrict the thread to `cpu`
+    unsigned cpu;
+    io_SchedPolicy sched_policy;
+    int sched_priority;
+} io_ThreadOptions;
+
 #if IO_WITH_THREADS
 
 #include <io/assert.h>
 
 #include <errno.h>
 #include <pthread.h>
+#include <sched.h>
+
+#if defined(__linux__) && defined(_GNU_SOURCE)
+#define IO_HAVE_PTHREAD_NP 1
+#else
+#define IO_HAVE_PTHREAD_NP 0
+#endif
 
 typedef struct io_Mutex {
     pthread_mutex_t mtx;
+    bool elided; // Set by io_Mutex_elide
 } io_Mutex;
 
 IO_INLINE(io_Err)
 io_Mutex_init(io_Mutex* mtx)
 {
+    mtx->elided = false;
     if (pthread_mutex_init(&mtx->mtx, NULL) != 0) {
         return io_SystemErr(errno);
     }
@@ -35,14 +70,31 @@ io_Mutex_init(io_Mutex* mtx)
 IO_INLINE(void)
 io_Mutex_deinit(io_Mutex* mtx)
 {
+    if (mtx->elided) {
+        return;
+    }
     int err = pthread_mutex_destroy(&mtx->mtx);
     (void)err;
     IO_ASSERT(err == 0, "Failed to destroy mutex");
 }
 
+/** io_Mutex_elide
+ * @brief Turns an initialized, unlocked mutex into one whose lock and
+ * unlock do nothing, for state that only one thread touches from now on.
+ */
+IO_INLINE(void)
+io_Mutex_elide(io_Mutex* mtx)
+{
+    io_Mutex_deinit(mtx);
+    mtx->elided = true;
+}
+
 IO_INLINE(void)
 io_Mutex_lock(io_Mutex* mtx)
 {
+    if (mtx->elided) {
+        return;
+    }
     int err = pthread_mutex_lock(&mtx->mtx);
     (void)err;
     IO_ASSERT(err == 0, "Failed to lock mutex");
@@ -51,6 +103,9 @@ io_Mutex_lock(io_Mutex* mtx)
 IO_INLINE(void)
 io_Mutex_unlock(io_Mutex* mtx)
 {
+    if (mtx->elided) {
+        return;
+    }
     int err = pthread_mutex_unlock(&mtx->mtx);
     (void)err;
     IO_ASSERT(err == 0, "Failed to unlock mutex");
@@ -80,6 +135,7 @@ io_Cond_deinit(io_Cond* cond)
 IO_INLINE(void)
 io_Cond_wait(io_Cond* cond, io_Mutex* mtx)
 {
+    IO_ASSERT(!mtx->elided, "Waiting with an elided mutex");
     int err = pthread_cond_wait(&cond->cond, &mtx->mtx);
     (void)err;
     IO_ASSERT(err == 0, "Failed to wait on condition variable");
@@ -93,20 +149,99 @@ io_Cond_signal(io_Cond* cond)
     IO_ASSERT(err == 0, "Failed to signal condition variable");
 }
 
+IO_INLINE(void)
+io_Cond_broadcast(io_Cond* cond)
+{
+    int err = pthread_cond_broadcast(&cond->cond);
+    (void)err;
+    IO_ASSERT(err == 0, "Failed to broadcast condition variable");
+}
+
 typedef struct io_Thread {
     pthread_t thread;
 } io_Thread;
 
+IO_INLINE(int)
+io_SchedPolicy_native(io_SchedPolicy policy)
+{
+    switch (policy) {
+    case IO_SCHED_FIFO:
+        return SCHED_FIFO;
+    case IO_SCHED_RR:
+        return SCHED_RR;
+    case IO_SCHED_OTHER:
+    case IO_SCHED_INHERIT:
+    default:
+        return SCHED_OTHER;
+    }
+}
+
+/** io_Thread_init_with_options
+ * @brief Starts a thread with the stack size and scheduling of `options`,
+ * `options` may be NULL.
+ */
 IO_INLINE(io_Err)
-io_Thread_init(io_Thread* thread, io_ThreadFunc func, void* user_data)
+io_Thread_init_with_options(io_Thread* thread, const io_ThreadOptions* options, io_ThreadFunc func, void* user_data)
 {
-    int err = pthread_create(&thread->thread, NULL, func, user_data);
+    pthread_attr_t attr;
+    int err = pthread_attr_init(&attr);
+    if (err != 0) {
+        return io_SystemErr(err);
+    }
+    if (options && options->stack_size && (err = pthread_attr_setstacksize(&attr, options->stack_size)) != 0) {
+        goto destroy_attr;
+    }
+    if (options && options->sched_policy != IO_SCHED_INHERIT) {
+        struct sched_param param = {.sched_priority = options->sched_priority};
+        if ((err = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED)) != 0
+            || (err = pthread_attr_setschedpolicy(&attr, io_SchedPolicy_native(options->sched_policy))) != 0
+            || (err = pthread_attr_setschedparam(&attr, &param)) != 0) {
+            goto destroy_attr;
+        }
+    }
+    err = pthread_create(&thread->thread, &attr, func, user_data);
+destroy_attr:
+    pthread_attr_destroy(&attr);
     if (err != 0) {
         return io_SystemErr(err);
     }
     return IO_ERR_OK;
 }
 
+IO_INLINE(io_Err)
+io_Thread_init(io_Thread* thread, io_ThreadFunc func, void* user_data)
+{
+    return io_Thread_init_with_options(thread, NULL, func, user_data);
+}
+
+/** io_Thread_setup_self
+ * @brief Applies the name and CPU pinning of `options` to the calling thread.
+ */
+IO_INLINE(io_Err)
+io_Thread_setup_self(const io_ThreadOptions* options)
+{
+    if (!options || (!options->pin && !options->name)) {
+        return IO_ERR_OK;
+    }
+#if IO_HAVE_PTHREAD_NP
+    int err = 0;
+    if (options->pin) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(options->cpu, &set);
+        if ((err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) != 0) {
+            return io_SystemErr(err);
+        }
+    }
+    if (options->name && (err = pthread_setname_np(pthread_self(), options->name)) != 0) {
+        return io_SystemErr(err);
+    }
+    return IO_ERR_OK;
+#else
+    return options->pin ? io_SystemErr(IO_ENOTSUP) : IO_ERR_OK;
+#endif
+}
+
 IO_INLINE(void)
 io_Thread_deinit(io_Thread* thread)
 {
@@ -167,6 +302,12 @@ io_Mutex_deinit(io_Mutex* mtx)
     (void)mtx;
 }
 
+IO_INLINE(void)
+io_Mutex_elide(io_Mutex* mtx)
+{
+    (void)mtx;
+}
+
 IO_INLINE(void)
 io_Mutex_lock(io_Mutex* mtx)
 {
@@ -203,25 +344,45 @@ io_Cond_wait(io_Cond* cond, io_Mutex* mtx)
     (void)mtx;
 }
 
-IO_INLINE(void
+IO_INLINE(void)
 io_Cond_signal(io_Cond* cond)
 {
     (void)cond;
 }
 
+IO_INLINE(void)
+io_Cond_broadcast(io_Cond* cond)
+{
+    (void)cond;
+}
+
 typedef struct io_Thread {
     int dummy;
 } io_Thread;
 
 IO_INLINE(io_Err)
-io_Thread_init(io_Thread* thread, io_ThreadFunc func, void* user_data)
+io_Thread_init_with_options(io_Thread* thread, const io_ThreadOptions* options, io_ThreadFunc func, void* user_data)
 {
     (void)thread;
+    (void)options;
     (void)func;
     (void)user_data;
     return IO_ERR_OK;
 }
 
+IO_INLINE(io_Err)
+io_Thread_init(io_Thread* thread, io_ThreadFunc func, void* user_data)
+{
+    return io_Thread_init_with_options(thread, NULL, func, user_data);
+}
+
+IO_INLINE(io_Err)
+io_Thread_setup_self(const io_ThreadOptions* options)
+{
+    (void)options;
+    return IO_ERR_OK;
+}
+
 IO_INLINE(void)
 io_Thread_deinit(io_Thread* thread)
 {
@@ -258,4 +419,7 @@ io_ThisThreadData_get(io_ThisThreadData* this_thread)
 }
 
 #endif
+
+IO_DEFINE_VEC(io_ThreadVec, io_Thread, io_Thread_deinit)
+
 #endif
@@ -22,6 +22,12 @@ typedef enum io_Duration {
     IO_DURATION_TYPE
 } io_Duration;
 
+IO_INLINE(io_Duration)
+io_Milliseconds(int milliseconds)
+{
+    return (io_Duration)milliseconds;
+}
+
 IO_INLINE(io_Duration)
 io_Seconds(int seconds)
 {
@@ -99,6 +105,23 @@ io_TimerImpl_monotonic_now(time_t* out)
 #endif
 }
 
+/** io_monotonic_ns
+ * @brief Monotonic clock in nanoseconds, meant for measuring short intervals.
+ */
+IO_INLINE(uint64_t)
+io_monotonic_ns(void)
+{
+#if IO_OS_POSIX
+    struct timespec ts = {0};
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#elif IO_OS_WINDOWS
+    return (uint64_t)GetTickCount64() * 1000000u;
+#endif
+}
+
 IO_INLINE(void)
 io_Timer_set(io_Timer* timer, io_Duration duration)
 {
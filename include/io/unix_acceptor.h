@@ -38,11 +38,6 @@ io_UnixAcceptor_init(io_UnixAcceptor* acceptor, io_Context* ctx, const char* pat
         return io_SystemErr(errno);
     }
     io_Err err = IO_ERR_OK;
-    // Set the socket to non-blocking mode
-    if (io_fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
-        err = io_SystemErr(errno);
-        goto cleanup_socket;
-    }
     struct sockaddr_un addr = {0};
     addr.sun_family = AF_UNIX;
     strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
@@ -55,12 +50,29 @@ io_UnixAcceptor_init(io_UnixAcceptor* acceptor, io_Context* ctx, const char* pat
         goto cleanup_socket;
     }
     io_Acceptor_set_fd(&acceptor->base, fd);
+    // Non-blocking through the descriptor, so accepted sockets inherit it
+    err = io_Acceptor_set_non_blocking(&acceptor->base, true);
+    if (err) {
+        io_Acceptor_close(&acceptor->base);
+    }
     return err;
 cleanup_socket:
     io_close(fd);
     return err;
 }
 
+IO_INLINE(io_Err)
+io_UnixAcceptor_set_options(io_UnixAcceptor* acceptor, const io_SocketOptions* options)
+{
+    return io_Acceptor_set_options(&acceptor->base, options);
+}
+
+IO_INLINE(void)
+io_UnixAcceptor_set_accept_options(io_UnixAcceptor* acceptor, const io_SocketOptions* options)
+{
+    io_Acceptor_set_accept_options(&acceptor->base, options);
+}
+
 IO_INLINE(void)
 io_UnixAcceptor_deinit(io_UnixAcceptor* acceptor)
 {
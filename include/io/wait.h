@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_WAIT_H
+#define IO_WAIT_H
+
+#include <io/config.h>
+
+#include <io/allocator.h>
+#include <io/context.h>
+#include <io/err.h>
+#include <io/task.h>
+
+typedef void (*io_WaitCallback)(void* user_data, io_Err err);
+
+/** io_WaitOp
+ * @brief Readiness-only operation, it performs no I/O and just
+ * reports that the fd became readable or writable.
+ */
+typedef struct io_WaitOp {
+    io_Op base;
+    io_Allocator* allocator;
+    io_Context* context;
+    io_WaitCallback callback;
+    void* user_data;
+    io_Err err;
+} io_WaitOp;
+
+IO_INLINE(void)
+io_WaitOp_finalize(io_WaitOp* op)
+{
+    io_Allocator* allocator = op->allocator;
+    op->callback(op->user_data, op->err);
+    io_Allocator_free(allocator, op);
+}
+
+IO_INLINE(void)
+io_WaitOp_complete(io_WaitOp* op, io_Err err)
+{
+    op->err = err;
+    io_Op_set_flags(&op->base, IO_OP_COMPLETED);
+    io_Context_post_completion(op->context, &op->base.base);
+}
+
+IO_INLINE(void)
+io_WaitOp_fn(void* self)
+{
+    io_WaitOp* op = self;
+    if (io_Op_flags(&op->base) & IO_OP_COMPLETED) {
+        io_WaitOp_finalize(op);
+    } else if (io_Op_flags(&op->base) & IO_OP_TRYIO) {
+        // Nothing to try, readiness is only known once the reactor reports it
+        return;
+    } else if (io_Context_completes_inline(op->context)) {
+        // Run from the loop after the reactor reported readiness,
+        // no need for another trip through the queue.
+        op->err = IO_ERR_OK;
+        io_WaitOp_finalize(op);
+    } else {
+        io_WaitOp_complete(op, IO_ERR_OK);
+    }
+}
+
+IO_INLINE(void)
+io_WaitOp_abort(void* self, io_Err err)
+{
+    io_WaitOp* op = self;
+    io_WaitOp_complete(op, err);
+}
+
+IO_INLINE(io_WaitOp*)
+io_WaitOp_create(io_Context* context, io_Allocator* allocator, io_OpType type, io_WaitCallback callback, void* user_data)
+{
+    io_WaitOp* op = io_Allocator_alloc(allocator, sizeof(io_WaitOp));
+    if (!op) {
+        return NULL;
+    }
+    io_Op_init(&op->base, type, io_WaitOp_fn, io_WaitOp_abort);
+    io_Op_set_flags(&op->base, IO_OP_NOTRY);
+    op->allocator = allocator;
+    op->context = context;
+    op->callback = callback;
+    op->user_data = user_data;
+    op->err = IO_ERR_OK;
+    return op;
+}
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2025 c-io Contributers
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef IO_WORKER_POOL_H
+#define IO_WORKER_POOL_H
+
+#include <io/config.h>
+
+#include <io/allocator.h>
+#include <io/atomic.h>
+#include <io/err.h>
+#include <io/loop.h>
+#include <io/mpsc.h>
+#include <io/task.h>
+#include <io/thread.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct io_WorkerPool;
+
+/** io_Worker
+ * @brief A thread that runs the tasks of its lock-free queue. It only
+ * takes the mutex to go to sleep, producers only take it to wake a
+ * sleeping worker.
+ */
+typedef struct io_Worker {
+    io_TaskMpsc queue;
+    io_Mutex mtx;
+    io_Cond cond;
+    size_t pending; // Tasks pushed and not yet popped
+    bool sleeping;
+    io_Thread thread;
+    struct io_WorkerPool* pool;
+} io_Worker;
+
+/** io_WorkerPool
+ * @brief Threads that run the completions of the loops, so that heavy
+ * callbacks don't hold up the reactors. Tasks count towards the loops'
+ * task counter until they ran, the pool wakes `loop` once it drops to 0.
+ */
+typedef struct io_WorkerPool {
+    io_Allocator* allocator;
+    io_Worker* workers;
+    size_t num_workers;
+    size_t next; // Round robin index
+    size_t* num_tasks;
+    io_Loop* loop;
+    bool stop;
+} io_WorkerPool;
+
+IO_INLINE(void*)
+io_Worker_run(void* user_data)
+{
+    io_Worker* worker = user_data;
+    io_WorkerPool* pool = worker->pool;
+    while (1) {
+        io_Task* task = io_TaskMpsc_pop(&worker->queue);
+        if (task) {
+            io_atomic_dec(&worker->pending);
+            task->fn(task);
+            if (io_atomic_dec(pool->num_tasks) == 0) {
+                // The loops may all be waiting in their reactor for the last task
+                io_Reactor_interrupt(pool->loop->reactor);
+            }
+            continue;
+        }
+        if (io_atomic_load(&worker->pending) > 0) {
+            // A push is halfway done
+            continue;
+        }
+        io_Mutex_lock(&worker->mtx);
+        io_atomic_store(&worker->sleeping, true);
+        while (io_atomic_load(&worker->pending) == 0 && !io_atomic_load(&pool->stop)) {
+            io_Cond_wait(&worker->cond, &worker->mtx);
+        }
+        io_atomic_store(&worker->sleeping, false);
+        bool done = io_atomic_load(&worker->pending) == 0;
+        io_Mutex_unlock(&worker->mtx);
+        if (done) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+IO_INLINE(void)
+io_Worker_wake(io_Worker* worker)
+{
+    io_Mutex_lock(&worker->mtx);
+    io_Cond_signal(&worker->cond);
+    io_Mutex_unlock(&worker->mtx);
+}
+
+IO_INLINE(void)
+io_WorkerPool_stop(io_WorkerPool* pool, size_t num_started)
+{
+    io_atomic_store(&pool->stop, true);
+    for (size_t i = 0; i < num_started; ++i) {
+        io_Worker_wake(&pool->workers[i]);
+    }
+    for (size_t i = 0; i < num_started; ++i) {
+        io_Worker* worker = &pool->workers[i];
+        io_Thread_deinit(&worker->thread);
+        io_Cond_deinit(&worker->cond);
+        io_Mutex_deinit(&worker->mtx);
+    }
+}
+
+IO_INLINE(io_Err)
+io_WorkerPool_init(io_WorkerPool* pool, io_Loop* loop, size_t num_workers, io_Allocator* allocator)
+{
+    IO_REQUIRE(num_workers > 0, "Worker pool needs a worker");
+    pool->allocator = allocator;
+    pool->num_workers = num_workers;
+    pool->next = 0;
+    pool->num_tasks = loop->num_tasks;
+    pool->loop = loop;
+    pool->stop = false;
+    pool->workers = io_alloc(allocator, num_workers * sizeof(io_Worker));
+    if (!pool->workers) {
+        return io_SystemErr(IO_ENOMEM);
+    }
+    io_Err err = IO_ERR_OK;
+    size_t started = 0;
+    for (; started < num_workers; ++started) {
+        io_Worker* worker = &pool->workers[started];
+        io_TaskMpsc_init(&worker->queue);
+        worker->pending = 0;
+        worker->sleeping = false;
+        worker->pool = pool;
+        if ((err = io_Mutex_init(&worker->mtx))) {
+            goto stop_workers;
+        }
+        if ((err = io_Cond_init(&worker->cond))) {
+            io_Mutex_deinit(&worker->mtx);
+            goto stop_workers;
+        }
+        if ((err = io_Thread_init(&worker->thread, io_Worker_run, worker))) {
+            io_Cond_deinit(&worker->cond);
+            io_Mutex_deinit(&worker->mtx);
+            goto stop_workers;
+        }
+    }
+    return IO_ERR_OK;
+stop_workers:
+    io_WorkerPool_stop(pool, started);
+    io_free(allocator, pool->workers);
+    return err;
+}
+
+/** io_WorkerPool_deinit
+ * @brief Runs the tasks that are still queued and joins the workers.
+ */
+IO_INLINE(void)
+io_WorkerPool_deinit(io_WorkerPool* pool)
+{
+    io_WorkerPool_stop(pool, pool->num_workers);
+    io_free(pool->allocator, pool->workers);
+}
+
+/** io_WorkerPool_push
+ * @brief Hands `task` to the next worker, never blocks unless the worker sleeps.
+ */
+IO_INLINE(void)
+io_WorkerPool_push(io_WorkerPool* pool, io_Task* task)
+{
+    io_Worker* worker = &pool->workers[io_atomic_fetch_add_explicit(&pool->next, 1, IO_RELAXED) % pool->num_workers];
+    io_atomic_inc_explicit(pool->num_tasks, IO_RELAXED);
+    io_atomic_inc(&worker->pending);
+    io_TaskMpsc_push(&worker->queue, task);
+    if (io_atomic_load(&worker->sleeping)) {
+        io_Worker_wake(worker);
+    }
+}
+
+#endif
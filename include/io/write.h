@@ -24,6 +24,7 @@ typedef void (*io_WriteCallback)(void* user_data, size_t size, io_Err err);
 
 typedef struct io_WriteOp {
     io_Op base;
+    io_Allocator* allocator;
     io_Descriptor* socket;
     io_WriteCallback callback;
     const void* addr;
@@ -47,7 +48,7 @@ io_perform_write(io_Descriptor* socket, const void* addr, size_t* size)
 IO_INLINE(void)
 io_WriteOp_finalize(io_WriteOp* op)
 {
-    io_Allocator* allocator = io_Descriptor_get_context(op->socket)->allocator;
+    io_Allocator* allocator = op->allocator;
     op->callback(op->user_data, op->size, op->err);
     io_Allocator_free(allocator, op);
 }
@@ -58,7 +59,7 @@ io_WriteOp_complete(io_WriteOp* op, size_t size, io_Err err)
     op->err = err;
     op->size = size;
     io_Op_set_flags(&op->base, IO_OP_COMPLETED);
-    io_Context_post(io_Descriptor_get_context(op->socket), &op->base.base);
+    io_Context_post_completion(io_Descriptor_get_context(op->socket), &op->base.base);
 }
 
 IO_INLINE(void)
@@ -96,10 +97,12 @@ io_WriteOp_abort(void* self, io_Err err)
 IO_INLINE(io_WriteOp*)
 io_WriteOp_create(io_Descriptor* socket, const void* addr, size_t size, io_WriteCallback callback, void* user_data)
 {
-    io_WriteOp* op = io_Allocator_alloc(io_Descriptor_get_context(socket)->allocator, sizeof(io_WriteOp));
+    io_Allocator* allocator = io_Descriptor_allocator(socket);
+    io_WriteOp* op = io_Allocator_alloc(allocator, sizeof(io_WriteOp));
     if (!op)
         return NULL;
     io_Op_init(&op->base, IO_OP_WRITE, io_WriteOp_fn, io_WriteOp_abort);
+    op->allocator = allocator;
     op->socket = socket;
     op->addr = addr;
     op->size = size;
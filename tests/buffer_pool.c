@@ -0,0 +1,72 @@
+#include "test.h"
+
+#include <io/buffer_pool.h>
+
+#include <string.h>
+
+IO_TEST_BEGIN(buffer_pool)
+{
+    IO_TEST_CASE_BEGIN(buffer_pool_acquire_release)
+    {
+        io_BufferPool pool;
+        IO_CHECK(io_BufferPool_init(&pool, test_allocator(), 64, 0) == IO_ERR_OK);
+        io_Buffer* buffer = io_BufferPool_acquire(&pool);
+        IO_CHECK(buffer != NULL);
+        IO_CHECK(io_Buffer_capacity(buffer) == 64);
+        IO_CHECK(io_Buffer_size(buffer) == 0);
+        memset(io_Buffer_data(buffer), 'x', io_Buffer_capacity(buffer));
+        IO_CHECK(io_BufferPool_num_used(&pool) == 1);
+        io_Buffer_release(buffer);
+        IO_CHECK(io_BufferPool_num_used(&pool) == 0);
+        // Released buffers are reused
+        IO_CHECK(io_BufferPool_acquire(&pool) == buffer);
+        io_Buffer_release(buffer);
+        io_BufferPool_deinit(&pool);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(buffer_pool_refcount)
+    {
+        io_BufferPool pool;
+        IO_CHECK(io_BufferPool_init(&pool, test_allocator(), 64, 0) == IO_ERR_OK);
+        io_Buffer* buffer = io_BufferPool_acquire(&pool);
+        io_Buffer_retain(buffer);
+        io_Buffer_release(buffer);
+        IO_CHECK(io_BufferPool_num_used(&pool) == 1);
+        io_Buffer_release(buffer);
+        IO_CHECK(io_BufferPool_num_used(&pool) == 0);
+        io_BufferPool_deinit(&pool);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(buffer_pool_max)
+    {
+        io_BufferPool pool;
+        IO_CHECK(io_BufferPool_init(&pool, test_allocator(), 64, 2) == IO_ERR_OK);
+        io_Buffer* a = io_BufferPool_acquire(&pool);
+        io_Buffer* b = io_BufferPool_acquire(&pool);
+        IO_CHECK(a && b);
+        IO_CHECK(io_BufferPool_acquire(&pool) == NULL);
+        io_Buffer_release(a);
+        a = io_BufferPool_acquire(&pool);
+        IO_CHECK(a != NULL);
+        io_Buffer_release(a);
+        io_Buffer_release(b);
+        io_BufferPool_deinit(&pool);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(buffer_pool_max_idle)
+    {
+        io_BufferPool pool;
+        IO_CHECK(io_BufferPool_init(&pool, test_allocator(), 64, 0) == IO_ERR_OK);
+        io_BufferPool_configure(&pool, 128, 0, 1);
+        io_Buffer* a = io_BufferPool_acquire(&pool);
+        io_Buffer* b = io_BufferPool_acquire(&pool);
+        IO_CHECK(io_Buffer_capacity(a) == 128);
+        io_Buffer_release(a);
+        io_Buffer_release(b);
+        // Only one idle buffer is kept, the other went back to the allocator
+        IO_CHECK(pool.num_idle == 1);
+        io_BufferPool_deinit(&pool);
+    }
+    IO_TEST_CASE_END
+}
+IO_TEST_END
@@ -1,6 +1,337 @@
 #include "test.h"
 
 #include <io/context.h>
+#include <io/descriptor.h>
+#include <io/tcp_acceptor.h>
+
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct post_capture {
+    int* counter;
+    int value;
+} post_capture;
+
+static void
+post_fn(void* capture)
+{
+    post_capture* c = capture;
+    *c->counter += c->value;
+}
+
+typedef struct big_capture {
+    int* counter;
+    char padding[IO_FN_TASK_CAPTURE_SIZE];
+} big_capture;
+
+static void
+post_big_fn(void* capture)
+{
+    big_capture* c = capture;
+    *c->counter += c->padding[IO_FN_TASK_CAPTURE_SIZE - 1];
+}
+
+typedef struct batch_task {
+    io_Task base;
+    io_Context* context;
+    io_Loop* ran_on;
+    int* counter;
+} batch_task;
+
+static void
+batch_task_fn(void* self)
+{
+    batch_task* task = self;
+    task->ran_on = io_Context_this_loop(task->context);
+    io_atomic_inc(task->counter);
+}
+
+typedef struct migrate_result {
+    io_Context* context;
+    io_Descriptor* descriptor;
+    io_Loop* ran_on;
+    io_Err err;
+    int calls;
+} migrate_result;
+
+static void
+migrate_cb(void* user_data, io_Err err)
+{
+    migrate_result* result = user_data;
+    result->ran_on = io_Context_this_loop(result->context);
+    result->err = err;
+    result->calls++;
+    if (err) {
+        // Let the pending wait go, so the run can end
+        io_Descriptor_cancel(result->descriptor);
+    }
+}
+
+static void
+migrate_wait_cb(void* user_data, io_Err err)
+{
+    *(io_Err*)user_data = err;
+}
+
+static int
+poll_stub_idle(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    (void)fds;
+    (void)nfds;
+    (void)timeout;
+    return 0;
+}
+
+static void
+spin_ns(uint64_t ns)
+{
+    uint64_t start = io_monotonic_ns();
+    while (io_monotonic_ns() - start < ns) {
+    }
+}
+
+static void
+sleep_ns(uint64_t ns)
+{
+    struct timespec wait = {.tv_sec = (time_t)(ns / 1000000000u), .tv_nsec = (long)(ns % 1000000000u)};
+    nanosleep(&wait, NULL);
+}
+
+typedef struct spin_task {
+    io_Task base;
+    io_Loop* loop;
+    io_Context* scale; // Scaled after the last spin if set
+    int remaining;
+    int scaled;
+} spin_task;
+
+static void
+spin_task_fn(void* self)
+{
+    spin_task* task = self;
+    spin_ns(IO_LOOP_BUSY_WINDOW_NS / 4);
+    if (--task->remaining > 0) {
+        io_Loop_push_task(task->loop, &task->base);
+    } else if (task->scale) {
+        task->scaled = io_Context_scale(task->scale);
+    }
+}
+
+// Samples the busy ratio while the loop blocks in its reactor
+typedef struct busy_sample_state {
+    io_Loop* loop;
+    io_Context* context; // Scaled once per idle window if set
+    unsigned blocked;
+    unsigned waited;
+    int scaled_on_block;
+    int idle_windows;
+} busy_sample_state;
+
+static busy_sample_state busy_sample;
+
+static int
+poll_stub_block(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    (void)fds;
+    (void)nfds;
+    if (timeout == 0) {
+        return 0;
+    }
+    busy_sample.blocked = io_Loop_busy_ratio(busy_sample.loop);
+    if (busy_sample.context) {
+        busy_sample.scaled_on_block = io_Context_scale(busy_sample.context);
+        // Parks the surplus loop once the blocked loop reads as idle
+        while (busy_sample.idle_windows < 20) {
+            sleep_ns(IO_LOOP_BUSY_WINDOW_NS);
+            ++busy_sample.idle_windows;
+            if (io_Context_scale(busy_sample.context) == -1) {
+                break;
+            }
+        }
+    } else {
+        sleep_ns(IO_LOOP_BUSY_WINDOW_NS * 3 + IO_LOOP_BUSY_WINDOW_NS / 2);
+    }
+    busy_sample.waited = io_Loop_busy_ratio(busy_sample.loop);
+    io_Loop_stop(busy_sample.loop);
+    return 0;
+}
+
+typedef struct grow_task {
+    io_Task base;
+    io_Context* context;
+    batch_task* next;
+    int grown;
+} grow_task;
+
+static void
+grow_task_fn(void* self)
+{
+    grow_task* task = self;
+    task->grown = io_Context_scale(task->context);
+    io_Loop_push_task(io_Context_loop_at(task->context, 1), &task->next->base);
+}
+
+typedef struct worker_wait {
+    pthread_t loop_thread;
+    size_t calls;
+    size_t on_worker;
+} worker_wait;
+
+static void
+worker_wait_cb(void* user_data, io_Err err)
+{
+    worker_wait* wait = user_data;
+    if (!err && !pthread_equal(pthread_self(), wait->loop_thread)) {
+        io_atomic_inc(&wait->on_worker);
+    }
+    io_atomic_inc(&wait->calls);
+}
+
+typedef struct mail_task {
+    io_Task base;
+    io_Context* context;
+    io_Descriptor* keep_alive; // Cancelled once the mail arrived
+    struct mail_task* forward[2];
+    io_Loop* forward_to[2];
+    io_Loop* ran_on;
+} mail_task;
+
+static void
+mail_task_fn(void* self)
+{
+    mail_task* task = self;
+    task->ran_on = io_Context_this_loop(task->context);
+    for (size_t i = 0; i < 2; ++i) {
+        if (task->forward[i]) {
+            io_Loop_send(task->forward_to[i], &task->forward[i]->base);
+        }
+    }
+    io_Descriptor_cancel(task->keep_alive);
+}
+
+typedef struct loop_allocator {
+    io_Allocator base;
+    size_t outstanding;
+} loop_allocator;
+
+static void*
+loop_allocator_alloc(void* self, size_t size)
+{
+    loop_allocator* allocator = self;
+    allocator->outstanding++;
+    return malloc(size);
+}
+
+static void*
+loop_allocator_realloc(void* self, void* ptr, size_t size)
+{
+    loop_allocator* allocator = self;
+    if (!ptr) {
+        allocator->outstanding++;
+    }
+    return realloc(ptr, size);
+}
+
+static void
+loop_allocator_free(void* self, void* ptr)
+{
+    loop_allocator* allocator = self;
+    allocator->outstanding--;
+    free(ptr);
+}
+
+static io_AllocatorMethods loop_allocator_methods = {
+    .alloc = loop_allocator_alloc,
+    .realloc = loop_allocator_realloc,
+    .free = loop_allocator_free,
+};
+
+typedef struct stop_task {
+    io_Task base;
+    io_Context* context;
+} stop_task;
+
+static void
+stop_task_fn(void* self)
+{
+    stop_task* task = self;
+    io_Context_stop(task->context);
+}
+
+static int
+accept4_stub_eagain(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags)
+{
+    (void)sockfd;
+    (void)addr;
+    (void)addrlen;
+    (void)flags;
+    errno = EAGAIN;
+    return -1;
+}
+
+typedef struct drain_result {
+    io_Err err;
+    int calls;
+} drain_result;
+
+static void
+drain_accept_cb(void* user_data, const int* fds, size_t count, io_Err err)
+{
+    (void)fds;
+    (void)count;
+    drain_result* result = user_data;
+    result->err = err;
+    result->calls++;
+}
+
+static void*
+drain_thread_fn(void* context)
+{
+    uint64_t elapsed = 0;
+    (void)io_Context_drain(context, io_Milliseconds(10), &elapsed);
+    return NULL;
+}
+
+static void
+ignore_wait_cb(void* user_data, io_Err err)
+{
+    (void)user_data;
+    (void)err;
+}
+
+#if IO_HAVE_EPOLL
+typedef struct epoll_record {
+    int op;
+    int fd;
+    uint32_t events;
+    size_t calls;
+} epoll_record;
+
+static epoll_record last_epoll_ctl;
+
+static struct itimerspec last_timerfd_spec;
+
+static int
+timerfd_settime_stub_record(int fd, int flags, const struct itimerspec* new_value, struct itimerspec* old_value)
+{
+    (void)fd;
+    (void)old_value;
+    IO_ASSERT(flags == TFD_TIMER_ABSTIME, "Deadlines are absolute");
+    last_timerfd_spec = *new_value;
+    return 0;
+}
+
+static int
+epoll_ctl_stub_record(int epfd, int op, int fd, struct epoll_event* event)
+{
+    (void)epfd;
+    last_epoll_ctl.op = op;
+    last_epoll_ctl.fd = fd;
+    last_epoll_ctl.events = event->events;
+    last_epoll_ctl.calls++;
+    return 0;
+}
+#endif
 
 IO_TEST_BEGIN(context)
 {
@@ -21,5 +352,794 @@ IO_TEST_BEGIN(context)
         io_Context_deinit(&context);
     }
     IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_post_fn)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        int counter = 0;
+        for (int i = 1; i <= 3; ++i) {
+            post_capture capture = {&counter, i};
+            IO_CHECK(io_Context_post_fn(&context, post_fn, &capture, sizeof(capture)) == IO_ERR_OK);
+        }
+        io_Context_run(&context);
+        IO_CHECK(counter == 6);
+        // The slots went back to the loop's pool and are reused
+        io_FnTaskPool* pool = &context.loop->fn_tasks;
+        IO_CHECK(io_FnTaskPool_num_idle(pool) == 3);
+        post_capture capture = {&counter, 4};
+        IO_CHECK(io_Context_post_fn(&context, post_fn, &capture, sizeof(capture)) == IO_ERR_OK);
+        IO_CHECK(io_FnTaskPool_num_idle(pool) == 2);
+        io_Context_run(&context);
+        IO_CHECK(counter == 10);
+        // Oversized captures work too, they just don't use the pool
+        big_capture big = {&counter, {0}};
+        big.padding[IO_FN_TASK_CAPTURE_SIZE - 1] = 5;
+        IO_CHECK(io_Context_post_fn(&context, post_big_fn, &big, sizeof(big)) == IO_ERR_OK);
+        io_Context_run(&context);
+        IO_CHECK(counter == 15);
+        IO_CHECK(io_FnTaskPool_num_idle(pool) == 3);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_post_batch)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        int counter = 0;
+        batch_task tasks[100];
+        io_TaskQueue queue = io_TaskQueue_make();
+        for (size_t i = 0; i < 100; ++i) {
+            tasks[i] = (batch_task){.base.fn = batch_task_fn, .context = &context, .counter = &counter};
+            io_TaskQueue_push(&queue, &tasks[i].base);
+        }
+        io_Context_post_batch(&context, &queue);
+        IO_CHECK(io_TaskQueue_empty(&queue));
+        IO_CHECK(io_Loop_get_task_count(context.loop) == 100);
+        io_Context_run(&context);
+        IO_CHECK(counter == 100);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_post_spread)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 2) == IO_ERR_OK);
+        int counter = 0;
+        batch_task tasks[10];
+        io_TaskQueue queue = io_TaskQueue_make();
+        for (size_t i = 0; i < 10; ++i) {
+            tasks[i] = (batch_task){.base.fn = batch_task_fn, .context = &context, .counter = &counter};
+            io_TaskQueue_push(&queue, &tasks[i].base);
+        }
+        io_Context_post_spread(&context, &queue);
+        IO_CHECK(io_TaskQueue_empty(&queue));
+        io_Context_run(&context);
+        IO_CHECK(counter == 10);
+        // Contiguous runs of 4, 3 and 3 tasks, one per loop
+        IO_CHECK(tasks[0].ran_on == tasks[3].ran_on);
+        IO_CHECK(tasks[4].ran_on == tasks[6].ran_on);
+        IO_CHECK(tasks[7].ran_on == tasks[9].ran_on);
+        IO_CHECK(tasks[0].ran_on != tasks[4].ran_on);
+        IO_CHECK(tasks[4].ran_on != tasks[7].ran_on);
+        IO_CHECK(tasks[0].ran_on != tasks[7].ran_on);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_post_spread_least_handles)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 2) == IO_ERR_OK);
+        // The placement would pick the same empty loop for every run
+        io_Context_set_placement(&context, IO_PLACEMENT_LEAST_HANDLES);
+        int counter = 0;
+        batch_task tasks[3];
+        io_TaskQueue queue = io_TaskQueue_make();
+        for (size_t i = 0; i < 3; ++i) {
+            tasks[i] = (batch_task){.base.fn = batch_task_fn, .context = &context, .counter = &counter};
+            io_TaskQueue_push(&queue, &tasks[i].base);
+        }
+        io_Context_post_spread(&context, &queue);
+        io_Context_run(&context);
+        IO_CHECK(counter == 3);
+        IO_CHECK(tasks[0].ran_on != tasks[1].ran_on);
+        IO_CHECK(tasks[1].ran_on != tasks[2].ran_on);
+        IO_CHECK(tasks[0].ran_on != tasks[2].ran_on);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_placement_least_handles)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 2) == IO_ERR_OK);
+        io_Descriptor descriptors[6];
+        for (int i = 0; i < 6; ++i) {
+            io_Descriptor_init(&descriptors[i], &context);
+        }
+        // Pile three descriptors onto the first loop by hand
+        for (int i = 0; i < 3; ++i) {
+            io_Descriptor_set_fd_on_loop(&descriptors[i], context.loop, 100 + i);
+        }
+        IO_CHECK(io_Context_imbalance(&context) == 300);
+        io_Context_set_placement(&context, IO_PLACEMENT_LEAST_HANDLES);
+        for (int i = 3; i < 6; ++i) {
+            io_Descriptor_set_fd(&descriptors[i], 100 + i);
+            IO_CHECK(io_Descriptor_get_loop(&descriptors[i]) != context.loop);
+        }
+        IO_CHECK(io_Loop_num_handles(context.loop) == 3);
+        IO_CHECK(io_Context_imbalance(&context) == 150);
+        for (int i = 0; i < 6; ++i) {
+            io_Descriptor_close(&descriptors[i]);
+        }
+        IO_CHECK(io_Loop_num_handles(io_Context_loop_at(&context, 1)) == 0);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_placement_round_robin)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 2) == IO_ERR_OK);
+        io_Descriptor descriptors[6];
+        for (int i = 0; i < 6; ++i) {
+            io_Descriptor_init(&descriptors[i], &context);
+            io_Descriptor_set_fd(&descriptors[i], 100 + i);
+        }
+        IO_CHECK(io_Context_imbalance(&context) == 100);
+        for (int i = 0; i < 6; ++i) {
+            io_Descriptor_close(&descriptors[i]);
+        }
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_descriptor_migrate)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 1) == IO_ERR_OK);
+        io_Loop* target = io_Context_loop_at(&context, 1);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd_on_loop(&descriptor, context.loop, 100);
+        migrate_result result = {.context = &context, .descriptor = &descriptor};
+        IO_CHECK(io_Descriptor_migrate(&descriptor, target, migrate_cb, &result) == IO_ERR_OK);
+        io_Context_run(&context);
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == IO_ERR_OK);
+        IO_CHECK(result.ran_on == target);
+        IO_CHECK(io_Descriptor_get_loop(&descriptor) == target);
+        IO_CHECK(io_Descriptor_get_fd(&descriptor) == 100);
+        IO_CHECK(io_Loop_num_handles(context.loop) == 0);
+        IO_CHECK(io_Loop_num_handles(target) == 1);
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_descriptor_migrate_busy)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 1) == IO_ERR_OK);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd_on_loop(&descriptor, context.loop, 100);
+        io_Err wait_err = IO_ERR_OK;
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_READ, migrate_wait_cb, &wait_err) == IO_ERR_OK);
+        migrate_result result = {.context = &context, .descriptor = &descriptor};
+        IO_CHECK(io_Descriptor_migrate(&descriptor, io_Context_loop_at(&context, 1), migrate_cb, &result) == IO_ERR_OK);
+        io_Context_run(&context);
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == io_SystemErr(IO_EBUSY));
+        IO_CHECK(result.ran_on == context.loop);
+        IO_CHECK(wait_err == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(io_Descriptor_get_loop(&descriptor) == context.loop);
+        IO_CHECK(io_Loop_num_handles(context.loop) == 1);
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_thread_options)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_ThreadOptions options[2] = {
+            {.name = "io-loop-1", .stack_size = 256 * 1024},
+            {.sched_policy = IO_SCHED_OTHER},
+        };
+        IO_CHECK(io_Context_set_num_threads_with_options(&context, 2, options) == IO_ERR_OK);
+        // The loops exist before the context runs
+        IO_CHECK(io_Context_num_loops(&context) == 3);
+        for (size_t i = 0; i < 3; ++i) {
+            IO_CHECK((uintptr_t)io_Context_loop_at(&context, i) % IO_CACHE_LINE_SIZE == 0);
+        }
+        int counter = 0;
+        batch_task tasks[3];
+        io_TaskQueue queue = io_TaskQueue_make();
+        for (size_t i = 0; i < 3; ++i) {
+            tasks[i] = (batch_task){.base.fn = batch_task_fn, .context = &context, .counter = &counter};
+            io_TaskQueue_push(&queue, &tasks[i].base);
+        }
+        io_Context_post_spread(&context, &queue);
+        io_Context_run(&context);
+        IO_CHECK(counter == 3);
+        IO_CHECK(tasks[0].ran_on != tasks[1].ran_on);
+        IO_CHECK(tasks[1].ran_on != tasks[2].ran_on);
+        IO_CHECK(tasks[0].ran_on != tasks[2].ran_on);
+        // Later runs start fresh threads with the same options
+        tasks[0].ran_on = NULL;
+        io_Context_post(&context, &tasks[0].base);
+        io_Context_run(&context);
+        IO_CHECK(counter == 4);
+        IO_CHECK(tasks[0].ran_on == context.loop);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_thread_options_no_run)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads_with_options(&context, 2, NULL) == IO_ERR_OK);
+        // The parked threads exit without running their loop
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_elastic_scale)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_ElasticOptions options = {
+            .min_loops = 1,
+            .max_loops = 3,
+            .grow_threshold = 0, // Always grow
+            .shrink_threshold = 0,
+            .patience = 2,
+        };
+        IO_CHECK(io_Context_set_elastic(&context, &options) == IO_ERR_OK);
+        IO_CHECK(io_Context_num_loops(&context) == 1);
+        IO_CHECK(io_Context_scale(&context) == 0);
+        IO_CHECK(io_Context_scale(&context) == 1);
+        IO_CHECK(io_Context_num_loops(&context) == 2);
+        IO_CHECK(io_Context_scale(&context) == 0);
+        IO_CHECK(io_Context_scale(&context) == 1);
+        IO_CHECK(io_Context_num_loops(&context) == 3);
+        IO_CHECK(io_Context_scale(&context) == 0);
+        IO_CHECK(io_Context_scale(&context) == 0);
+        // Now always shrink, the surplus loops are parked
+        context.elastic.grow_threshold = IO_LOOP_BUSY_SCALE + 1;
+        context.elastic.shrink_threshold = IO_LOOP_BUSY_SCALE + 1;
+        context.elastic.patience = 1;
+        IO_CHECK(io_Context_scale(&context) == -1);
+        IO_CHECK(io_Context_scale(&context) == -1);
+        IO_CHECK(io_Context_scale(&context) == 0);
+        IO_CHECK(io_Context_num_loops(&context) == 1);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        IO_CHECK(io_Descriptor_get_loop(&descriptor) == context.loop);
+        io_Descriptor_close(&descriptor);
+        // Growing again reuses a parked loop
+        IO_CHECK(io_Context_grow(&context) == IO_ERR_OK);
+        IO_CHECK(io_Context_num_loops(&context) == 2);
+        IO_CHECK(io_Context_num_thread_loops(&context) == 2);
+        IO_CHECK(io_Context_grow(&context) == IO_ERR_OK);
+        IO_CHECK(io_Context_num_loops(&context) == 3);
+        // All slots are taken
+        IO_CHECK(io_Context_grow(&context) == io_SystemErr(IO_EINVAL));
+        IO_CHECK(io_Context_num_thread_loops(&context) == 2);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_busy_ratio_blocked)
+    {
+        io_mock_system_call.poll = poll_stub_block;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_Loop* loop = context.loop;
+        busy_sample = (busy_sample_state){.loop = loop};
+        // Keeps the loop running once the spinning is over
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_READ, ignore_wait_cb, NULL) == IO_ERR_OK);
+        spin_task spin = {.base.fn = spin_task_fn, .loop = loop, .remaining = 16};
+        io_Loop_push_task(loop, &spin.base);
+        io_Context_run(&context);
+        IO_CHECK(spin.remaining == 0);
+        IO_CHECK(busy_sample.blocked > IO_LOOP_BUSY_SCALE / 4);
+        // Three idle windows went by without the loop waking up
+        IO_CHECK(busy_sample.waited <= busy_sample.blocked * 343 / 512);
+        // Once awake, the loop keeps the idle windows readers saw
+        IO_CHECK(io_Loop_busy_ratio(loop) <= busy_sample.waited);
+        io_Loop_restart(loop);
+        io_mock_system_call.poll = poll_stub_idle;
+        io_Descriptor_cancel(&descriptor);
+        io_Context_run(&context);
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_elastic_scale_idle)
+    {
+        io_mock_system_call.poll = poll_stub_block;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_ElasticOptions options = {
+            .min_loops = 1,
+            .max_loops = 2,
+            .grow_threshold = IO_LOOP_BUSY_SCALE / 4,
+            .shrink_threshold = IO_LOOP_BUSY_SCALE / 8,
+            .patience = 1,
+        };
+        IO_CHECK(io_Context_set_elastic(&context, &options) == IO_ERR_OK);
+        io_Loop* loop = context.loop;
+        busy_sample = (busy_sample_state){.loop = loop, .context = &context};
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_READ, ignore_wait_cb, NULL) == IO_ERR_OK);
+        spin_task spin = {.base.fn = spin_task_fn, .loop = loop, .scale = &context, .remaining = 20};
+        io_Loop_push_task(loop, &spin.base);
+        // Runs on the calling thread only, the added loop stays without a thread
+        io_Context_run_for(&context, IO_TIMEOUT_INFINITE);
+        // The busy loop got company
+        IO_CHECK(spin.scaled == 1);
+        IO_CHECK(io_Context_num_thread_loops(&context) == 1);
+        // Blocking alone doesn't make the average drop
+        IO_CHECK(busy_sample.scaled_on_block == 0);
+        // The loop's wait counted as idle, without waking it up
+        IO_CHECK(busy_sample.idle_windows < 20);
+        // The added loop is parked again
+        IO_CHECK(io_Context_num_loops(&context) == 1);
+        io_Loop_restart(loop);
+        io_mock_system_call.poll = poll_stub_idle;
+        io_Descriptor_cancel(&descriptor);
+        io_Context_poll(&context);
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_elastic_grow_running)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_ElasticOptions options = {.min_loops = 1, .max_loops = 2, .grow_threshold = 0, .patience = 1};
+        IO_CHECK(io_Context_set_elastic(&context, &options) == IO_ERR_OK);
+        int counter = 0;
+        batch_task next = {.base.fn = batch_task_fn, .context = &context, .counter = &counter};
+        grow_task grow = {.base.fn = grow_task_fn, .context = &context, .next = &next};
+        io_Context_post(&context, &grow.base);
+        io_Context_run(&context);
+        IO_CHECK(grow.grown == 1);
+        IO_CHECK(counter == 1);
+        // The new loop got its thread while the context was running
+        IO_CHECK(next.ran_on == io_Context_loop_at(&context, 1));
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_elastic_grow_before_run)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        // Without io_Context_set_elastic there are no slots to grow into
+        IO_CHECK(io_Context_grow(&context) == io_SystemErr(IO_EINVAL));
+        io_ElasticOptions options = {.min_loops = 1, .max_loops = 2, .patience = 1};
+        IO_CHECK(io_Context_set_elastic(&context, &options) == IO_ERR_OK);
+        IO_CHECK(io_Context_grow(&context) == IO_ERR_OK);
+        IO_CHECK(io_Context_grow(&context) == io_SystemErr(IO_EINVAL));
+        int counter = 0;
+        batch_task task = {.base.fn = batch_task_fn, .context = &context, .counter = &counter};
+        io_Loop_push_task(io_Context_loop_at(&context, 1), &task.base);
+        io_Context_run(&context);
+        // The loop added before the run got its thread with the run
+        IO_CHECK(counter == 1);
+        IO_CHECK(task.ran_on == io_Context_loop_at(&context, 1));
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_workers)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init_with_workers(&context, test_allocator(), 2) == IO_ERR_OK);
+        IO_CHECK(!io_Context_completes_inline(&context));
+        worker_wait wait = {.loop_thread = pthread_self()};
+        io_Descriptor descriptors[3];
+        for (int i = 0; i < 3; ++i) {
+            io_Descriptor_init(&descriptors[i], &context);
+            io_Descriptor_set_fd(&descriptors[i], 100 + i);
+            IO_CHECK(io_Descriptor_async_wait(&descriptors[i], IO_OP_READ, worker_wait_cb, &wait) == IO_ERR_OK);
+        }
+        io_Context_run(&context);
+        IO_CHECK(wait.calls == 3);
+        IO_CHECK(wait.on_worker == 3);
+        for (int i = 0; i < 3; ++i) {
+            io_Descriptor_close(&descriptors[i]);
+        }
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_leader_follower)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_Context_set_num_followers(&context, 3);
+        int counter = 0;
+        batch_task tasks[64];
+        for (size_t i = 0; i < 64; ++i) {
+            tasks[i] = (batch_task){.base.fn = batch_task_fn, .context = &context, .counter = &counter};
+            io_Context_post(&context, &tasks[i].base);
+        }
+        worker_wait wait = {.loop_thread = pthread_self()};
+        io_Descriptor descriptors[4];
+        for (int i = 0; i < 4; ++i) {
+            io_Descriptor_init(&descriptors[i], &context);
+            io_Descriptor_set_fd(&descriptors[i], 100 + i);
+            IO_CHECK(io_Descriptor_async_wait(&descriptors[i], IO_OP_READ, worker_wait_cb, &wait) == IO_ERR_OK);
+        }
+        io_Context_run(&context);
+        IO_CHECK(counter == 64);
+        IO_CHECK(wait.calls == 4);
+        // All threads share the one loop
+        for (size_t i = 0; i < 64; ++i) {
+            IO_CHECK(tasks[i].ran_on == context.loop);
+        }
+        for (int i = 0; i < 4; ++i) {
+            io_Descriptor_close(&descriptors[i]);
+        }
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_shared_nothing)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        loop_allocator allocators[3];
+        io_Allocator* loop_allocators[3];
+        for (size_t i = 0; i < 3; ++i) {
+            allocators[i] = (loop_allocator){.base.methods = &loop_allocator_methods};
+            loop_allocators[i] = &allocators[i].base;
+        }
+        IO_CHECK(io_Context_set_shared_nothing(&context, 2, NULL, loop_allocators) == IO_ERR_OK);
+        io_Loop* loops[3];
+        io_Descriptor descriptors[3];
+        mail_task mail[3];
+        for (size_t i = 0; i < 3; ++i) {
+            loops[i] = io_Context_loop_at(&context, i);
+            IO_CHECK(loops[i]->sibling == NULL);
+            // Every loop is confined to its thread and allocates on its own
+            IO_CHECK(loops[i]->shared_nothing && loops[i]->mutex.elided);
+            IO_CHECK(((io_Poll*)loops[i]->reactor)->single_threaded);
+            IO_CHECK(io_Loop_allocator(loops[i]) == loop_allocators[i]);
+            IO_CHECK(allocators[i].outstanding > 0);
+            io_Descriptor_init(&descriptors[i], &context);
+            io_Descriptor_set_fd_on_loop(&descriptors[i], loops[i], 100 + (int)i);
+            size_t outstanding = allocators[i].outstanding;
+            // Keeps the loop running until its mail arrived
+            IO_CHECK(io_Descriptor_async_wait(&descriptors[i], IO_OP_READ, ignore_wait_cb, NULL) == IO_ERR_OK);
+            // The op comes from the loop's allocator, not the shared one
+            IO_CHECK(allocators[i].outstanding == outstanding + 1);
+            mail[i] = (mail_task){.base.fn = mail_task_fn, .context = &context, .keep_alive = &descriptors[i]};
+        }
+        // Thread loops count their own tasks
+        IO_CHECK(io_Loop_get_task_count(loops[1]) == 1);
+        IO_CHECK(io_Loop_get_task_count(loops[2]) == 1);
+        // New descriptors stay on the creating thread's loop
+        IO_CHECK(io_Context_next_loop(&context) == context.loop);
+        // Loop 1 gets the first mail and forwards to loops 0 and 2
+        mail[1].forward[0] = &mail[0];
+        mail[1].forward_to[0] = loops[0];
+        mail[1].forward[1] = &mail[2];
+        mail[1].forward_to[1] = loops[2];
+        io_Loop_send(loops[1], &mail[1].base);
+        io_Context_run(&context);
+        io_ThreadVec_clear(&context.threads);
+        for (size_t i = 0; i < 3; ++i) {
+            IO_CHECK(mail[i].ran_on == loops[i]);
+            io_Descriptor_close(&descriptors[i]);
+        }
+        io_Context_deinit(&context);
+        for (size_t i = 0; i < 3; ++i) {
+            IO_CHECK(allocators[i].outstanding == 0);
+        }
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_shared_nothing_drain)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_mock_system_call.accept4 = accept4_stub_eagain;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_shared_nothing(&context, 0, NULL, NULL) == IO_ERR_OK);
+        IO_CHECK(context.loop->shared_nothing);
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &context, "0.0.0.0:8080") == IO_ERR_OK);
+        drain_result accepts = {0};
+        IO_CHECK(io_TcpAcceptor_async_accept_multishot(&acceptor, 2, drain_accept_cb, &accepts) == IO_ERR_OK);
+        io_Descriptor connection;
+        io_Descriptor_init(&connection, &context);
+        io_Descriptor_set_fd(&connection, 200);
+        io_Err wait_err = IO_ERR_OK;
+        IO_CHECK(io_Descriptor_async_wait(&connection, IO_OP_READ, migrate_wait_cb, &wait_err) == IO_ERR_OK);
+        uint64_t elapsed = 0;
+        IO_CHECK(io_Context_drain(&context, io_Milliseconds(20), &elapsed) == IO_ERR_OK);
+        // The loop cancelled its accepts itself
+        IO_CHECK(accepts.calls == 1);
+        IO_CHECK(accepts.err == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(wait_err == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(elapsed >= 20u * 1000u * 1000u);
+        IO_CHECK(io_Loop_get_task_count(context.loop) == 0);
+        io_Context_restart(&context);
+        IO_CHECK(!context.loop->drain_begun);
+        io_Descriptor_close(&connection);
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_run_one_and_poll)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        int counter = 0;
+        for (int i = 1; i <= 3; ++i) {
+            post_capture capture = {&counter, i};
+            IO_CHECK(io_Context_post_fn(&context, post_fn, &capture, sizeof(capture)) == IO_ERR_OK);
+        }
+        IO_CHECK(io_Context_run_one(&context) == 1);
+        IO_CHECK(counter == 1);
+        IO_CHECK(io_Context_poll(&context) == 2);
+        IO_CHECK(counter == 6);
+        // Out of tasks, neither blocks
+        IO_CHECK(io_Context_run_one(&context) == 0);
+        IO_CHECK(io_Context_poll(&context) == 0);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_run_for)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_READ, ignore_wait_cb, NULL) == IO_ERR_OK);
+        int counter = 0;
+        post_capture capture = {&counter, 1};
+        IO_CHECK(io_Context_post_fn(&context, post_fn, &capture, sizeof(capture)) == IO_ERR_OK);
+        uint64_t start = io_monotonic_ns();
+        // The pending wait keeps the context busy until the time is up
+        IO_CHECK(io_Context_run_for(&context, io_Milliseconds(20)) == 1);
+        IO_CHECK(io_monotonic_ns() - start >= 20u * 1000u * 1000u);
+        IO_CHECK(counter == 1);
+        IO_CHECK(io_Loop_get_task_count(context.loop) == 1);
+        io_Descriptor_cancel(&descriptor);
+        IO_CHECK(io_Context_run_for(&context, io_Seconds(10)) == 1);
+        IO_CHECK(io_Loop_get_task_count(context.loop) == 0);
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_timeout_without_events)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        io_Descriptor_set_timeout(&descriptor, IO_OP_READ, io_Seconds(0));
+        io_Err wait_err = IO_ERR_OK;
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_READ, migrate_wait_cb, &wait_err) == IO_ERR_OK);
+        // The reactor times out with no fd ready, the op still expires
+        IO_CHECK(io_Context_run_for(&context, io_Seconds(10)) == 1);
+        IO_CHECK(wait_err == io_SystemErr(IO_ETIMEDOUT));
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+#if IO_HAVE_EPOLL
+    IO_TEST_CASE_BEGIN(context_wait_fd)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_mock_system_call.epoll_ctl = epoll_ctl_stub_record;
+        last_epoll_ctl = (epoll_record){0};
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        // Armed before the wait fd exists
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_READ, ignore_wait_cb, NULL) == IO_ERR_OK);
+        IO_CHECK(io_Context_get_wait_fd(&context) == 2);
+        // The interrupt pipe, the timerfd and the armed fd
+        IO_CHECK(last_epoll_ctl.calls == 3);
+        IO_CHECK(last_epoll_ctl.op == EPOLL_CTL_ADD && last_epoll_ctl.fd == 100);
+        IO_CHECK(last_epoll_ctl.events == EPOLLIN);
+        IO_CHECK(io_Context_get_wait_fd(&context) == 2);
+        IO_CHECK(last_epoll_ctl.calls == 3);
+        // The fd leaves the wait set when the wait ends
+        io_Descriptor_cancel(&descriptor);
+        IO_CHECK(last_epoll_ctl.op == EPOLL_CTL_DEL && last_epoll_ctl.fd == 100);
+        IO_CHECK(io_Context_poll(&context) == 1);
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_WRITE, ignore_wait_cb, NULL) == IO_ERR_OK);
+        IO_CHECK(last_epoll_ctl.op == EPOLL_CTL_ADD && last_epoll_ctl.events == EPOLLOUT);
+        io_Descriptor_cancel(&descriptor);
+        IO_CHECK(last_epoll_ctl.op == EPOLL_CTL_DEL);
+        IO_CHECK(io_Context_poll(&context) == 1);
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_wait_fd_deadlines)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_mock_system_call.timerfd_settime = timerfd_settime_stub_record;
+        last_timerfd_spec = (struct itimerspec){0};
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_get_wait_fd(&context) == 2);
+        IO_CHECK(last_timerfd_spec.it_value.tv_sec == 0);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        io_Descriptor_set_timeout(&descriptor, IO_OP_READ, io_Seconds(5));
+        uint64_t now = io_monotonic_ns();
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_READ, ignore_wait_cb, NULL) == IO_ERR_OK);
+        // The timerfd fires when the wait times out
+        time_t expire = last_timerfd_spec.it_value.tv_sec;
+        IO_CHECK(expire >= (time_t)(now / 1000000000u) + 5 && expire <= (time_t)(now / 1000000000u) + 6);
+        IO_CHECK(io_Context_poll(&context) == 0);
+        IO_CHECK(last_timerfd_spec.it_value.tv_sec == expire);
+        // An earlier drain deadline takes over
+        uint64_t deadline = io_monotonic_ns() + 1000000000u;
+        io_Loop_drain(context.loop, deadline);
+        IO_CHECK(io_Context_poll(&context) == 0);
+        IO_CHECK(last_timerfd_spec.it_value.tv_sec == (time_t)(deadline / 1000000000u));
+        IO_CHECK(last_timerfd_spec.it_value.tv_nsec == (long)(deadline % 1000000000u));
+        io_Loop_restart(context.loop);
+        io_Descriptor_cancel(&descriptor);
+        IO_CHECK(io_Context_poll(&context) == 1);
+        // Nothing left to wake up for
+        IO_CHECK(last_timerfd_spec.it_value.tv_sec == 0 && last_timerfd_spec.it_value.tv_nsec == 0);
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+#endif
+    IO_TEST_CASE_BEGIN(context_stop)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 1) == IO_ERR_OK);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        io_Err wait_err = IO_ERR_OK;
+        IO_CHECK(io_Descriptor_async_wait(&descriptor, IO_OP_READ, migrate_wait_cb, &wait_err) == IO_ERR_OK);
+        stop_task task = {.base.fn = stop_task_fn, .context = &context};
+        io_Context_post(&context, &task.base);
+        // Without the stop, the pending wait would keep the context running
+        IO_CHECK(io_Context_run(&context) == IO_ERR_OK);
+        IO_CHECK(io_Loop_stopped(context.loop));
+        IO_CHECK(io_Loop_stopped(io_Context_loop_at(&context, 1)));
+        IO_CHECK(io_Loop_get_task_count(context.loop) == 1);
+        IO_CHECK(wait_err == IO_ERR_OK);
+        // A stopped context doesn't run until it's restarted
+        IO_CHECK(io_Context_run(&context) == IO_ERR_OK);
+        io_Context_restart(&context);
+        IO_CHECK(!io_Loop_stopped(context.loop));
+        io_Descriptor_cancel(&descriptor);
+        IO_CHECK(io_Context_run(&context) == IO_ERR_OK);
+        IO_CHECK(wait_err == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(io_Loop_get_task_count(context.loop) == 0);
+        io_Descriptor_close(&descriptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_drain)
+    {
+        io_mock_system_call.poll = poll_stub_idle;
+        io_mock_system_call.accept4 = accept4_stub_eagain;
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &context, "0.0.0.0:8080") == IO_ERR_OK);
+        drain_result accepts = {0};
+        IO_CHECK(io_TcpAcceptor_async_accept_multishot(&acceptor, 2, drain_accept_cb, &accepts) == IO_ERR_OK);
+        // An idle keep-alive connection
+        io_Descriptor connection;
+        io_Descriptor_init(&connection, &context);
+        io_Descriptor_set_fd(&connection, 200);
+        io_Err wait_err = IO_ERR_OK;
+        IO_CHECK(io_Descriptor_async_wait(&connection, IO_OP_READ, migrate_wait_cb, &wait_err) == IO_ERR_OK);
+        uint64_t elapsed = 0;
+        IO_CHECK(io_Context_drain(&context, io_Milliseconds(20), &elapsed) == IO_ERR_OK);
+        IO_CHECK(accepts.calls == 1);
+        IO_CHECK(accepts.err == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(wait_err == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(elapsed >= 20u * 1000u * 1000u);
+        IO_CHECK(elapsed < 10u * 1000u * 1000u * 1000u);
+        IO_CHECK(io_Loop_get_task_count(context.loop) == 0);
+        // No new accepts until the context restarts
+        IO_CHECK(io_TcpAcceptor_async_accept_multishot(&acceptor, 2, drain_accept_cb, &accepts) == io_SystemErr(IO_ECANCELED));
+        io_Context_restart(&context);
+        IO_CHECK(!io_Context_draining(&context));
+        IO_CHECK(io_Loop_drain_deadline(context.loop) == 0);
+        // Drained from another thread while running
+        wait_err = IO_ERR_OK;
+        IO_CHECK(io_Descriptor_async_wait(&connection, IO_OP_READ, migrate_wait_cb, &wait_err) == IO_ERR_OK);
+        pthread_t drainer;
+        IO_CHECK(pthread_create(&drainer, NULL, drain_thread_fn, &context) == 0);
+        IO_CHECK(io_Context_run(&context) == IO_ERR_OK);
+        pthread_join(drainer, NULL);
+        IO_CHECK(wait_err == io_SystemErr(IO_ECANCELED));
+        io_Context_restart(&context);
+        io_Descriptor_close(&connection);
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&context);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_accept_batch_closed)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &context, "0.0.0.0:8080") == IO_ERR_OK);
+        io_TcpAcceptor_deinit(&acceptor);
+        drain_result accepts = {0};
+        // The op is freed, the callback isn't called
+        IO_CHECK(io_TcpAcceptor_async_accept_batch(&acceptor, 2, drain_accept_cb, &accepts) == io_SystemErr(IO_EBADF));
+        IO_CHECK(accepts.calls == 0);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(context_single_threaded)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init_single_threaded(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 1) == io_SystemErr(IO_ENOTSUP));
+        IO_CHECK(io_Context_num_loops(&context) == 1);
+        io_Loop* loop = context.loop;
+        IO_CHECK(loop->single_threaded);
+        IO_CHECK(loop->mutex.elided);
+        io_Poll* poll = (io_Poll*)loop->reactor;
+        IO_CHECK(poll->single_threaded);
+        IO_CHECK(poll->fds.mtx.elided && poll->handles.mtx.elided && poll->timer.mtx.elided);
+        io_Descriptor descriptor;
+        io_Descriptor_init(&descriptor, &context);
+        io_Descriptor_set_fd(&descriptor, 100);
+        IO_CHECK(((io_PollHandle*)descriptor.handle)->mtx.elided);
+        IO_CHECK(io_Loop_num_handles(loop) == 1);
+        int counter = 0;
+        for (int i = 1; i <= 3; ++i) {
+            post_capture capture = {&counter, i};
+            IO_CHECK(io_Context_post_fn(&context, post_fn, &capture, sizeof(capture)) == IO_ERR_OK);
+        }
+        batch_task task = {.base.fn = batch_task_fn, .context = &context, .counter = &counter};
+        io_Loop_send(loop, &task.base);
+        IO_CHECK(io_Loop_get_task_count(loop) == 4);
+        io_Context_run(&context);
+        IO_CHECK(counter == 7);
+        IO_CHECK(task.ran_on == loop);
+        io_Descriptor_close(&descriptor);
+        IO_CHECK(io_Loop_num_handles(loop) == 0);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
 }
 IO_TEST_END
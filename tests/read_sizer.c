@@ -0,0 +1,70 @@
+#include "test.h"
+
+#include <io/read_sizer.h>
+
+static int fionread_pending = 0;
+
+static int
+ioctl_stub_fionread(int fd, unsigned long request, void* arg)
+{
+    (void)fd;
+    if (request != FIONREAD) {
+        errno = EINVAL;
+        return -1;
+    }
+    *(int*)arg = fionread_pending;
+    return 0;
+}
+
+IO_TEST_BEGIN(read_sizer)
+{
+    IO_TEST_CASE_BEGIN(read_sizer_grow)
+    {
+        io_ReadSizer sizer;
+        io_ReadSizer_init(&sizer, 64, 1024, 4096, false);
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 1024);
+        io_ReadSizer_record(&sizer, 1024, 1024);
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 2048);
+        io_ReadSizer_record(&sizer, 2048, 2048);
+        io_ReadSizer_record(&sizer, 4096, 4096);
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 4096);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(read_sizer_shrink)
+    {
+        io_ReadSizer sizer;
+        io_ReadSizer_init(&sizer, 64, 1024, 4096, false);
+        // A single small read doesn't shrink
+        io_ReadSizer_record(&sizer, 1024, 100);
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 1024);
+        io_ReadSizer_record(&sizer, 1024, 100);
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 512);
+        // A read in between resets the pending shrink
+        io_ReadSizer_record(&sizer, 512, 10);
+        io_ReadSizer_record(&sizer, 512, 400);
+        io_ReadSizer_record(&sizer, 512, 10);
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 512);
+        for (int i = 0; i < 32; ++i) {
+            io_ReadSizer_record(&sizer, io_ReadSizer_next(&sizer, 3), 1);
+        }
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 64);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(read_sizer_fionread)
+    {
+        io_ReadSizer sizer;
+        io_ReadSizer_init(&sizer, 64, 1024, 16384, true);
+        io_mock_system_call.ioctl = ioctl_stub_fionread;
+        fionread_pending = 5000;
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 8192);
+        fionread_pending = 100000;
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 16384);
+        fionread_pending = 10;
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 1024);
+        // FIONREAD failing falls back to the tracked size
+        io_mock_system_call.ioctl = ioctl_stub_einval;
+        IO_CHECK(io_ReadSizer_next(&sizer, 3) == 1024);
+    }
+    IO_TEST_CASE_END
+}
+IO_TEST_END
@@ -0,0 +1,210 @@
+#include "test.h"
+
+#include <io/context.h>
+#include <io/resolver.h>
+
+#include <string.h>
+
+static int dns_queries = 0;
+
+/* Stand-in for the name server, serves a single zone entry */
+static int
+dns_server_stub(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+    (void)hints;
+    io_atomic_inc(&dns_queries);
+    if (strcmp(node, "db.internal") != 0) {
+        return EAI_NONAME;
+    }
+    *res = make_stub_addrinfo("10.0.0.7", service);
+    return *res ? 0 : EAI_MEMORY;
+}
+
+static io_Resolver* stalled_resolver = NULL;
+
+/* Answers only once the resolver is being torn down */
+static int
+dns_server_stub_stalled(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+    while (!io_atomic_load(&stalled_resolver->stopping)) {
+    }
+    return dns_server_stub(node, service, hints, res);
+}
+
+typedef struct resolve_result {
+    io_Err err;
+    in_port_t port;
+    size_t count;
+    int calls;
+} resolve_result;
+
+static void
+resolve_callback(void* user, const io_ResolverResult* result, io_Err err)
+{
+    resolve_result* out = user;
+    out->err = err;
+    out->calls++;
+    if (result) {
+        out->count = result->count;
+        out->port = ((const struct sockaddr_in*)&result->endpoints[0].addr)->sin_port;
+    }
+}
+
+IO_TEST_BEGIN(resolver)
+{
+    IO_TEST_CASE_BEGIN(resolver_resolve)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = dns_server_stub;
+        dns_queries = 0;
+        io_ResolverResult result;
+        IO_CHECK(io_Resolver_resolve(io_Context_resolver(&ctx), "db.internal", "5432", &result) == IO_ERR_OK);
+        IO_CHECK(result.count == 1);
+        const struct sockaddr_in* addr = (const struct sockaddr_in*)&result.endpoints[0].addr;
+        IO_CHECK(addr->sin_family == AF_INET);
+        IO_CHECK(addr->sin_port == htons(5432));
+        IO_CHECK(addr->sin_addr.s_addr == inet_addr("10.0.0.7"));
+        IO_CHECK(dns_queries == 1);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(resolver_cache_hit)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = dns_server_stub;
+        dns_queries = 0;
+        io_ResolverResult result;
+        IO_CHECK(io_Resolver_resolve(io_Context_resolver(&ctx), "db.internal", "5432", &result) == IO_ERR_OK);
+        IO_CHECK(io_Resolver_resolve(io_Context_resolver(&ctx), "db.internal", "5432", &result) == IO_ERR_OK);
+        IO_CHECK(dns_queries == 1);
+        IO_CHECK(io_Resolver_resolve(io_Context_resolver(&ctx), "db.internal", "6432", &result) == IO_ERR_OK);
+        IO_CHECK(dns_queries == 2);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(resolver_cache_expired)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = dns_server_stub;
+        dns_queries = 0;
+        io_Resolver_set_ttl(io_Context_resolver(&ctx), io_Seconds(0));
+        io_ResolverResult result;
+        IO_CHECK(io_Resolver_resolve(io_Context_resolver(&ctx), "db.internal", "5432", &result) == IO_ERR_OK);
+        IO_CHECK(io_Resolver_resolve(io_Context_resolver(&ctx), "db.internal", "5432", &result) == IO_ERR_OK);
+        IO_CHECK(dns_queries == 2);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(resolver_unknown_host)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = dns_server_stub;
+        io_ResolverResult result;
+        IO_CHECK(io_Resolver_resolve(io_Context_resolver(&ctx), "nope.internal", "5432", &result) == io_GaiErr(EAI_NONAME));
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(resolver_async_resolve)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = dns_server_stub;
+        dns_queries = 0;
+        resolve_result result = {0};
+        IO_CHECK(io_Resolver_async_resolve(io_Context_resolver(&ctx), io_Context_this_loop(&ctx),
+                                           "db.internal", "5432", resolve_callback, &result)
+                 == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == IO_ERR_OK);
+        IO_CHECK(result.count == 1);
+        IO_CHECK(result.port == htons(5432));
+        // The second lookup is served from the cache
+        IO_CHECK(io_Resolver_async_resolve(io_Context_resolver(&ctx), io_Context_this_loop(&ctx),
+                                           "db.internal", "5432", resolve_callback, &result)
+                 == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.calls == 2);
+        IO_CHECK(dns_queries == 1);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(resolver_async_resolve_fail)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = dns_server_stub;
+        resolve_result result = {0};
+        IO_CHECK(io_Resolver_async_resolve(io_Context_resolver(&ctx), io_Context_this_loop(&ctx),
+                                           "nope.internal", "5432", resolve_callback, &result)
+                 == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == io_GaiErr(EAI_NONAME));
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(resolver_async_resolve_deinit)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        stalled_resolver = io_Context_resolver(&ctx);
+        io_Resolver_set_max_workers(stalled_resolver, 1);
+        io_mock_system_call.getaddrinfo = dns_server_stub_stalled;
+        resolve_result result = {0};
+        // One lookup occupies the worker, the other one stays queued
+        IO_CHECK(io_Resolver_async_resolve(stalled_resolver, io_Context_this_loop(&ctx),
+                                           "db.internal", "5432", resolve_callback, &result)
+                 == IO_ERR_OK);
+        IO_CHECK(io_Resolver_async_resolve(stalled_resolver, io_Context_this_loop(&ctx),
+                                           "db.internal", "6432", resolve_callback, &result)
+                 == IO_ERR_OK);
+        io_Context_deinit(&ctx);
+        IO_CHECK(result.calls == 2);
+        IO_CHECK(result.err == io_SystemErr(IO_ECANCELED));
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(resolver_async_resolve_shared_nothing)
+    {
+        io_Context ctx;
+        IO_CHECK(io_Context_init(&ctx, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_shared_nothing(&ctx, 0, NULL, NULL) == IO_ERR_OK);
+        io_mock_system_call.getaddrinfo = dns_server_stub;
+        dns_queries = 0;
+        resolve_result result = {0};
+        // The worker mails the result to the loop
+        IO_CHECK(io_Resolver_async_resolve(io_Context_resolver(&ctx), io_Context_this_loop(&ctx),
+                                           "db.internal", "5432", resolve_callback, &result)
+                 == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == IO_ERR_OK);
+        IO_CHECK(dns_queries == 1);
+        IO_CHECK(io_Loop_get_task_count(io_Context_this_loop(&ctx)) == 0);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(resolver_async_resolve_single_threaded)
+    {
+        io_Context ctx;
+        IO_CHECK(io_Context_init_single_threaded(&ctx, test_allocator()) == IO_ERR_OK);
+        io_mock_system_call.getaddrinfo = dns_server_stub;
+        dns_queries = 0;
+        resolve_result result = {0};
+        // Workers must not push to a loop without locks
+        IO_CHECK(io_Resolver_async_resolve(io_Context_resolver(&ctx), io_Context_this_loop(&ctx),
+                                           "db.internal", "5432", resolve_callback, &result)
+                 == io_SystemErr(IO_ENOTSUP));
+        IO_CHECK(io_Loop_get_task_count(io_Context_this_loop(&ctx)) == 0);
+        io_Context_run(&ctx);
+        IO_CHECK(result.calls == 0);
+        IO_CHECK(dns_queries == 0);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+}
+IO_TEST_END
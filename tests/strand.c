@@ -0,0 +1,125 @@
+#include "test.h"
+
+#include <io/strand.h>
+
+typedef struct order_task {
+    io_Task base;
+    int index;
+    int* log;
+    int* count;
+} order_task;
+
+static void
+order_task_fn(void* self)
+{
+    order_task* task = self;
+    task->log[(*task->count)++] = task->index;
+}
+
+typedef struct shared_state {
+    io_Strand* strand;
+    int in_flight;
+    int overlaps;
+    int counter;
+} shared_state;
+
+static void
+guarded_fn(void* capture)
+{
+    shared_state* state = *(shared_state**)capture;
+    if (io_atomic_inc(&state->in_flight) != 1) {
+        io_atomic_inc(&state->overlaps);
+    }
+    state->counter++; // Not atomic, the strand serializes the tasks
+    io_atomic_dec(&state->in_flight);
+}
+
+typedef struct spawner {
+    io_Task base;
+    shared_state* state;
+} spawner;
+
+static void
+spawner_fn(void* self)
+{
+    spawner* task = self;
+    for (int i = 0; i < 200; ++i) {
+        io_Strand_post_fn(task->state->strand, guarded_fn, &task->state, sizeof(task->state));
+    }
+}
+
+IO_TEST_BEGIN(strand)
+{
+    IO_TEST_CASE_BEGIN(strand_fifo)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_Strand strand;
+        io_Strand_init(&strand, &context);
+        int log[100];
+        int count = 0;
+        order_task tasks[100];
+        for (int i = 0; i < 100; ++i) {
+            tasks[i] = (order_task){.base.fn = order_task_fn, .index = i, .log = log, .count = &count};
+            io_Strand_post(&strand, &tasks[i].base);
+        }
+        // Nothing runs before the loop does
+        IO_CHECK(count == 0);
+        io_Context_run(&context);
+        IO_CHECK(count == 100);
+        for (int i = 0; i < 100; ++i) {
+            IO_CHECK(log[i] == i);
+        }
+        io_Strand_deinit(&strand);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(strand_dispatch)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        io_Strand strand;
+        io_Strand_init(&strand, &context);
+        int log[3];
+        int count = 0;
+        order_task first = {.base.fn = order_task_fn, .index = 0, .log = log, .count = &count};
+        order_task second = {.base.fn = order_task_fn, .index = 1, .log = log, .count = &count};
+        order_task third = {.base.fn = order_task_fn, .index = 2, .log = log, .count = &count};
+        // Idle strand, runs inline
+        io_Strand_dispatch(&strand, &first.base);
+        IO_CHECK(count == 1);
+        // Busy strand, queued behind the pending task
+        io_Strand_post(&strand, &second.base);
+        io_Strand_dispatch(&strand, &third.base);
+        IO_CHECK(count == 1);
+        io_Context_run(&context);
+        IO_CHECK(count == 3);
+        IO_CHECK(log[1] == 1 && log[2] == 2);
+        io_Strand_deinit(&strand);
+        io_Context_deinit(&context);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(strand_threads)
+    {
+        io_Context context;
+        IO_CHECK(io_Context_init(&context, test_allocator()) == IO_ERR_OK);
+        IO_CHECK(io_Context_set_num_threads(&context, 2) == IO_ERR_OK);
+        io_Strand strand;
+        io_Strand_init(&strand, &context);
+        shared_state state = {.strand = &strand};
+        spawner spawners[3];
+        io_TaskQueue queue = io_TaskQueue_make();
+        for (size_t i = 0; i < 3; ++i) {
+            spawners[i] = (spawner){.base.fn = spawner_fn, .state = &state};
+            io_TaskQueue_push(&queue, &spawners[i].base);
+        }
+        io_Context_post_spread(&context, &queue);
+        io_Context_run(&context);
+        io_Context_deinit(&context);
+        IO_CHECK(state.counter == 600);
+        IO_CHECK(state.overlaps == 0);
+        io_Strand_deinit(&strand);
+    }
+    IO_TEST_CASE_END
+}
+IO_TEST_END
@@ -1,12 +1,17 @@
 #ifndef IO_SYSCALL_STUBS_H
 #define IO_SYSCALL_STUBS_H
 
+#include <arpa/inet.h>
 #include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
 #include <poll.h>
+#include <stdlib.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
 #include <io/atomic.h>
+#include <io/system_call.h>
 
 extern int stub_socket_num;
 
@@ -92,6 +97,72 @@ accept_stub_success(int sockfd, struct sockaddr* addr, socklen_t* addrlen)
     return io_atomic_fetch_add(&stub_socket_num, 1);
 }
 
+static inline int
+accept4_stub_success(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags)
+{
+    (void)sockfd;
+    (void)addr;
+    (void)addrlen;
+    (void)flags;
+    return io_atomic_fetch_add(&stub_socket_num, 1);
+}
+
+static inline int
+setsockopt_stub_success(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+    (void)sockfd;
+    (void)level;
+    (void)optname;
+    (void)optval;
+    (void)optlen;
+    return 0;
+}
+
+/* Reports every int option, SO_ERROR included, as 0 */
+static inline int
+getsockopt_stub_success(int sockfd, int level, int optname, void* optval, socklen_t* optlen)
+{
+    (void)sockfd;
+    (void)level;
+    (void)optname;
+    *(int*)optval = 0;
+    *optlen = sizeof(int);
+    return 0;
+}
+
+static inline int
+setsockopt_stub_enoprotoopt(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+    (void)sockfd;
+    (void)level;
+    (void)optname;
+    (void)optval;
+    (void)optlen;
+    errno = ENOPROTOOPT;
+    return -1;
+}
+
+static inline ssize_t
+sendto_stub_success(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen)
+{
+    (void)sockfd;
+    (void)buf;
+    (void)flags;
+    (void)dest_addr;
+    (void)addrlen;
+    return (ssize_t)len;
+}
+
+static inline int
+ioctl_stub_einval(int fd, unsigned long request, void* arg)
+{
+    (void)fd;
+    (void)request;
+    (void)arg;
+    errno = EINVAL;
+    return -1;
+}
+
 static inline int
 poll_stub_success(struct pollfd* fds, nfds_t nfds, int timeout)
 {
@@ -173,4 +244,95 @@ close_stub_success(int fd)
     return 0;
 }
 
+#if IO_HAVE_EPOLL
+static inline int
+epoll_create1_stub_success(int flags)
+{
+    (void)flags;
+    return 2;
+}
+
+static inline int
+epoll_ctl_stub_success(int epfd, int op, int fd, struct epoll_event* event)
+{
+    (void)epfd;
+    (void)op;
+    (void)fd;
+    (void)event;
+    return 0;
+}
+
+static inline int
+timerfd_create_stub_success(int clockid, int flags)
+{
+    (void)clockid;
+    (void)flags;
+    return 3;
+}
+
+static inline int
+timerfd_settime_stub_success(int fd, int flags, const struct itimerspec* new_value, struct itimerspec* old_value)
+{
+    (void)fd;
+    (void)flags;
+    (void)new_value;
+    (void)old_value;
+    return 0;
+}
+#endif
+
+typedef struct stub_addrinfo {
+    struct addrinfo info;
+    struct sockaddr_in addr;
+} stub_addrinfo;
+
+/** make_stub_addrinfo
+ * @brief Allocate a single IPv4 result, to be released with freeaddrinfo_stub.
+ */
+static inline struct addrinfo*
+make_stub_addrinfo(const char* ip, const char* service)
+{
+    stub_addrinfo* block = calloc(1, sizeof(stub_addrinfo));
+    if (!block)
+        return NULL;
+    block->addr.sin_family = AF_INET;
+    block->addr.sin_port = htons((uint16_t)atoi(service ? service : "0"));
+    inet_pton(AF_INET, ip, &block->addr.sin_addr);
+    block->info.ai_family = AF_INET;
+    block->info.ai_socktype = SOCK_STREAM;
+    block->info.ai_protocol = IPPROTO_TCP;
+    block->info.ai_addr = (struct sockaddr*)&block->addr;
+    block->info.ai_addrlen = sizeof(block->addr);
+    return &block->info;
+}
+
+static inline int
+getaddrinfo_stub_success(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+    (void)node;
+    (void)hints;
+    *res = make_stub_addrinfo("127.0.0.1", service);
+    return *res ? 0 : EAI_MEMORY;
+}
+
+static inline int
+getaddrinfo_stub_noname(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+    (void)node;
+    (void)service;
+    (void)hints;
+    (void)res;
+    return EAI_NONAME;
+}
+
+static inline void
+freeaddrinfo_stub(struct addrinfo* res)
+{
+    while (res) {
+        struct addrinfo* next = res->ai_next;
+        free(res);
+        res = next;
+    }
+}
+
 #endif
@@ -2,6 +2,8 @@
 
 #include <io/tcp_acceptor.h>
 
+#include <pthread.h>
+
 #if IO_OS_POSIX
 
 static void
@@ -10,6 +12,87 @@ accept_callback(void* user, io_Err err)
     *((io_Err*)user) = err;
 }
 
+static int pending_connections = 0;
+static int accept4_flags = 0;
+
+static int
+accept4_stub_backlog(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags)
+{
+    (void)sockfd;
+    (void)addr;
+    (void)addrlen;
+    accept4_flags = flags;
+    if (pending_connections == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    pending_connections--;
+    return 100 + pending_connections;
+}
+
+static int reuse_port_count = 0;
+static int nodelay_count = 0;
+
+static int
+setsockopt_stub_record(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+    (void)sockfd;
+    (void)optval;
+    (void)optlen;
+    if (level == SOL_SOCKET && optname == SO_REUSEPORT) {
+        reuse_port_count++;
+    }
+    if (level == IPPROTO_TCP && optname == TCP_NODELAY) {
+        nodelay_count++;
+    }
+    return 0;
+}
+
+typedef struct batch_result {
+    io_Err err;
+    size_t count;
+    int calls;
+} batch_result;
+
+static void
+accept_batch_callback(void* user, const int* fds, size_t count, io_Err err)
+{
+    (void)fds;
+    batch_result* result = user;
+    result->err = err;
+    result->count = count;
+    result->calls++;
+}
+
+typedef struct multishot_result {
+    io_TcpAcceptor* acceptor;
+    io_Err err;
+    size_t total;
+    int batches;
+    int finals;
+    pthread_t loop_thread;
+    int on_loop; // Batches delivered on loop_thread
+} multishot_result;
+
+static void
+accept_multishot_callback(void* user, const int* fds, size_t count, io_Err err)
+{
+    multishot_result* result = user;
+    if (!fds) {
+        result->err = err;
+        result->finals++;
+        return;
+    }
+    result->total += count;
+    result->batches++;
+    if (pthread_equal(pthread_self(), result->loop_thread)) {
+        result->on_loop++;
+    }
+    if (result->total == 5) {
+        io_TcpAcceptor_cancel(result->acceptor);
+    }
+}
+
 IO_TEST_BEGIN(tcp_acceptor)
 {
     IO_TEST_CASE_BEGIN(tcp_acceptor_init_ip4)
@@ -105,6 +188,194 @@ IO_TEST_BEGIN(tcp_acceptor)
         io_Context_deinit(&ctx);
     }
     IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_accept_cloexec)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.accept4 = accept4_stub_backlog;
+        pending_connections = 1;
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        IO_CHECK(io_TcpAcceptor_accept(&acceptor, &socket) == IO_ERR_OK);
+        IO_CHECK(accept4_flags == IO_SOCK_CLOEXEC);
+        io_TcpAcceptor_deinit(&acceptor);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_async_accept_batch)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.accept4 = accept4_stub_backlog;
+        pending_connections = 3;
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        batch_result result = {0};
+        IO_CHECK(io_TcpAcceptor_async_accept_batch(&acceptor, 8, accept_batch_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == IO_ERR_OK);
+        IO_CHECK(result.count == 3);
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_async_accept_batch_max)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.accept4 = accept4_stub_backlog;
+        pending_connections = 5;
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        batch_result result = {0};
+        IO_CHECK(io_TcpAcceptor_async_accept_batch(&acceptor, 2, accept_batch_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.count == 2);
+        IO_CHECK(pending_connections == 3);
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_async_accept_multishot)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.accept4 = accept4_stub_backlog;
+        pending_connections = 5;
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        multishot_result result = {.acceptor = &acceptor};
+        IO_CHECK(io_TcpAcceptor_async_accept_multishot(&acceptor, 2, accept_multishot_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        // One submission, re-armed on every readiness event until cancelled
+        IO_CHECK(result.total == 5);
+        IO_CHECK(result.batches == 3);
+        IO_CHECK(result.finals == 1);
+        IO_CHECK(result.err == io_SystemErr(IO_ECANCELED));
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_async_accept_multishot_workers)
+    {
+        io_Context ctx;
+        IO_CHECK(io_Context_init_with_workers(&ctx, test_allocator(), 2) == IO_ERR_OK);
+        io_mock_system_call.accept4 = accept4_stub_backlog;
+        pending_connections = 5;
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        multishot_result result = {.acceptor = &acceptor, .loop_thread = pthread_self()};
+        IO_CHECK(io_TcpAcceptor_async_accept_multishot(&acceptor, 2, accept_multishot_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        // The loop accepts, the workers deliver, the cancel from the last batch ends the op
+        IO_CHECK(result.total == 5);
+        IO_CHECK(result.batches == 3);
+        IO_CHECK(result.on_loop == 0);
+        IO_CHECK(result.finals == 1);
+        IO_CHECK(result.err == io_SystemErr(IO_ECANCELED));
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_init_sharded)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        IO_CHECK(io_Context_set_num_threads(&ctx, 2) == IO_ERR_OK);
+        io_mock_system_call.setsockopt = setsockopt_stub_record;
+        reuse_port_count = 0;
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init_sharded(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        IO_CHECK(io_TcpAcceptor_num_shards(&acceptor) == 3);
+        IO_CHECK(reuse_port_count == 3);
+        IO_CHECK(io_TcpAcceptor_get_loop(io_TcpAcceptor_shard(&acceptor, 0)) == ctx.loop);
+        for (size_t i = 1; i < 3; ++i) {
+            IO_CHECK(io_TcpAcceptor_get_loop(io_TcpAcceptor_shard(&acceptor, i)) == *io_LoopVec_at(&ctx.threadLoops, i - 1));
+        }
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_init_sharded_reuseport_fail)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        IO_CHECK(io_Context_set_num_threads(&ctx, 2) == IO_ERR_OK);
+        io_mock_system_call.setsockopt = setsockopt_stub_enoprotoopt;
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init_sharded(&acceptor, &ctx, "0.0.0.0:8080") == io_SystemErr(ENOPROTOOPT));
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_sharded_accept_stays_on_loop)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        IO_CHECK(io_Context_set_num_threads(&ctx, 2) == IO_ERR_OK);
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init_sharded(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        for (size_t i = 0; i < io_TcpAcceptor_num_shards(&acceptor); ++i) {
+            io_TcpAcceptor* shard = io_TcpAcceptor_shard(&acceptor, i);
+            io_TcpSocket socket;
+            io_TcpSocket_init(&socket, &ctx, NULL);
+            IO_CHECK(io_TcpAcceptor_accept(shard, &socket) == IO_ERR_OK);
+            IO_CHECK(io_TcpSocket_get_loop(&socket) == io_TcpAcceptor_get_loop(shard));
+            io_TcpSocket_deinit(&socket);
+        }
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_accept_options)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.setsockopt = setsockopt_stub_record;
+        io_mock_system_call.accept4 = accept4_stub_backlog;
+        pending_connections = 3;
+        nodelay_count = 0;
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        io_SocketOptions options;
+        io_SocketOptions_init(&options);
+        io_SocketOptions_set_tcp_nodelay(&options, true);
+        io_TcpAcceptor_set_accept_options(&acceptor, &options);
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        IO_CHECK(io_TcpAcceptor_accept(&acceptor, &socket) == IO_ERR_OK);
+        IO_CHECK(nodelay_count == 1);
+        batch_result result = {0};
+        IO_CHECK(io_TcpAcceptor_async_accept_batch(&acceptor, 8, accept_batch_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.count == 2);
+        IO_CHECK(nodelay_count == 3);
+        io_TcpAcceptor_deinit(&acceptor);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_acceptor_set_options)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_TcpAcceptor acceptor;
+        IO_CHECK(io_TcpAcceptor_init(&acceptor, &ctx, "0.0.0.0:8080") == IO_ERR_OK);
+        io_SocketOptions options;
+        io_SocketOptions_init(&options);
+        io_SocketOptions_set_defer_accept(&options, 1);
+        io_SocketOptions_set_fastopen(&options, 256);
+        IO_CHECK(io_TcpAcceptor_set_options(&acceptor, &options) == IO_ERR_OK);
+        io_mock_system_call.setsockopt = setsockopt_stub_enoprotoopt;
+        IO_CHECK(io_TcpAcceptor_set_options(&acceptor, &options) == io_SystemErr(ENOPROTOOPT));
+        io_TcpAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
 }
 IO_TEST_END
 
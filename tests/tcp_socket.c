@@ -9,6 +9,103 @@
 //     *((io_Err*)user) = err;
 // }
 
+static int gai_calls = 0;
+
+static int
+getaddrinfo_stub_counting(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+    io_atomic_inc(&gai_calls);
+    return getaddrinfo_stub_success(node, service, hints, res);
+}
+
+typedef struct sockopt_record {
+    int level;
+    int name;
+    int value;
+} sockopt_record;
+
+static sockopt_record sockopts[8];
+static size_t num_sockopts = 0;
+
+static int
+setsockopt_stub_record(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+    (void)sockfd;
+    (void)optlen;
+    if (num_sockopts < sizeof(sockopts) / sizeof(sockopts[0])) {
+        sockopts[num_sockopts++] = (sockopt_record){level, optname, *(const int*)optval};
+    }
+    return 0;
+}
+
+static int sendto_flags = 0;
+
+static ssize_t
+sendto_stub_record(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen)
+{
+    sendto_flags = flags;
+    return sendto_stub_success(sockfd, buf, len, flags, dest_addr, addrlen);
+}
+
+static void
+connect_callback(void* user, io_Err err)
+{
+    *((io_Err*)user) = err;
+}
+
+static int connects = 0;
+
+static int
+connect_stub_einprogress(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
+{
+    (void)sockfd;
+    (void)addr;
+    (void)addrlen;
+    connects++;
+    errno = EINPROGRESS;
+    return -1;
+}
+
+/* Nothing becomes ready, the pending connect keeps waiting */
+static int
+poll_stub_idle(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    (void)fds;
+    (void)nfds;
+    (void)timeout;
+    return 0;
+}
+
+static int refused_connects = 0;
+
+/* Refuses the first `refused_connects` handshakes */
+static int
+getsockopt_stub_refused(int sockfd, int level, int optname, void* optval, socklen_t* optlen)
+{
+    (void)sockfd;
+    (void)level;
+    (void)optname;
+    *(int*)optval = refused_connects > 0 ? ECONNREFUSED : 0;
+    *optlen = sizeof(int);
+    if (refused_connects > 0) {
+        refused_connects--;
+    }
+    return 0;
+}
+
+static int
+getaddrinfo_stub_two(const char* node, const char* service, const struct addrinfo* hints, struct addrinfo** res)
+{
+    (void)node;
+    (void)hints;
+    *res = make_stub_addrinfo("127.0.0.1", service);
+    if (*res && !((*res)->ai_next = make_stub_addrinfo("127.0.0.2", service))) {
+        freeaddrinfo_stub(*res);
+        return EAI_MEMORY;
+    }
+    return *res ? 0 : EAI_MEMORY;
+}
+
 IO_TEST_BEGIN(tcp_socket)
 {
     IO_TEST_CASE_BEGIN(tcp_socket_init)
@@ -43,5 +140,206 @@ IO_TEST_BEGIN(tcp_socket)
         io_Context_deinit(&ctx);
     }
     IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_init_resolve_fail)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = getaddrinfo_stub_noname;
+        io_TcpSocket socket;
+        IO_CHECK(io_TcpSocket_init(&socket, &ctx, "localhost:8080") == io_GaiErr(EAI_NONAME));
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_connect_cached)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = getaddrinfo_stub_counting;
+        gai_calls = 0;
+        io_TcpSocket first;
+        io_TcpSocket second;
+        IO_CHECK(io_TcpSocket_init(&first, &ctx, "localhost:8080") == IO_ERR_OK);
+        IO_CHECK(io_TcpSocket_init(&second, &ctx, "localhost:8080") == IO_ERR_OK);
+        IO_CHECK(gai_calls == 1);
+        io_TcpSocket_deinit(&first);
+        io_TcpSocket_deinit(&second);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_async_connect)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        io_Err result = io_SystemErr(IO_EINVAL);
+        IO_CHECK(io_TcpSocket_async_connect(&socket, "localhost:8080", connect_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result == IO_ERR_OK);
+        IO_CHECK(io_TcpSocket_get_fd(&socket) != -1);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_async_connect_in_progress)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.connect = connect_stub_einprogress;
+        connects = 0;
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        io_Err result = io_SystemErr(IO_EINVAL);
+        IO_CHECK(io_TcpSocket_async_connect(&socket, "localhost:8080", connect_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        // The handshake finished once the socket became writable
+        IO_CHECK(result == IO_ERR_OK);
+        IO_CHECK(connects == 1);
+        IO_CHECK(io_TcpSocket_get_fd(&socket) != -1);
+        IO_CHECK(socket.base.base.non_blocking);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_async_connect_next_endpoint)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = getaddrinfo_stub_two;
+        io_mock_system_call.connect = connect_stub_einprogress;
+        io_mock_system_call.getsockopt = getsockopt_stub_refused;
+        connects = 0;
+        refused_connects = 1;
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        io_Err result = io_SystemErr(IO_EINVAL);
+        IO_CHECK(io_TcpSocket_async_connect(&socket, "localhost:8080", connect_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result == IO_ERR_OK);
+        IO_CHECK(connects == 2);
+        IO_CHECK(io_TcpSocket_get_fd(&socket) != -1);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_async_connect_refused)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.getaddrinfo = getaddrinfo_stub_two;
+        io_mock_system_call.connect = connect_stub_einprogress;
+        io_mock_system_call.getsockopt = getsockopt_stub_refused;
+        connects = 0;
+        refused_connects = 2;
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        io_Err result = IO_ERR_OK;
+        IO_CHECK(io_TcpSocket_async_connect(&socket, "localhost:8080", connect_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result == io_OtherErr(IO_OTHER_ERRC_NO_ENDPOINT));
+        IO_CHECK(connects == 2);
+        IO_CHECK(io_TcpSocket_get_fd(&socket) == -1);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_async_connect_cancel)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        io_Err result = IO_ERR_OK;
+        io_OpToken token;
+        IO_CHECK(io_TcpSocket_async_connect_with_token(&socket, "localhost:8080", connect_callback, &result, &token) == IO_ERR_OK);
+        // Still resolving, the connect stops once the name is resolved
+        IO_CHECK(!io_Op_cancel(&token));
+        io_Context_run(&ctx);
+        IO_CHECK(result == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(io_TcpSocket_get_fd(&socket) == -1);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_async_connect_cancel_in_progress)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.connect = connect_stub_einprogress;
+        io_mock_system_call.poll = poll_stub_idle;
+        connects = 0;
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        io_Err result = IO_ERR_OK;
+        io_OpToken token;
+        IO_CHECK(io_TcpSocket_async_connect_with_token(&socket, "localhost:8080", connect_callback, &result, &token) == IO_ERR_OK);
+        while (connects == 0) {
+            io_Context_run_for(&ctx, io_Milliseconds(10));
+        }
+        // The token reached the wait for the handshake
+        IO_CHECK(io_Op_cancel(&token));
+        io_Context_run(&ctx);
+        IO_CHECK(result == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(io_TcpSocket_get_fd(&socket) == -1);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_set_options)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_TcpSocket socket;
+        IO_CHECK(io_TcpSocket_init(&socket, &ctx, "localhost:8080") == IO_ERR_OK);
+        io_mock_system_call.setsockopt = setsockopt_stub_record;
+        num_sockopts = 0;
+        io_SocketOptions options;
+        io_SocketOptions_init(&options);
+        io_SocketOptions_set_tcp_nodelay(&options, true);
+        io_SocketOptions_set_send_buffer(&options, 1 << 20);
+        IO_CHECK(io_TcpSocket_set_options(&socket, &options) == IO_ERR_OK);
+        IO_CHECK(num_sockopts == 2);
+        IO_CHECK(sockopts[0].level == IPPROTO_TCP && sockopts[0].name == TCP_NODELAY && sockopts[0].value == 1);
+        IO_CHECK(sockopts[1].level == SOL_SOCKET && sockopts[1].name == SO_SNDBUF && sockopts[1].value == 1 << 20);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_set_options_fail)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        io_SocketOptions options;
+        io_SocketOptions_init(&options);
+        io_SocketOptions_set_tcp_nodelay(&options, true);
+        IO_CHECK(io_TcpSocket_set_options(&socket, &options) == io_SystemErr(EBADF));
+        IO_CHECK(io_TcpSocket_init(&socket, &ctx, "localhost:8080") == IO_ERR_OK);
+        io_mock_system_call.setsockopt = setsockopt_stub_enoprotoopt;
+        IO_CHECK(io_TcpSocket_set_options(&socket, &options) == io_SystemErr(ENOPROTOOPT));
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(tcp_socket_connect_with_data)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.sendto = sendto_stub_record;
+        sendto_flags = 0;
+        io_TcpSocket socket;
+        io_TcpSocket_init(&socket, &ctx, NULL);
+        const char request[] = "GET / HTTP/1.1\r\n\r\n";
+        size_t size = sizeof(request) - 1;
+        IO_CHECK(io_TcpSocket_connect_with_data(&socket, "localhost:8080", request, &size) == IO_ERR_OK);
+        IO_CHECK(size == sizeof(request) - 1);
+        IO_CHECK(sendto_flags == MSG_FASTOPEN);
+        IO_CHECK(io_TcpSocket_get_fd(&socket) != -1);
+        io_TcpSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
 }
 IO_TEST_END
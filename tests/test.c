@@ -110,10 +110,23 @@ io_MockSystemCall io_mock_system_call = {
     .bind = bind_stub_success,
     .listen = listen_stub_success,
     .accept = accept_stub_success,
+    .accept4 = accept4_stub_success,
     .connect = connect_stub_success,
+    .setsockopt = setsockopt_stub_success,
+    .getsockopt = getsockopt_stub_success,
+    .sendto = sendto_stub_success,
     .pipe = pipe_stub_success,
+    .ioctl = ioctl_stub_einval,
     .fcntl = fcntl_stub_success,
     .poll = poll_stub_success,
+    .getaddrinfo = getaddrinfo_stub_success,
+    .freeaddrinfo = freeaddrinfo_stub,
+#if IO_HAVE_EPOLL
+    .epoll_create1 = epoll_create1_stub_success,
+    .epoll_ctl = epoll_ctl_stub_success,
+    .timerfd_create = timerfd_create_stub_success,
+    .timerfd_settime = timerfd_settime_stub_success,
+#endif
 };
 
 void reset_system_call_stubs(void)
@@ -125,8 +138,21 @@ void reset_system_call_stubs(void)
     io_mock_system_call.bind = bind_stub_success;
     io_mock_system_call.listen = listen_stub_success;
     io_mock_system_call.accept = accept_stub_success;
+    io_mock_system_call.accept4 = accept4_stub_success;
     io_mock_system_call.connect = connect_stub_success;
+    io_mock_system_call.setsockopt = setsockopt_stub_success;
+    io_mock_system_call.getsockopt = getsockopt_stub_success;
+    io_mock_system_call.sendto = sendto_stub_success;
     io_mock_system_call.pipe = pipe_stub_success;
+    io_mock_system_call.ioctl = ioctl_stub_einval;
     io_mock_system_call.fcntl = fcntl_stub_success;
     io_mock_system_call.poll = poll_stub_success;
+    io_mock_system_call.getaddrinfo = getaddrinfo_stub_success;
+    io_mock_system_call.freeaddrinfo = freeaddrinfo_stub;
+#if IO_HAVE_EPOLL
+    io_mock_system_call.epoll_create1 = epoll_create1_stub_success;
+    io_mock_system_call.epoll_ctl = epoll_ctl_stub_success;
+    io_mock_system_call.timerfd_create = timerfd_create_stub_success;
+    io_mock_system_call.timerfd_settime = timerfd_settime_stub_success;
+#endif
 }
@@ -10,6 +10,22 @@ accept_callback(void* user, io_Err err)
     *((io_Err*)user) = err;
 }
 
+static int accept4_flags = 0;
+
+static int
+accept4_stub_record(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags)
+{
+    accept4_flags = flags;
+    return accept4_stub_success(sockfd, addr, addrlen, flags);
+}
+
+static void
+accept_each_callback(void* user, int fd)
+{
+    (void)fd;
+    (*(int*)user)++;
+}
+
 IO_TEST_BEGIN(unix_acceptor)
 {
     IO_TEST_CASE_BEGIN(unix_acceptor_init)
@@ -86,6 +102,36 @@ IO_TEST_BEGIN(unix_acceptor)
         io_Context_deinit(&ctx);
     }
     IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_acceptor_accept_inherits_non_blocking)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_mock_system_call.accept4 = accept4_stub_record;
+        io_UnixAcceptor acceptor;
+        IO_CHECK(io_UnixAcceptor_init(&acceptor, &ctx, "/test") == IO_ERR_OK);
+        io_UnixSocket socket;
+        io_UnixSocket_init(&socket, &ctx, NULL);
+        IO_CHECK(io_UnixAcceptor_accept(&acceptor, &socket) == IO_ERR_OK);
+        IO_CHECK(accept4_flags == (IO_SOCK_NONBLOCK | IO_SOCK_CLOEXEC));
+        io_UnixAcceptor_deinit(&acceptor);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_acceptor_async_accept_each)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixAcceptor acceptor;
+        IO_CHECK(io_UnixAcceptor_init(&acceptor, &ctx, "/test") == IO_ERR_OK);
+        int accepted = 0;
+        IO_CHECK(io_UnixAcceptor_async_accept_each(&acceptor, 4, accept_each_callback, NULL, &accepted) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(accepted == 4);
+        io_UnixAcceptor_deinit(&acceptor);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
 }
 IO_TEST_END
 
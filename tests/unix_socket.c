@@ -2,6 +2,9 @@
 
 #include <io/unix_socket.h>
 
+#include <pthread.h>
+#include <string.h>
+
 #if IO_OS_POSIX
 
 static void
@@ -11,6 +14,197 @@ read_callback(void* user, size_t size, io_Err err)
     *((io_Err*)user) = err;
 }
 
+static int socket_reads = 0;
+static int watched_fd = -1;
+
+static ssize_t
+read_stub_counting(int fd, void* buf, size_t count)
+{
+    if (fd == watched_fd) {
+        socket_reads++;
+    }
+    return read_stub_success(fd, buf, count);
+}
+
+static int
+poll_stub_hup(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    (void)timeout;
+    for (nfds_t i = 1; i < nfds; ++i) {
+        fds[i].revents = POLLHUP;
+    }
+    fds[0].revents = 0;
+    return (int)nfds - 1;
+}
+
+static void
+wait_callback(void* user, io_Err err)
+{
+    *((io_Err*)user) = err;
+}
+
+static int eagain_reads = 0;
+
+static ssize_t
+read_stub_eagain_once(int fd, void* buf, size_t count)
+{
+    if (fd == watched_fd && eagain_reads == 0) {
+        eagain_reads++;
+        errno = EAGAIN;
+        return -1;
+    }
+    return read_stub_success(fd, buf, count);
+}
+
+typedef struct pooled_result {
+    io_Err err;
+    size_t size;
+    size_t used;
+} pooled_result;
+
+static io_BufferPool* test_pool = NULL;
+
+static void
+pooled_read_callback(void* user, io_Buffer* buffer, io_Err err)
+{
+    pooled_result* result = user;
+    result->err = err;
+    if (buffer) {
+        result->size = io_Buffer_size(buffer);
+        result->used = io_BufferPool_num_used(test_pool);
+        io_Buffer_release(buffer);
+    }
+}
+
+static ssize_t
+read_stub_eagain_watched(int fd, void* buf, size_t count)
+{
+    if (fd == watched_fd) {
+        socket_reads++;
+        errno = EAGAIN;
+        return -1;
+    }
+    return read_stub_success(fd, buf, count);
+}
+
+static int chunks_left = 0;
+
+static ssize_t
+read_stub_chunks(int fd, void* buf, size_t count)
+{
+    if (fd != watched_fd) {
+        return read_stub_success(fd, buf, count);
+    }
+    if (chunks_left == 0) {
+        return 0;
+    }
+    chunks_left--;
+    return (ssize_t)(count < 100 ? count : 100);
+}
+
+static int reads_in_flight = 0;
+static int overlapping_reads = 0;
+
+/* Like read_stub_chunks, but numbers the chunks and notes reads that overlap */
+static ssize_t
+read_stub_numbered_chunks(int fd, void* buf, size_t count)
+{
+    if (fd != watched_fd) {
+        return read_stub_success(fd, buf, count);
+    }
+    if (io_atomic_inc(&reads_in_flight) != 1) {
+        io_atomic_inc(&overlapping_reads);
+    }
+    ssize_t ret = 0;
+    if (chunks_left > 0) {
+        memcpy(buf, &chunks_left, sizeof(chunks_left));
+        chunks_left--;
+        ret = (ssize_t)(count < 100 ? count : 100);
+    }
+    for (volatile int spin = 0; spin < 10000; ++spin) {
+        // Leaves the other runners time to step in
+    }
+    io_atomic_dec(&reads_in_flight);
+    return ret;
+}
+
+typedef struct multishot_result {
+    io_Err err;
+    size_t total;
+    int chunks;
+    int finals;
+} multishot_result;
+
+static void
+multishot_read_callback(void* user, io_Buffer* buffer, io_Err err)
+{
+    multishot_result* result = user;
+    if (!buffer) {
+        result->err = err;
+        result->finals++;
+        return;
+    }
+    result->total += io_Buffer_size(buffer);
+    result->chunks++;
+    io_Buffer_release(buffer);
+}
+
+typedef struct ordered_result {
+    multishot_result base;
+    int next;
+    int out_of_order;
+    pthread_t loop_thread;
+    int on_loop; // Chunks delivered on loop_thread
+} ordered_result;
+
+static void
+ordered_read_callback(void* user, io_Buffer* buffer, io_Err err)
+{
+    ordered_result* result = user;
+    if (buffer) {
+        int chunk = 0;
+        memcpy(&chunk, io_Buffer_data(buffer), sizeof(chunk));
+        if (chunk != result->next) {
+            result->out_of_order++;
+        }
+        if (pthread_equal(pthread_self(), result->loop_thread)) {
+            result->on_loop++;
+        }
+        result->next = chunk - 1;
+    }
+    multishot_read_callback(&result->base, buffer, err);
+}
+
+static int alternate_reads = 0;
+
+/* Every other read of the watched fd would block, starting with the second */
+static ssize_t
+read_stub_eagain_alternating(int fd, void* buf, size_t count)
+{
+    if (fd == watched_fd && io_atomic_inc(&alternate_reads) % 2 == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return read_stub_success(fd, buf, count);
+}
+
+typedef struct chain_result {
+    io_Err err;
+    size_t completed;
+    size_t size;
+    int calls;
+} chain_result;
+
+static void
+chain_callback(void* user, size_t completed, size_t size, io_Err err)
+{
+    chain_result* result = user;
+    result->err = err;
+    result->completed = completed;
+    result->size = size;
+    result->calls++;
+}
+
 IO_TEST_BEGIN(unix_socket)
 {
     IO_TEST_CASE_BEGIN(unix_socket_init)
@@ -105,6 +299,446 @@ IO_TEST_BEGIN(unix_socket)
         io_Context_deinit(&ctx);
     }
     IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_wait)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        io_mock_system_call.read = read_stub_counting;
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        socket_reads = 0;
+        io_Err readable = IO_ERR_UNKNOWN;
+        io_Err writable = IO_ERR_UNKNOWN;
+        IO_CHECK(io_UnixSocket_async_wait(&socket, IO_OP_READ, wait_callback, &readable) == IO_ERR_OK);
+        IO_CHECK(io_UnixSocket_async_wait(&socket, IO_OP_WRITE, wait_callback, &writable) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(readable == IO_ERR_OK);
+        IO_CHECK(writable == IO_ERR_OK);
+        IO_CHECK(socket_reads == 0);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_wait_then_read)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        io_mock_system_call.read = read_stub_counting;
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        socket_reads = 0;
+        // Waits don't count as speculation misses
+        for (int i = 0; i < IO_POLL_TRYIO_MISS_LIMIT + 1; ++i) {
+            io_Err readable = IO_ERR_UNKNOWN;
+            IO_CHECK(io_UnixSocket_async_wait(&socket, IO_OP_READ, wait_callback, &readable) == IO_ERR_OK);
+            io_Context_run(&ctx);
+            IO_CHECK(readable == IO_ERR_OK);
+        }
+        io_TryIoStats stats = io_Context_tryio_stats(&ctx);
+        IO_CHECK(stats.attempts == 0 && stats.skipped == 0);
+        char buf[16];
+        io_Err err = io_SystemErr(IO_EIO);
+        IO_CHECK(io_UnixSocket_async_read(&socket, buf, sizeof(buf), read_callback, &err) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(err == IO_ERR_OK);
+        IO_CHECK(socket_reads == 1);
+        stats = io_Context_tryio_stats(&ctx);
+        IO_CHECK(stats.attempts == 1 && stats.hits == 1);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_wait_hup)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        io_mock_system_call.poll = poll_stub_hup;
+        io_Err err = IO_ERR_OK;
+        IO_CHECK(io_UnixSocket_async_wait(&socket, IO_OP_READ, wait_callback, &err) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(err == IO_ERR_EOF);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_wait_no_fd)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        io_UnixSocket_init(&socket, &ctx, NULL);
+        io_Err err = IO_ERR_OK;
+        IO_CHECK(io_UnixSocket_async_wait(&socket, IO_OP_READ, wait_callback, &err) == io_SystemErr(EBADF));
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_read_pooled)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_Context_set_buffer_pool(&ctx, 512, 0, 4);
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        test_pool = io_Loop_buffer_pool(io_UnixSocket_get_loop(&socket));
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        eagain_reads = 0;
+        io_mock_system_call.read = read_stub_eagain_once;
+        pooled_result result = {0};
+        IO_CHECK(io_UnixSocket_async_read_pooled(&socket, pooled_read_callback, &result) == IO_ERR_OK);
+        // The speculative read would block, no buffer is held while waiting
+        IO_CHECK(eagain_reads == 1);
+        IO_CHECK(io_BufferPool_num_used(test_pool) == 0);
+        io_Context_run(&ctx);
+        IO_CHECK(result.err == IO_ERR_OK);
+        IO_CHECK(result.size == 512);
+        IO_CHECK(result.used == 1);
+        IO_CHECK(io_BufferPool_num_used(test_pool) == 0);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_read_pooled_exhausted)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_Context_set_buffer_pool(&ctx, 512, 1, 4);
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        io_Buffer* held = io_BufferPool_acquire(io_Loop_buffer_pool(io_UnixSocket_get_loop(&socket)));
+        IO_CHECK(held != NULL);
+        pooled_result result = {0};
+        IO_CHECK(io_UnixSocket_async_read_pooled(&socket, pooled_read_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.err == io_SystemErr(IO_ENOMEM));
+        io_Buffer_release(held);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_read_adaptive)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_Context_set_buffer_pool(&ctx, 1024, 0, 4);
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        io_UnixSocket_set_adaptive_read(&socket, 64, 512, 4096, false);
+        test_pool = io_Loop_buffer_pool(io_UnixSocket_get_loop(&socket));
+        // Every read fills the buffer, so the size keeps doubling up to the max
+        size_t expected[] = {512, 1024, 2048, 4096, 4096};
+        for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+            pooled_result result = {0};
+            IO_CHECK(io_UnixSocket_async_read_adaptive(&socket, pooled_read_callback, &result) == IO_ERR_OK);
+            io_Context_run(&ctx);
+            IO_CHECK(result.err == IO_ERR_OK);
+            IO_CHECK(result.size == expected[i]);
+            // Reads beyond the pool's buffer size don't use the pool
+            IO_CHECK(result.used == (expected[i] <= 1024 ? 1u : 0u));
+        }
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_read_multishot)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        test_pool = io_Loop_buffer_pool(io_UnixSocket_get_loop(&socket));
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        io_mock_system_call.read = read_stub_chunks;
+        chunks_left = 3;
+        multishot_result result = {0};
+        IO_CHECK(io_UnixSocket_async_read_multishot(&socket, false, multishot_read_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+            IO_CHECK(result.chunks == 3);
+        IO_CHECK(result.total == 300);
+        IO_CHECK(result.finals == 1);
+        IO_CHECK(result.err == IO_ERR_EOF);
+        IO_CHECK(io_BufferPool_num_used(test_pool) == 0);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_read_multishot_followers)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_Context_set_num_followers(&ctx, 3);
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        test_pool = io_Loop_buffer_pool(io_UnixSocket_get_loop(&socket));
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        io_mock_system_call.read = read_stub_numbered_chunks;
+        chunks_left = 50;
+        overlapping_reads = 0;
+        ordered_result result = {.next = 50};
+        IO_CHECK(io_UnixSocket_async_read_multishot(&socket, false, ordered_read_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        // The reactor keeps reporting readiness, yet one runner reads at a time
+        IO_CHECK(overlapping_reads == 0);
+        IO_CHECK(result.out_of_order == 0);
+        IO_CHECK(result.base.chunks == 50);
+        IO_CHECK(result.base.finals == 1);
+        IO_CHECK(result.base.err == IO_ERR_EOF);
+        IO_CHECK(io_BufferPool_num_used(test_pool) == 0);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_read_multishot_workers)
+    {
+        io_Context ctx;
+        IO_CHECK(io_Context_init_with_workers(&ctx, test_allocator(), 2) == IO_ERR_OK);
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        test_pool = io_Loop_buffer_pool(io_UnixSocket_get_loop(&socket));
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        io_mock_system_call.read = read_stub_numbered_chunks;
+        chunks_left = 20;
+        overlapping_reads = 0;
+        ordered_result result = {.next = 20, .loop_thread = pthread_self()};
+        IO_CHECK(io_UnixSocket_async_read_multishot(&socket, false, ordered_read_callback, &result) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        // The loop reads, the workers deliver, still one chunk at a time and in order
+        IO_CHECK(result.on_loop == 0);
+        IO_CHECK(overlapping_reads == 0);
+        IO_CHECK(result.out_of_order == 0);
+        IO_CHECK(result.base.chunks == 20);
+        IO_CHECK(result.base.finals == 1);
+        IO_CHECK(result.base.err == IO_ERR_EOF);
+        IO_CHECK(io_BufferPool_num_used(test_pool) == 0);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_cancel_op)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        io_mock_system_call.read = read_stub_eagain_watched;
+        char buf[16];
+        io_Err read_err = IO_ERR_OK;
+        io_Err write_err = io_SystemErr(IO_EIO);
+        io_OpToken read_token;
+        io_OpToken write_token;
+        IO_CHECK(io_UnixSocket_async_read_with_token(&socket, buf, sizeof(buf), read_callback, &read_err, &read_token) == IO_ERR_OK);
+        IO_CHECK(io_UnixSocket_async_write_with_token(&socket, buf, sizeof(buf), read_callback, &write_err, &write_token) == IO_ERR_OK);
+        IO_CHECK(read_token.seq != write_token.seq);
+        io_Poll* poll = (io_Poll*)io_UnixSocket_get_loop(&socket)->reactor;
+        IO_CHECK(io_PollFdVec_size(&poll->fds.fds) == 2);
+        // Only the read is cancelled, the write completes as usual
+        IO_CHECK(io_Op_cancel(&read_token));
+        IO_CHECK(!io_Op_cancel(&read_token));
+        // Its pollfd entry is gone right away
+        IO_CHECK(io_PollFdVec_size(&poll->fds.fds) == 1);
+        io_Context_run(&ctx);
+        IO_CHECK(read_err == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(write_err == IO_ERR_OK);
+        // Tokens of completed ops are harmless
+        IO_CHECK(!io_Op_cancel(&write_token));
+        io_UnixSocket_deinit(&socket);
+        IO_CHECK(!io_Op_cancel(&read_token));
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_chain)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        eagain_reads = 0;
+        io_mock_system_call.read = read_stub_eagain_once;
+        char request[32];
+        char response[16] = {0};
+        chain_result result = {0};
+        io_OpChain* chain = io_UnixSocket_create_chain(&socket, chain_callback, &result);
+        IO_CHECK(chain != NULL);
+        IO_CHECK(io_OpChain_write(chain, response, sizeof(response)) == IO_ERR_OK);
+        IO_CHECK(io_OpChain_read(chain, request, sizeof(request)) == IO_ERR_OK);
+        IO_CHECK(io_OpChain_wait(chain, IO_OP_WRITE) == IO_ERR_OK);
+        IO_CHECK(io_OpChain_write(chain, response, sizeof(response)) == IO_ERR_OK);
+        IO_CHECK(io_UnixSocket_async_chain(&socket, chain) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        // The read blocked once, the chain resumed without a user callback in between
+        IO_CHECK(eagain_reads == 1);
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == IO_ERR_OK);
+        IO_CHECK(result.completed == 4);
+        IO_CHECK(result.size == sizeof(response));
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_cancel_chain)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        io_mock_system_call.read = read_stub_eagain_watched;
+        char request[32];
+        char response[16] = {0};
+        chain_result result = {0};
+        io_OpChain* chain = io_UnixSocket_create_chain(&socket, chain_callback, &result);
+        IO_CHECK(chain != NULL);
+        IO_CHECK(io_OpChain_write(chain, response, sizeof(response)) == IO_ERR_OK);
+        IO_CHECK(io_OpChain_read(chain, request, sizeof(request)) == IO_ERR_OK);
+        io_OpToken token;
+        IO_CHECK(io_UnixSocket_async_chain_with_token(&socket, chain, &token) == IO_ERR_OK);
+        // The token was taken for the write, the chain now waits in the read slot
+        IO_CHECK(token.type == IO_OP_WRITE);
+        IO_CHECK(io_Op_cancel(&token));
+        IO_CHECK(!io_Op_cancel(&token));
+        io_Context_run(&ctx);
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == io_SystemErr(IO_ECANCELED));
+        IO_CHECK(result.completed == 1);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+        reset_system_call_stubs();
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_chain_followers)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_Context_set_num_followers(&ctx, 3);
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        alternate_reads = 0;
+        io_mock_system_call.read = read_stub_eagain_alternating;
+        char request[16];
+        chain_result result = {0};
+        io_OpChain* chain = io_UnixSocket_create_chain(&socket, chain_callback, &result);
+        IO_CHECK(chain != NULL);
+        for (int i = 0; i < 20; ++i) {
+            IO_CHECK(io_OpChain_read(chain, request, sizeof(request)) == IO_ERR_OK);
+        }
+        IO_CHECK(io_UnixSocket_async_chain(&socket, chain) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        // Each step blocked once, whichever runner picked the chain up carried on
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == IO_ERR_OK);
+        IO_CHECK(result.completed == 20);
+        IO_CHECK(alternate_reads == 39);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_chain_keeps_tryio)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        alternate_reads = 0;
+        io_mock_system_call.read = read_stub_eagain_alternating;
+        char request[16];
+        chain_result result = {0};
+        io_OpChain* chain = io_UnixSocket_create_chain(&socket, chain_callback, &result);
+        IO_CHECK(chain != NULL);
+        for (int i = 0; i < 4; ++i) {
+            IO_CHECK(io_OpChain_read(chain, request, sizeof(request)) == IO_ERR_OK);
+        }
+        IO_CHECK(io_UnixSocket_async_chain(&socket, chain) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(result.completed == 4);
+        // Only the first submit tried, the rearms didn't count as misses
+        io_TryIoStats stats = io_Context_tryio_stats(&ctx);
+        IO_CHECK(stats.attempts == 1);
+        IO_CHECK(stats.hits == 0);
+        // So plain reads on the descriptor are still tried
+        io_mock_system_call.read = read_stub_success;
+        io_Err err = io_SystemErr(IO_EIO);
+        IO_CHECK(io_UnixSocket_async_read(&socket, request, sizeof(request), read_callback, &err) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        IO_CHECK(err == IO_ERR_OK);
+        stats = io_Context_tryio_stats(&ctx);
+        IO_CHECK(stats.attempts == 2);
+        IO_CHECK(stats.hits == 1);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_async_chain_short_read)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        chunks_left = 1;
+        io_mock_system_call.read = read_stub_chunks;
+        char request[512];
+        chain_result result = {0};
+        io_OpChain* chain = io_UnixSocket_create_chain(&socket, chain_callback, &result);
+        IO_CHECK(chain != NULL);
+        IO_CHECK(io_OpChain_read(chain, request, sizeof(request)) == IO_ERR_OK);
+        IO_CHECK(io_OpChain_write(chain, request, sizeof(request)) == IO_ERR_OK);
+        IO_CHECK(io_UnixSocket_async_chain(&socket, chain) == IO_ERR_OK);
+        io_Context_run(&ctx);
+        // A short read hands control back before the write
+        IO_CHECK(result.calls == 1);
+        IO_CHECK(result.err == IO_ERR_OK);
+        IO_CHECK(result.completed == 1);
+        IO_CHECK(result.size == 100);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
+    IO_TEST_CASE_BEGIN(unix_socket_tryio_backoff)
+    {
+        io_Context ctx;
+        io_Context_init(&ctx, test_allocator());
+        io_UnixSocket socket;
+        IO_CHECK(io_UnixSocket_init(&socket, &ctx, "/test") == IO_ERR_OK);
+        watched_fd = io_UnixSocket_get_fd(&socket);
+        socket_reads = 0;
+        io_mock_system_call.read = read_stub_eagain_watched;
+        char buf[16];
+        // An idle socket: two misses switch speculation off, then only
+        // every IO_POLL_TRYIO_PROBE_INTERVAL-th submit tries the read
+        for (int i = 0; i < 2 + IO_POLL_TRYIO_PROBE_INTERVAL; ++i) {
+            io_Err err = IO_ERR_OK;
+            IO_CHECK(io_UnixSocket_async_read(&socket, buf, sizeof(buf), read_callback, &err) == IO_ERR_OK);
+            io_UnixSocket_cancel(&socket);
+            io_Context_run(&ctx);
+            IO_CHECK(err == io_SystemErr(IO_ECANCELED));
+        }
+        IO_CHECK(socket_reads == 3);
+        io_TryIoStats stats = io_Context_tryio_stats(&ctx);
+        IO_CHECK(stats.attempts == 3);
+        IO_CHECK(stats.hits == 0);
+        IO_CHECK(stats.skipped == IO_POLL_TRYIO_PROBE_INTERVAL - 1);
+        // A successful probe turns speculation back on
+        io_mock_system_call.read = read_stub_success;
+        for (int i = 0; i < IO_POLL_TRYIO_PROBE_INTERVAL + 2; ++i) {
+            io_Err err = io_SystemErr(IO_EIO);
+            IO_CHECK(io_UnixSocket_async_read(&socket, buf, sizeof(buf), read_callback, &err) == IO_ERR_OK);
+            io_Context_run(&ctx);
+            IO_CHECK(err == IO_ERR_OK);
+        }
+        stats = io_Context_tryio_stats(&ctx);
+        IO_CHECK(stats.hits >= 2);
+        io_UnixSocket_deinit(&socket);
+        io_Context_deinit(&ctx);
+    }
+    IO_TEST_CASE_END
 }
 IO_TEST_END
 